@@ -0,0 +1,201 @@
+#include "include/actorbroadphase.h"
+#include <stdio.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+ActorBroadphase::ActorBroadphase(Uint16 rows, Uint16 cols, Uint32 cMaxEntities, Uint32 cMaxPairs) :
+    _cRows(rows),
+    _cCols(cols),
+    _cMaxEntities(cMaxEntities),
+    _cMaxPairs(cMaxPairs),
+    _cEntities(0),
+    _cSorted(0),
+    _reach(1),
+    _fBucketed(false),
+    _cPairs(0),
+    _cDroppedPairs(0)
+{
+    Uint32 cCells = _cRows * _cCols;
+    _pCellStart = new Uint32[cCells + 1] { };
+    _pCellFill = new Uint32[cCells];
+    _pCellEntities = new Uint32[_cMaxEntities];
+    _pEntityCell = new Uint32[_cMaxEntities];
+    _pBoxes = new ActorBox[_cMaxEntities];
+    _pPairs = new ActorPair[_cMaxPairs];
+}
+
+ActorBroadphase::~ActorBroadphase()
+{
+    delete[] _pPairs;
+    delete[] _pBoxes;
+    delete[] _pEntityCell;
+    delete[] _pCellEntities;
+    delete[] _pCellFill;
+    delete[] _pCellStart;
+}
+
+void ActorBroadphase::Build(EntityStore *pEntityStore, TiledMap *pTiledMap)
+{
+    _cEntities = pEntityStore->Count();
+    SDL_assert(_cEntities <= _cMaxEntities);
+
+    const Fixed *pX = pEntityStore->X();
+    const Fixed *pY = pEntityStore->Y();
+    const Sint16 *pFrameOffsetX = pEntityStore->FrameOffsetsX();
+    const Sint16 *pFrameOffsetY = pEntityStore->FrameOffsetsY();
+    const Uint16 *pSheetIds = pEntityStore->SheetIds();
+    const SDL_bool *pVisible = pEntityStore->Visible();
+    SDL_Rect mapBounds = pTiledMap->GetMapBounds();
+    Uint16 tileShift = pTiledMap->TileShift();
+    Uint32 cCells = _cRows * _cCols;
+
+    _cSorted = 0;
+    int maxExtent = 1;
+    for (Uint32 i = 0; i < _cEntities; i++)
+    {
+        if (pVisible[i] != SDL_TRUE)
+        {
+            _pEntityCell[i] = c_noCell;
+            continue;
+        }
+
+        const SpriteSheet &sheet = pEntityStore->Sheet(pSheetIds[i]);
+        ActorBox &box = _pBoxes[i];
+        box.left = FixedToInt(pX[i]) + pFrameOffsetX[i];
+        box.top = FixedToInt(pY[i]) + pFrameOffsetY[i];
+        box.right = box.left + sheet.cxFrame;
+        box.bottom = box.top + sheet.cyFrame;
+        maxExtent = SDL_max(maxExtent, SDL_max(static_cast<int>(sheet.cxFrame), static_cast<int>(sheet.cyFrame)));
+
+        // The cell TiledMap::GetTileRowCol works out for the center, done here so it can be clamped instead of
+        // failing off the map.  Clamping only ever brings two cells closer, so nothing that overlaps is missed
+        int row = (box.top + (sheet.cyFrame / 2) - mapBounds.y) >> tileShift;
+        int col = (box.left + (sheet.cxFrame / 2) - mapBounds.x) >> tileShift;
+        row = SDL_max(0, SDL_min(row, _cRows - 1));
+        col = SDL_max(0, SDL_min(col, _cCols - 1));
+        _pEntityCell[i] = (row * _cCols) + col;
+        _cSorted++;
+    }
+
+    // Two frames that overlap have centers less than the largest frame apart, this many cells at most
+    _reach = static_cast<Uint16>(((maxExtent - 1) >> tileShift) + 1);
+
+    _fBucketed = (_cSorted >= c_minBucketedEntities);
+    if (!_fBucketed)
+    {
+        Uint32 cVisible = 0;
+        for (Uint32 i = 0; i < _cEntities; i++)
+        {
+            if (_pEntityCell[i] != c_noCell)
+            {
+                _pCellEntities[cVisible++] = i;
+            }
+        }
+        return;
+    }
+
+    // Count the entities in each cell (shifted up one, so the running sum leaves each cell's start)
+    SDL_memset(_pCellStart, 0, (cCells + 1) * sizeof(Uint32));
+    for (Uint32 i = 0; i < _cEntities; i++)
+    {
+        if (_pEntityCell[i] != c_noCell)
+        {
+            _pCellStart[_pEntityCell[i] + 1]++;
+        }
+    }
+    for (Uint32 cell = 0; cell < cCells; cell++)
+    {
+        _pCellStart[cell + 1] += _pCellStart[cell];
+    }
+
+    // Entities go in index order, so each cell's list is sorted too
+    SDL_memcpy(_pCellFill, _pCellStart, cCells * sizeof(Uint32));
+    for (Uint32 i = 0; i < _cEntities; i++)
+    {
+        if (_pEntityCell[i] != c_noCell)
+        {
+            _pCellEntities[_pCellFill[_pEntityCell[i]]++] = i;
+        }
+    }
+}
+
+Uint32 ActorBroadphase::FindCandidatePairs()
+{
+    return FindPairs(false);
+}
+
+Uint32 ActorBroadphase::FindContacts()
+{
+    return FindPairs(true);
+}
+
+Uint32 ActorBroadphase::FindPairs(bool fContactsOnly)
+{
+    // Everything the inner loops touch is in locals, a store into the pairs could otherwise be any of the members and
+    // they'd all be read again for every pair
+    const Uint32 *pCellEntities = _pCellEntities;
+    const Uint32 *pCellStart = _pCellStart;
+    ActorPair *pPairs = _pPairs;
+    Uint32 cMaxPairs = _cMaxPairs;
+    Uint32 cPairs = 0;
+    Uint32 cDroppedPairs = 0;
+    auto AddPair = [&](Uint32 first, Uint32 second)
+    {
+        if (fContactsOnly && !Overlaps(first, second))
+        {
+            return;
+        }
+        if (cPairs == cMaxPairs)
+        {
+            cDroppedPairs++;
+            return;
+        }
+        pPairs[cPairs++] = { SDL_min(first, second), SDL_max(first, second) };
+    };
+
+    if (!_fBucketed)
+    {
+        for (Uint32 first = 0; first < _cSorted; first++)
+        {
+            for (Uint32 second = first + 1; second < _cSorted; second++)
+            {
+                AddPair(pCellEntities[first], pCellEntities[second]);
+            }
+        }
+    }
+
+    // Each entity is paired with the ones after it in its own cell and everything in the cells ahead of it (the
+    // rest of its row within reach, then the rows below), so every pair of cells is looked at once
+    int cRows = _cRows;
+    int cCols = _cCols;
+    int reach = _reach;
+    for (Uint32 sorted = 0; _fBucketed && (sorted < _cSorted); sorted++)
+    {
+        Uint32 entity = pCellEntities[sorted];
+        Uint32 cell = _pEntityCell[entity];
+        int row = cell / cCols;
+        int col = cell % cCols;
+        int colFirst = SDL_max(col - reach, 0);
+        int colLast = SDL_min(col + reach, cCols - 1);
+        int rowLast = SDL_min(row + reach, cRows - 1);
+
+        for (int r = row; r <= rowLast; r++)
+        {
+            // Cells next to each other in a row are next to each other in the sorted list, one range per row
+            Uint32 first = (r == row) ? (sorted + 1) : pCellStart[(r * cCols) + colFirst];
+            Uint32 last = pCellStart[(r * cCols) + colLast + 1];
+            for (Uint32 other = first; other < last; other++)
+            {
+                AddPair(entity, pCellEntities[other]);
+            }
+        }
+    }
+
+    _cPairs = cPairs;
+    _cDroppedPairs = cDroppedPairs;
+    if (_cDroppedPairs > 0)
+    {
+        printf("ActorBroadphase::FindPairs() : more than %u pairs, %u dropped\n", _cMaxPairs, _cDroppedPairs);
+    }
+    return _cPairs;
+}
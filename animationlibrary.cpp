@@ -0,0 +1,60 @@
+#include "include/animationlibrary.h"
+#include <stdio.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+AnimationLibrary::AnimationLibrary(Uint16 cMaxClips, Uint32 cMaxFrames) :
+    _pClips(nullptr),
+    _cClips(0),
+    _cMaxClips(cMaxClips),
+    _pFrames(nullptr),
+    _cFrames(0),
+    _cMaxFrames(cMaxFrames)
+{
+    // c_noClip can't be a real id
+    SDL_assert(cMaxClips < c_noClip);
+    _pClips = new AnimationClip[_cMaxClips];
+    _pFrames = new Uint16[_cMaxFrames];
+}
+
+AnimationLibrary::~AnimationLibrary()
+{
+    delete[] _pFrames;
+    delete[] _pClips;
+}
+
+Uint16 AnimationLibrary::AddClip(const int *pSequence, Uint16 cFrames, AnimationType type, Uint16 ticksPerFrame)
+{
+    SDL_assert((cFrames > 0) && (ticksPerFrame > 0));
+
+    // Sheets loading the same sequence (the same ghost in four colors) end up sharing one clip
+    for (Uint16 clip = 0; clip < _cClips; clip++)
+    {
+        const AnimationClip &animationClip = _pClips[clip];
+        if ((animationClip.cFrames == cFrames) && (animationClip.ticksPerFrame == ticksPerFrame) && (animationClip.type == type))
+        {
+            Uint16 i = 0;
+            while ((i < cFrames) && (_pFrames[animationClip.iFirstFrame + i] == pSequence[i]))
+            {
+                i++;
+            }
+            if (i == cFrames)
+            {
+                return clip;
+            }
+        }
+    }
+
+    if ((_cClips == _cMaxClips) || (cFrames > _cMaxFrames - _cFrames))
+    {
+        printf("AnimationLibrary::AddClip() : library is full (%u clips, %u frames)\n", _cClips, _cFrames);
+        return c_noClip;
+    }
+
+    _pClips[_cClips] = { _cFrames, cFrames, ticksPerFrame, type };
+    for (Uint16 i = 0; i < cFrames; i++)
+    {
+        _pFrames[_cFrames++] = static_cast<Uint16>(pSequence[i]);
+    }
+    return _cClips++;
+}
@@ -0,0 +1,274 @@
+#include "include/assetloader.h"
+#include <stdio.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+AssetLoader::AssetLoader(Uint32 cWorkers, Uint32 cMaxRequests) :
+    _cWorkers(0),
+    _ppWorkers(nullptr),
+    _cMaxRequests(cMaxRequests),
+    _pRequests(nullptr),
+    _pQueue(nullptr),
+    _iQueueHead(0),
+    _cQueued(0),
+    _fQuit(false),
+    _pMutex(nullptr),
+    _pWorkQueued(nullptr),
+    _pWorkDone(nullptr)
+{
+    _pRequests = new AssetRequest[_cMaxRequests]{};
+    _pQueue = new AssetHandle[_cMaxRequests]{};
+    _pMutex = SDL_CreateMutex();
+    _pWorkQueued = SDL_CreateCond();
+    _pWorkDone = SDL_CreateCond();
+
+    _ppWorkers = new SDL_Thread*[cWorkers]{};
+    for (Uint32 i = 0; i < cWorkers; i++)
+    {
+        char szName[32];
+        SDL_snprintf(szName, sizeof(szName), "AssetLoader%u", i);
+        _ppWorkers[_cWorkers] = SDL_CreateThread(WorkerThread, szName, this);
+        if (_ppWorkers[_cWorkers] == nullptr)
+        {
+            printf("SDL_CreateThread() failed, error = %s\n", SDL_GetError());
+            break;
+        }
+        _cWorkers++;
+    }
+
+    // Without a worker nothing would ever be decoded, Load does the work itself instead
+    if (_cWorkers == 0)
+    {
+        printf("AssetLoader : no worker threads, loading synchronously\n");
+    }
+}
+
+AssetLoader::~AssetLoader()
+{
+    SDL_LockMutex(_pMutex);
+    _fQuit = true;
+    SDL_CondBroadcast(_pWorkQueued);
+    SDL_UnlockMutex(_pMutex);
+
+    for (Uint32 i = 0; i < _cWorkers; i++)
+    {
+        SDL_WaitThread(_ppWorkers[i], nullptr);
+    }
+
+    // Anything nobody took (or that never got to a worker)
+    for (AssetHandle handle = 0; handle < _cMaxRequests; handle++)
+    {
+        if (_pRequests[handle].state != AssetState::Free)
+        {
+            _pRequests[handle].state = AssetState::Failed;
+            FreeRequest(handle);
+        }
+    }
+
+    SDL_DestroyCond(_pWorkDone);
+    SDL_DestroyCond(_pWorkQueued);
+    SDL_DestroyMutex(_pMutex);
+    delete[] _ppWorkers;
+    delete[] _pQueue;
+    delete[] _pRequests;
+}
+
+AssetHandle AssetLoader::Load(const char *szFileName, SDL_Color *pSdlTransparencyColorKey, bool fUpload)
+{
+    SDL_LockMutex(_pMutex);
+    AssetHandle handle = 0;
+    while ((handle < _cMaxRequests) && (_pRequests[handle].state != AssetState::Free))
+    {
+        handle++;
+    }
+    if (handle == _cMaxRequests)
+    {
+        SDL_UnlockMutex(_pMutex);
+        printf("AssetLoader::Load() : too many requests in flight, max is %u\n", _cMaxRequests);
+        return InvalidAssetHandle;
+    }
+
+    AssetRequest &request = _pRequests[handle];
+    size_t cchFileName = SDL_strlen(szFileName) + 1;
+    request.pszFileName = new char[cchFileName];
+    SDL_memcpy(request.pszFileName, szFileName, cchFileName);
+    request.fColorKey = (pSdlTransparencyColorKey != nullptr) ? SDL_TRUE : SDL_FALSE;
+    request.colorKey = (pSdlTransparencyColorKey != nullptr) ? *pSdlTransparencyColorKey : SDL_Color{ 0, 0, 0, 0 };
+    request.fUpload = fUpload;
+    request.pSurface = nullptr;
+    request.pTextureWrapper = nullptr;
+
+    if (_cWorkers == 0)
+    {
+        request.pSurface = LoadSurface(request.pszFileName, pSdlTransparencyColorKey);
+        request.state = (request.pSurface == nullptr) ? AssetState::Failed : (fUpload ? AssetState::Decoded : AssetState::Ready);
+    }
+    else
+    {
+        request.state = AssetState::Queued;
+        _pQueue[(_iQueueHead + _cQueued) % _cMaxRequests] = handle;
+        _cQueued++;
+        SDL_CondSignal(_pWorkQueued);
+    }
+    SDL_UnlockMutex(_pMutex);
+    return handle;
+}
+
+int AssetLoader::WorkerThread(void *pData)
+{
+    static_cast<AssetLoader*>(pData)->WorkerLoop();
+    return 0;
+}
+
+// Take the oldest queued request, decode it without holding the lock, then publish the result
+void AssetLoader::WorkerLoop()
+{
+    SDL_LockMutex(_pMutex);
+    for (;;)
+    {
+        while ((_cQueued == 0) && !_fQuit)
+        {
+            SDL_CondWait(_pWorkQueued, _pMutex);
+        }
+        if (_fQuit)
+        {
+            break;
+        }
+
+        AssetHandle handle = _pQueue[_iQueueHead];
+        _iQueueHead = (_iQueueHead + 1) % _cMaxRequests;
+        _cQueued--;
+
+        AssetRequest &request = _pRequests[handle];
+        request.state = AssetState::Decoding;
+        SDL_UnlockMutex(_pMutex);
+
+        // Nothing else touches a request while it's Decoding
+        SDL_Surface *pSurface = LoadSurface(request.pszFileName, (request.fColorKey == SDL_TRUE) ? &request.colorKey : nullptr);
+
+        SDL_LockMutex(_pMutex);
+        request.pSurface = pSurface;
+        if (pSurface == nullptr)
+        {
+            request.state = AssetState::Failed;
+        }
+        else
+        {
+            request.state = request.fUpload ? AssetState::Decoded : AssetState::Ready;
+        }
+        SDL_CondBroadcast(_pWorkDone);
+    }
+    SDL_UnlockMutex(_pMutex);
+}
+
+// Textures have to be created on the renderer's thread, so this is the only part of a load that runs here
+void AssetLoader::Pump(SDL_Renderer *pSDLRenderer)
+{
+    for (AssetHandle handle = 0; handle < _cMaxRequests; handle++)
+    {
+        SDL_LockMutex(_pMutex);
+        bool fDecoded = (_pRequests[handle].state == AssetState::Decoded);
+        SDL_UnlockMutex(_pMutex);
+
+        if (fDecoded)
+        {
+            // Decoded requests belong to this thread until their state changes
+            AssetRequest &request = _pRequests[handle];
+            SDL_Texture *pTexture = SDL_CreateTextureFromSurface(pSDLRenderer, request.pSurface);
+            SDL_FreeSurface(request.pSurface);
+            request.pSurface = nullptr;
+
+            if (pTexture == nullptr)
+            {
+                printf("SDL_CreateTextureFromSurface() failed, error = %s\n", SDL_GetError());
+            }
+            else
+            {
+                request.pTextureWrapper = new TextureWrapper(pTexture, request.pszFileName);
+            }
+
+            SDL_LockMutex(_pMutex);
+            request.state = (pTexture != nullptr) ? AssetState::Ready : AssetState::Failed;
+            SDL_UnlockMutex(_pMutex);
+        }
+    }
+}
+
+bool AssetLoader::Wait(AssetHandle handle, SDL_Renderer *pSDLRenderer)
+{
+    if (handle >= _cMaxRequests)
+    {
+        return false;
+    }
+
+    SDL_LockMutex(_pMutex);
+    while ((_pRequests[handle].state == AssetState::Queued) || (_pRequests[handle].state == AssetState::Decoding))
+    {
+        SDL_CondWait(_pWorkDone, _pMutex);
+    }
+    SDL_UnlockMutex(_pMutex);
+
+    Pump(pSDLRenderer);
+    return State(handle) == AssetState::Ready;
+}
+
+AssetState AssetLoader::State(AssetHandle handle)
+{
+    if (handle >= _cMaxRequests)
+    {
+        return AssetState::Failed;
+    }
+
+    SDL_LockMutex(_pMutex);
+    AssetState state = _pRequests[handle].state;
+    SDL_UnlockMutex(_pMutex);
+    return state;
+}
+
+SDL_Surface* AssetLoader::TakeSurface(AssetHandle handle)
+{
+    SDL_Surface *pSurface = nullptr;
+    if (State(handle) == AssetState::Ready)
+    {
+        pSurface = _pRequests[handle].pSurface;
+        _pRequests[handle].pSurface = nullptr;
+    }
+    if (handle < _cMaxRequests)
+    {
+        FreeRequest(handle);
+    }
+    return pSurface;
+}
+
+TextureWrapper* AssetLoader::TakeTexture(AssetHandle handle)
+{
+    TextureWrapper *pTextureWrapper = nullptr;
+    if (State(handle) == AssetState::Ready)
+    {
+        pTextureWrapper = _pRequests[handle].pTextureWrapper;
+        _pRequests[handle].pTextureWrapper = nullptr;
+    }
+    if (handle < _cMaxRequests)
+    {
+        FreeRequest(handle);
+    }
+    return pTextureWrapper;
+}
+
+void AssetLoader::FreeRequest(AssetHandle handle)
+{
+    AssetRequest &request = _pRequests[handle];
+    SDL_assert((request.state != AssetState::Queued) && (request.state != AssetState::Decoding));
+
+    if (request.pSurface != nullptr)
+    {
+        SDL_FreeSurface(request.pSurface);
+    }
+    delete request.pTextureWrapper;
+    delete[] request.pszFileName;
+
+    SDL_LockMutex(_pMutex);
+    SDL_memset(&request, 0, sizeof(AssetRequest));
+    request.state = AssetState::Free;
+    SDL_UnlockMutex(_pMutex);
+}
@@ -0,0 +1,221 @@
+#include "include/assetpack.h"
+#include <stdio.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#define PMC_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace XplatGameTutorial::PacManClone;
+
+AssetPack::AssetPack() :
+    _pBase(nullptr),
+    _cbFile(0),
+    _pEntries(nullptr),
+    _cEntries(0),
+    _tablesVersion(0),
+#ifdef _WIN32
+    _hFile(INVALID_HANDLE_VALUE),
+    _hMapping(nullptr),
+#endif
+    _fMapped(false)
+{
+}
+
+AssetPack::~AssetPack()
+{
+    Close();
+}
+
+bool AssetPack::Open(const char *szFileName)
+{
+    Close();
+
+#ifdef _WIN32
+    _hFile = CreateFileA(szFileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (_hFile != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER cbFile;
+        GetFileSizeEx(_hFile, &cbFile);
+        _cbFile = static_cast<size_t>(cbFile.QuadPart);
+        _hMapping = CreateFileMappingA(_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (_hMapping != nullptr)
+        {
+            _pBase = static_cast<const Uint8*>(MapViewOfFile(_hMapping, FILE_MAP_READ, 0, 0, 0));
+            _fMapped = (_pBase != nullptr);
+        }
+    }
+#elif defined(PMC_HAS_MMAP)
+    int fd = open(szFileName, O_RDONLY);
+    if (fd >= 0)
+    {
+        struct stat fileStat;
+        if ((fstat(fd, &fileStat) == 0) && (fileStat.st_size > 0))
+        {
+            _cbFile = static_cast<size_t>(fileStat.st_size);
+            void *pMapping = mmap(nullptr, _cbFile, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (pMapping != MAP_FAILED)
+            {
+                _pBase = static_cast<const Uint8*>(pMapping);
+                _fMapped = true;
+            }
+        }
+        // The mapping keeps its own reference to the file
+        close(fd);
+    }
+#endif
+
+    if (_pBase == nullptr)
+    {
+        // No mapping available, read the whole thing in instead.  Slower to start but works the same after
+        SDL_RWops *pFile = SDL_RWFromFile(szFileName, "rb");
+        if (pFile == nullptr)
+        {
+            Close();
+            return false;
+        }
+        Sint64 cbFile = SDL_RWsize(pFile);
+        Uint8 *pData = (cbFile > 0) ? new Uint8[static_cast<size_t>(cbFile)] : nullptr;
+        if ((pData == nullptr) || (SDL_RWread(pFile, pData, static_cast<size_t>(cbFile), 1) != 1))
+        {
+            delete[] pData;
+            SDL_RWclose(pFile);
+            Close();
+            return false;
+        }
+        SDL_RWclose(pFile);
+        _pBase = pData;
+        _cbFile = static_cast<size_t>(cbFile);
+    }
+
+    // Validate the header and index before trusting any offsets
+    const AssetPackHeader *pHeader = reinterpret_cast<const AssetPackHeader*>(_pBase);
+    if ((_cbFile < sizeof(AssetPackHeader)) || (pHeader->magic != c_assetPackMagic) || (pHeader->version != c_assetPackVersion) ||
+        (pHeader->indexOffset > _cbFile) || (pHeader->cEntries > (_cbFile - pHeader->indexOffset) / sizeof(AssetPackEntry)))
+    {
+        printf("AssetPack::Open() : %s is not a valid asset pack (version %u)\n", szFileName, c_assetPackVersion);
+        Close();
+        return false;
+    }
+
+    _pEntries = reinterpret_cast<const AssetPackEntry*>(_pBase + pHeader->indexOffset);
+    _cEntries = pHeader->cEntries;
+    _tablesVersion = pHeader->tablesVersion;
+    for (Uint32 i = 0; i < _cEntries; i++)
+    {
+        if ((_pEntries[i].offset > _cbFile) || (_pEntries[i].cbSize > _cbFile - _pEntries[i].offset) ||
+            (_pEntries[i].szName[c_assetPackMaxName - 1] != '\0'))
+        {
+            printf("AssetPack::Open() : %s entry %u is out of range\n", szFileName, i);
+            Close();
+            return false;
+        }
+    }
+
+    printf("Opened asset pack %s, %u entries, %u bytes%s\n", szFileName, _cEntries, static_cast<Uint32>(_cbFile), _fMapped ? " (mapped)" : "");
+    return true;
+}
+
+void AssetPack::Close()
+{
+    if (_pBase != nullptr)
+    {
+        if (_fMapped)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(_pBase);
+#elif defined(PMC_HAS_MMAP)
+            munmap(const_cast<Uint8*>(_pBase), _cbFile);
+#endif
+        }
+        else
+        {
+            delete[] _pBase;
+        }
+    }
+#ifdef _WIN32
+    if (_hMapping != nullptr)
+    {
+        CloseHandle(_hMapping);
+        _hMapping = nullptr;
+    }
+    if (_hFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(_hFile);
+        _hFile = INVALID_HANDLE_VALUE;
+    }
+#endif
+    _pBase = nullptr;
+    _cbFile = 0;
+    _pEntries = nullptr;
+    _cEntries = 0;
+    _tablesVersion = 0;
+    _fMapped = false;
+}
+
+const AssetPackEntry* AssetPack::Find(const char *szName, AssetPackEntryType type)
+{
+    for (Uint32 i = 0; i < _cEntries; i++)
+    {
+        if ((_pEntries[i].type == type) && (SDL_strcmp(_pEntries[i].szName, szName) == 0))
+        {
+            return &_pEntries[i];
+        }
+    }
+    return nullptr;
+}
+
+SDL_Surface* AssetPack::CreateSurface(const char *szName)
+{
+    const AssetPackEntry *pEntry = Find(szName, AssetPackEntryType::Image);
+    if ((pEntry == nullptr) || (pEntry->pitch < pEntry->width * 4) || (static_cast<Uint64>(pEntry->pitch) * pEntry->height > pEntry->cbSize))
+    {
+        printf("AssetPack::CreateSurface() : no image %s\n", szName);
+        return nullptr;
+    }
+
+    int bpp = 0;
+    Uint32 rMask = 0;
+    Uint32 gMask = 0;
+    Uint32 bMask = 0;
+    Uint32 aMask = 0;
+    SDL_PixelFormatEnumToMasks(SDL_PIXELFORMAT_ARGB8888, &bpp, &rMask, &gMask, &bMask, &aMask);
+
+    // SDL wants a non-const pointer, but nothing we do with these surfaces writes to the pixels (the mapping is
+    // read only, so a write would fault rather than corrupt anything)
+    SDL_Surface *pSurface = SDL_CreateRGBSurfaceFrom(const_cast<Uint8*>(_pBase + pEntry->offset), pEntry->width, pEntry->height,
+        bpp, pEntry->pitch, rMask, gMask, bMask, aMask);
+    if (pSurface == nullptr)
+    {
+        printf("SDL_CreateRGBSurfaceFrom() failed, error = %s\n", SDL_GetError());
+    }
+    return pSurface;
+}
+
+const Uint16* AssetPack::Grid(const char *szName, Uint32 cRows, Uint32 cCols)
+{
+    const AssetPackEntry *pEntry = Find(szName, AssetPackEntryType::Grid16);
+    if ((pEntry == nullptr) || (pEntry->height != cRows) || (pEntry->width != cCols) || (pEntry->cbSize < cRows * cCols * sizeof(Uint16)))
+    {
+        printf("AssetPack::Grid() : no %ux%u grid %s\n", cRows, cCols, szName);
+        return nullptr;
+    }
+    return reinterpret_cast<const Uint16*>(_pBase + pEntry->offset);
+}
+
+const Sint32* AssetPack::Table(const char *szName, Uint32 cCount)
+{
+    const AssetPackEntry *pEntry = Find(szName, AssetPackEntryType::Table32);
+    if ((pEntry == nullptr) || (pEntry->width != cCount) || (pEntry->cbSize < cCount * sizeof(Sint32)))
+    {
+        printf("AssetPack::Table() : no table %s of %u entries\n", szName, cCount);
+        return nullptr;
+    }
+    return reinterpret_cast<const Sint32*>(_pBase + pEntry->offset);
+}
@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+#include "benchmark.h"
+#include "actorbroadphase.h"
+#include "constants.h"
+#include "entitystore.h"
+#include "memoryarena.h"
+#include "tiledmap.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+// An open world much bigger than the arcade maze (tiles the same size), so thousands of actors have room to spread out
+static const Uint16 c_bigWorldSize = 256;
+// The map's chunk pool and a couple of sheets
+static const size_t c_cbWorldArena = 1024 * 1024;
+static const Uint32 c_cMaxBenchPairs = 65536;
+
+static bool PairLess(const ActorPair &a, const ActorPair &b)
+{
+    return (a.first < b.first) || ((a.first == b.first) && (a.second < b.second));
+}
+
+// What the broadphase replaces, every frame rect against every other
+static void BruteForceContacts(EntityStore &entityStore, std::vector<SDL_Rect> &boxes, std::vector<ActorPair> &contacts)
+{
+    Uint32 cEntities = entityStore.Count();
+    for (Uint32 i = 0; i < cEntities; i++)
+    {
+        const SpriteSheet &sheet = entityStore.Sheet(entityStore.SheetIds()[i]);
+        boxes[i] = { FixedToInt(entityStore.X()[i]) + entityStore.FrameOffsetsX()[i], FixedToInt(entityStore.Y()[i]) + entityStore.FrameOffsetsY()[i],
+            sheet.cxFrame, sheet.cyFrame };
+    }
+
+    contacts.clear();
+    for (Uint32 i = 0; i < cEntities; i++)
+    {
+        const SDL_Rect &a = boxes[i];
+        for (Uint32 j = i + 1; j < cEntities; j++)
+        {
+            const SDL_Rect &b = boxes[j];
+            if ((a.x < b.x + b.w) && (b.x < a.x + a.w) && (a.y < b.y + b.h) && (b.y < a.y + a.h))
+            {
+                contacts.push_back({ i, j });
+            }
+        }
+    }
+}
+
+// Actors scattered over the world (a few just off its edges) with the player's frame and offset, every eighth one a
+// small projectile.  All of them moving in one of the four directions
+static void PopulateBroadphaseStore(EntityStore &entityStore, TiledMap &tiledMap, Uint32 cActors)
+{
+    Uint16 actorSheet = entityStore.CreateSheet(nullptr, Constants::PlayerSpriteWidth, Constants::PlayerSpriteHeight, 1, 0);
+    Uint16 projectileSheet = entityStore.CreateSheet(nullptr, 8, 8, 1, 0);
+    SDL_Rect bounds = tiledMap.GetMapBounds();
+    Uint32 seed = 0x5EED;
+    for (Uint32 i = 0; i < cActors; i++)
+    {
+        bool fProjectile = (i % 8) == 7;
+        Uint32 index = entityStore.IndexOf(entityStore.Create(fProjectile ? projectileSheet : actorSheet));
+        seed = (seed * 1664525) + 1013904223;
+        int x = bounds.x - 16 + static_cast<int>((seed >> 8) % static_cast<Uint32>(bounds.w + 32));
+        seed = (seed * 1664525) + 1013904223;
+        int y = bounds.y - 16 + static_cast<int>((seed >> 8) % static_cast<Uint32>(bounds.h + 32));
+        entityStore.X()[index] = FixedFromInt(x);
+        entityStore.Y()[index] = FixedFromInt(y);
+        entityStore.XPrevious()[index] = entityStore.X()[index];
+        entityStore.YPrevious()[index] = entityStore.Y()[index];
+        Fixed speed = fProjectile ? (4 * Constants::PlayerSpeed) : Constants::PlayerSpeed;
+        entityStore.DX()[index] = ((i & 3) == 0) ? speed : (((i & 3) == 1) ? -speed : 0);
+        entityStore.DY()[index] = ((i & 3) == 2) ? speed : (((i & 3) == 3) ? -speed : 0);
+        entityStore.FrameOffsetsX()[index] = fProjectile ? -4 : 1 - (Constants::PlayerSpriteWidth / 2);
+        entityStore.FrameOffsetsY()[index] = fProjectile ? -4 : 1 - (Constants::PlayerSpriteHeight / 2);
+    }
+}
+
+// The broadphase has to find exactly the contacts testing every pair does, tick after tick as the actors move (and
+// some drift off the map)
+static void VerifyBroadphase(const char *szMap, TiledMap &tiledMap, Uint16 rows, Uint16 cols, Uint32 cActors, Uint32 cSteps)
+{
+    MemoryArena arena(c_cbWorldArena);
+    EntityStore entityStore(cActors, &arena);
+    PopulateBroadphaseStore(entityStore, tiledMap, cActors);
+    ActorBroadphase broadphase(rows, cols, cActors, c_cMaxBenchPairs);
+    std::vector<SDL_Rect> boxes(cActors);
+    std::vector<ActorPair> expected;
+    std::vector<ActorPair> found;
+
+    bool fSame = true;
+    Uint64 cContacts = 0;
+    for (Uint32 step = 0; fSame && (step < cSteps); step++)
+    {
+        broadphase.Build(&entityStore, &tiledMap);
+        broadphase.FindContacts();
+        found.assign(broadphase.Pairs(), broadphase.Pairs() + broadphase.PairCount());
+        std::sort(found.begin(), found.end(), PairLess);
+        BruteForceContacts(entityStore, boxes, expected);
+        fSame = (broadphase.DroppedPairs() == 0) && (found.size() == expected.size()) &&
+            std::equal(found.begin(), found.end(), expected.begin(), [](const ActorPair &a, const ActorPair &b) { return (a.first == b.first) && (a.second == b.second); });
+        cContacts += expected.size();
+        entityStore.UpdateAll();
+    }
+    printf("ActorBroadphase %s, %u actors x %u ticks vs brute force: %s (%u contacts)\n", szMap, cActors, cSteps,
+        fSame ? "identical" : "MISMATCH", static_cast<Uint32>(cContacts));
+}
+
+// Contacts among a store of actors, the broadphase (bucketing included) against testing every pair
+static void RegisterContacts(BenchmarkRunner &runner, const char *szMap, TiledMap *pTiledMap, Uint16 rows, Uint16 cols, Uint32 cActors)
+{
+    char szName[96];
+    SDL_snprintf(szName, sizeof(szName), "ActorBroadphase contacts (%s, %u actors)", szMap, cActors);
+    runner.Add(szName, [pTiledMap, rows, cols, cActors](Uint64 cIterations)
+    {
+        MemoryArena arena(c_cbWorldArena);
+        EntityStore entityStore(cActors, &arena);
+        PopulateBroadphaseStore(entityStore, *pTiledMap, cActors);
+        ActorBroadphase broadphase(rows, cols, cActors, c_cMaxBenchPairs);
+        Uint64 sum = 0;
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            broadphase.Build(&entityStore, pTiledMap);
+            sum += broadphase.FindContacts();
+        }
+        BenchmarkSink(sum);
+    });
+
+    SDL_snprintf(szName, sizeof(szName), "Brute force contacts (%s, %u actors)", szMap, cActors);
+    runner.Add(szName, [pTiledMap, cActors](Uint64 cIterations)
+    {
+        MemoryArena arena(c_cbWorldArena);
+        EntityStore entityStore(cActors, &arena);
+        PopulateBroadphaseStore(entityStore, *pTiledMap, cActors);
+        std::vector<SDL_Rect> boxes(cActors);
+        std::vector<ActorPair> contacts;
+        contacts.reserve(c_cMaxBenchPairs);
+        Uint64 sum = 0;
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            BruteForceContacts(entityStore, boxes, contacts);
+            sum += contacts.size();
+        }
+        BenchmarkSink(sum);
+    });
+}
+
+void RegisterBroadphaseBenchmarks(BenchmarkRunner &runner)
+{
+    static std::vector<Uint16> s_worldIndicies(c_bigWorldSize * c_bigWorldSize, 0);
+    static MemoryArena s_worldArena(c_cbWorldArena);
+    static TiledMap s_world(c_bigWorldSize, c_bigWorldSize, Constants::ScreenWidth, Constants::ScreenHeight, &s_worldArena);
+    SDL_Rect textureRect = { 0, 0, Constants::TileTextureWidth, Constants::TileTextureHeight };
+    SDL_Rect tileRect = { 0, 0, Constants::TileWidth, Constants::TileHeight };
+    s_world.Initialize(textureRect, tileRect, nullptr, s_worldIndicies.data(), c_bigWorldSize * c_bigWorldSize);
+
+    static MemoryArena s_mazeArena(c_cbWorldArena);
+    static TiledMap s_maze(Constants::MapRows, Constants::MapCols, Constants::ScreenWidth, Constants::ScreenHeight, &s_mazeArena);
+    s_maze.Initialize(textureRect, tileRect, nullptr, Constants::MapIndicies, Constants::MapRows * Constants::MapCols);
+
+    // Too few to bucket, just enough to, and thousands
+    VerifyBroadphase("arcade maze", s_maze, Constants::MapRows, Constants::MapCols, 16, 600);
+    VerifyBroadphase("arcade maze", s_maze, Constants::MapRows, Constants::MapCols, 64, 600);
+    VerifyBroadphase("256x256 world", s_world, c_bigWorldSize, c_bigWorldSize, 8192, 60);
+
+    // The game's own map with a handful of actors, and the big world with thousands
+    RegisterContacts(runner, "arcade maze", &s_maze, Constants::MapRows, Constants::MapCols, 16);
+    static const Uint32 c_actorCounts[] = { 256, 1024, 4096 };
+    for (Uint32 cActors : c_actorCounts)
+    {
+        RegisterContacts(runner, "256x256 world", &s_world, c_bigWorldSize, c_bigWorldSize, cActors);
+    }
+}
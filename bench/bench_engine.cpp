@@ -0,0 +1,533 @@
+#include <stdio.h>
+#include <vector>
+#include "benchmark.h"
+#include "collisiongrid.h"
+#include "constants.h"
+#include "entitystore.h"
+#include "gamelogic.h"
+#include "memoryarena.h"
+#include "pelletboard.h"
+#include "sprite.h"
+#include "animationlibrary.h"
+#include "threadpool.h"
+#include "tiledmap.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+// Plenty for a map and a few sheets, each store or map below gets its own (or Resets a shared one)
+static const size_t c_cbBenchArena = 256 * 1024;
+
+// The map the game uses, without a texture (nothing here renders)
+static void InitializeBenchMap(TiledMap &tiledMap)
+{
+    SDL_Rect textureRect = { 0, 0, Constants::TileTextureWidth, Constants::TileTextureHeight };
+    SDL_Rect tileRect = { 0, 0, Constants::TileWidth, Constants::TileHeight };
+    tiledMap.Initialize(textureRect, tileRect, nullptr, Constants::MapIndicies, Constants::MapRows * Constants::MapCols);
+}
+
+// A player sprite with the real animations loaded, placed at the start tile and moving right
+static Sprite* CreateBenchPlayer(EntityStore &entityStore, TiledMap &tiledMap)
+{
+    Sprite *pSprite = new Sprite(&entityStore, nullptr, Constants::PlayerSpriteWidth, Constants::PlayerSpriteHeight,
+        Constants::PlayerTotalFrameCount, Constants::PlayerTotalAnimationCount);
+    pSprite->LoadAnimationSequence(Constants::AnimationIndexLeft, AnimationType::Loop, Constants::PlayerAnimation_LEFT, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
+    pSprite->LoadAnimationSequence(Constants::AnimationIndexRight, AnimationType::Loop, Constants::PlayerAnimation_RIGHT, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
+    pSprite->LoadAnimationSequence(Constants::AnimationIndexUp, AnimationType::Loop, Constants::PlayerAnimation_UP, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
+    pSprite->LoadAnimationSequence(Constants::AnimationIndexDown, AnimationType::Loop, Constants::PlayerAnimation_DOWN, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
+    pSprite->LoadAnimationSequence(Constants::AnimationIndexDeath, AnimationType::Once, Constants::PlayerAnimation_DEATH, Constants::PlayerAnimationDeathFrameCount, Constants::PlayerAnimationSpeed);
+    pSprite->SetAnimation(Constants::AnimationIndexRight);
+
+    SDL_Point startPoint = tiledMap.GetTileCoordinates(Constants::PlayerStartRow, Constants::PlayerStartCol);
+    pSprite->ResetPosition(FixedFromInt(startPoint.x), FixedFromInt(startPoint.y));
+    pSprite->SetVelocity(Constants::PlayerSpeed, 0);
+    return pSprite;
+}
+
+// Fill the store with animated actors sharing the owner's sheet, alternately moving across and down
+static void PopulateBenchStore(EntityStore &entityStore, Sprite *pSheetOwner, Uint32 cActors)
+{
+    for (Uint32 i = 1; i < cActors; i++)
+    {
+        EntityHandle handle = entityStore.Create(pSheetOwner->Sheet());
+        Uint32 index = entityStore.IndexOf(handle);
+        entityStore.DX()[index] = (i & 1) ? Constants::PlayerSpeed : 0;
+        entityStore.DY()[index] = (i & 1) ? 0 : Constants::PlayerSpeed;
+        entityStore.SetAnimation(index, i % Constants::PlayerTotalAnimationCount);
+    }
+}
+
+// Put every actor in the store on an open cell of the maze (round robin), heading off in one of the four directions,
+// with wall collision on.  Called again to start over, walls stop the actors as they go
+static void PlaceBenchActors(EntityStore &entityStore, TiledMap &tiledMap, const CollisionGrid &collisionGrid)
+{
+    static std::vector<SDL_Point> s_openCells;
+    if (s_openCells.empty())
+    {
+        for (Uint16 row = 0; row < collisionGrid.Rows(); row++)
+        {
+            for (Uint16 col = 0; col < collisionGrid.Cols(); col++)
+            {
+                if (collisionGrid.IsWalkable(row, col))
+                {
+                    s_openCells.push_back(tiledMap.GetTileCoordinates(row, col));
+                }
+            }
+        }
+    }
+
+    static const Fixed c_dx[] = { 0, 0, -Constants::PlayerSpeed, Constants::PlayerSpeed };
+    static const Fixed c_dy[] = { -Constants::PlayerSpeed, Constants::PlayerSpeed, 0, 0 };
+    entityStore.SetCollisionMap(&tiledMap, &collisionGrid);
+    for (Uint32 i = 0; i < entityStore.Count(); i++)
+    {
+        const SDL_Point &cell = s_openCells[i % s_openCells.size()];
+        entityStore.X()[i] = FixedFromInt(cell.x);
+        entityStore.Y()[i] = FixedFromInt(cell.y);
+        entityStore.XPrevious()[i] = entityStore.X()[i];
+        entityStore.YPrevious()[i] = entityStore.Y()[i];
+        entityStore.DX()[i] = c_dx[(i / s_openCells.size()) & 3];
+        entityStore.DY()[i] = c_dy[(i / s_openCells.size()) & 3];
+        entityStore.WallCollision()[i] = SDL_TRUE;
+    }
+}
+
+// Every few ticks anything a wall stopped sets off again, the same way in every store
+static void RestartStoppedActors(EntityStore &entityStore, Uint32 step)
+{
+    static const Fixed c_dx[] = { 0, Constants::PlayerSpeed, 0, -Constants::PlayerSpeed };
+    static const Fixed c_dy[] = { Constants::PlayerSpeed, 0, -Constants::PlayerSpeed, 0 };
+    for (Uint32 i = 0; i < entityStore.Count(); i++)
+    {
+        if ((entityStore.DX()[i] == 0) && (entityStore.DY()[i] == 0))
+        {
+            entityStore.DX()[i] = c_dx[(i + step) & 3];
+            entityStore.DY()[i] = c_dy[(i + step) & 3];
+        }
+    }
+}
+
+static bool SameState(EntityStore &first, EntityStore &second)
+{
+    Uint32 cEntities = first.Count();
+    return (cEntities == second.Count()) &&
+        (SDL_memcmp(first.X(), second.X(), cEntities * sizeof(Fixed)) == 0) &&
+        (SDL_memcmp(first.Y(), second.Y(), cEntities * sizeof(Fixed)) == 0) &&
+        (SDL_memcmp(first.XPrevious(), second.XPrevious(), cEntities * sizeof(Fixed)) == 0) &&
+        (SDL_memcmp(first.YPrevious(), second.YPrevious(), cEntities * sizeof(Fixed)) == 0) &&
+        (SDL_memcmp(first.DX(), second.DX(), cEntities * sizeof(Fixed)) == 0) &&
+        (SDL_memcmp(first.DY(), second.DY(), cEntities * sizeof(Fixed)) == 0) &&
+        (SDL_memcmp(first.Clips(), second.Clips(), cEntities * sizeof(Uint16)) == 0) &&
+        (SDL_memcmp(first.AnimationStarts(), second.AnimationStarts(), cEntities * sizeof(Uint32)) == 0) &&
+        (first.Clock() == second.Clock());
+}
+
+static bool SameFrames(EntityStore &first, EntityStore &second)
+{
+    for (Uint32 i = 0; i < first.Count(); i++)
+    {
+        if (first.CurrentFrame(i) != second.CurrentFrame(i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The store's wall collision is DoPlayerBoundsCheck for every entity, so a sprite on its own moved with
+// Sprite::Update and DoPlayerBoundsCheck has to end up in the same place, tunnels included
+static void VerifyWallCollision(TiledMap &tiledMap, const CollisionGrid &collisionGrid)
+{
+    const Uint32 cActors = 1024;
+    const Uint32 cSteps = 600;
+
+    MemoryArena arena(c_cbBenchArena);
+    EntityStore entityStore(cActors, &arena);
+    Sprite *pSheetOwner = CreateBenchPlayer(entityStore, tiledMap);
+    PopulateBenchStore(entityStore, pSheetOwner, cActors);
+    PlaceBenchActors(entityStore, tiledMap, collisionGrid);
+
+    EntityStore spriteStore(cActors, &arena);
+    std::vector<Sprite*> sprites;
+    sprites.push_back(CreateBenchPlayer(spriteStore, tiledMap));
+    for (Uint32 i = 1; i < cActors; i++)
+    {
+        sprites.push_back(new Sprite(&spriteStore, sprites[0]->Sheet()));
+    }
+    PlaceBenchActors(spriteStore, tiledMap, collisionGrid);
+
+    bool fSame = true;
+    for (Uint32 step = 0; fSame && (step < cSteps); step++)
+    {
+        entityStore.UpdateAll();
+        for (Sprite *pSprite : sprites)
+        {
+            pSprite->Update();
+            DoPlayerBoundsCheck(pSprite, &tiledMap, &collisionGrid);
+        }
+        // The sprites' clock doesn't move, so only the movement is compared
+        fSame = (SDL_memcmp(entityStore.X(), spriteStore.X(), cActors * sizeof(Fixed)) == 0) &&
+            (SDL_memcmp(entityStore.Y(), spriteStore.Y(), cActors * sizeof(Fixed)) == 0) &&
+            (SDL_memcmp(entityStore.XPrevious(), spriteStore.XPrevious(), cActors * sizeof(Fixed)) == 0) &&
+            (SDL_memcmp(entityStore.YPrevious(), spriteStore.YPrevious(), cActors * sizeof(Fixed)) == 0) &&
+            (SDL_memcmp(entityStore.DX(), spriteStore.DX(), cActors * sizeof(Fixed)) == 0) &&
+            (SDL_memcmp(entityStore.DY(), spriteStore.DY(), cActors * sizeof(Fixed)) == 0);
+        if ((step % 8) == 7)
+        {
+            RestartStoppedActors(entityStore, step);
+            RestartStoppedActors(spriteStore, step);
+        }
+    }
+    printf("EntityStore wall collision, %u actors x %u ticks vs DoPlayerBoundsCheck: %s\n", cActors, cSteps, fSame ? "identical" : "MISMATCH");
+
+    for (Sprite *pSprite : sprites)
+    {
+        delete pSprite;
+    }
+    delete pSheetOwner;
+}
+
+// The parallel update has to land on exactly the state the serial one does, whatever the thread count.  Enough
+// actors that it really is split into jobs, an odd count leaves a short last one.  How long the ticks took is
+// printed next to serial's, the scaling across thread counts (only as good as the cores there are to run on)
+static void VerifyParallelUpdate(TiledMap &tiledMap, const CollisionGrid &collisionGrid, ThreadPool **ppThreadPools, Uint32 cThreadPools)
+{
+    const Uint32 cActors = EntityStore::c_maxEntities - 1;
+    const Uint32 cSteps = 240;
+    SDL_assert(cActors >= EntityStore::c_minParallelEntities);
+
+    auto RunSteps = [&tiledMap, &collisionGrid, cSteps](EntityStore &entityStore, ThreadPool *pThreadPool) -> double
+    {
+        PlaceBenchActors(entityStore, tiledMap, collisionGrid);
+        Uint64 counterTotal = 0;
+        for (Uint32 step = 0; step < cSteps; step++)
+        {
+            Uint64 startCounter = SDL_GetPerformanceCounter();
+            if (pThreadPool != nullptr)
+            {
+                entityStore.UpdateAll(pThreadPool);
+            }
+            else
+            {
+                entityStore.UpdateAll();
+            }
+            counterTotal += SDL_GetPerformanceCounter() - startCounter;
+            if ((step % 8) == 7)
+            {
+                RestartStoppedActors(entityStore, step);
+            }
+        }
+        return (counterTotal * 1000.0) / SDL_GetPerformanceFrequency();
+    };
+
+    MemoryArena arena(c_cbBenchArena);
+    EntityStore reference(cActors, &arena);
+    Sprite *pReferenceOwner = CreateBenchPlayer(reference, tiledMap);
+    PopulateBenchStore(reference, pReferenceOwner, cActors);
+    double msSerial = RunSteps(reference, nullptr);
+    printf("EntityStore::UpdateAll %u actors x %u ticks, serial: %.2f ms\n", cActors, cSteps, msSerial);
+
+    for (Uint32 i = 0; i < cThreadPools; i++)
+    {
+        EntityStore entityStore(cActors, &arena);
+        Sprite *pSheetOwner = CreateBenchPlayer(entityStore, tiledMap);
+        PopulateBenchStore(entityStore, pSheetOwner, cActors);
+        double ms = RunSteps(entityStore, ppThreadPools[i]);
+        printf("EntityStore::UpdateAll %u actors x %u ticks, %u thread(s): %.2f ms (%.2fx serial), %s\n", cActors, cSteps,
+            ppThreadPools[i]->WorkerCount() + 1, ms, msSerial / ms,
+            (SameState(entityStore, reference) && SameFrames(entityStore, reference)) ? "bit-identical" : "MISMATCH");
+        delete pSheetOwner;
+    }
+    printf("(%d core(s) to run on)\n", SDL_GetCPUCount());
+    delete pReferenceOwner;
+}
+
+void RegisterEngineBenchmarks(BenchmarkRunner &runner)
+{
+    // Shared by the benchmarks below, these live for the whole run
+    static MemoryArena s_arena(c_cbBenchArena);
+    static TiledMap s_tiledMap(Constants::MapRows, Constants::MapCols, Constants::ScreenWidth, Constants::ScreenHeight, &s_arena);
+    static EntityStore s_entityStore(Constants::MaxEntities, &s_arena);
+    static CollisionGrid s_collisionGrid(Constants::MapRows, Constants::MapCols);
+    InitializeBenchMap(s_tiledMap);
+    s_collisionGrid.Build(Constants::CollisionMap);
+
+    runner.Add("TiledMap::GetTileCoordinates", [](Uint64 cIterations)
+    {
+        Uint64 sum = 0;
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            SDL_Point point = s_tiledMap.GetTileCoordinates(i % Constants::MapRows, i % Constants::MapCols);
+            sum += point.x + point.y;
+        }
+        BenchmarkSink(sum);
+    });
+
+    runner.Add("TiledMap::GetTileRowCol", [](Uint64 cIterations)
+    {
+        // Walk points across (and a little off) the map
+        SDL_Rect bounds = s_tiledMap.GetMapBounds();
+        Uint64 sum = 0;
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            SDL_Point point = { bounds.x - 4 + static_cast<int>((i * 7) % (bounds.w + 8)), bounds.y - 4 + static_cast<int>((i * 13) % (bounds.h + 8)) };
+            Uint16 row = 0;
+            Uint16 col = 0;
+            sum += s_tiledMap.GetTileRowCol(point, row, col) ? (row + col) : 1;
+        }
+        BenchmarkSink(sum);
+    });
+
+    runner.Add("CanMove", [](Uint64 cIterations)
+    {
+        // Interior cells only, the edges would look outside the map
+        Uint64 sum = 0;
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            Uint16 row = 1 + (i % (Constants::MapRows - 2));
+            Uint16 col = 1 + ((i / 3) % (Constants::MapCols - 2));
+            sum += s_collisionGrid.CanMove(row, col, static_cast<Direction>(i & 3));
+        }
+        BenchmarkSink(sum);
+    });
+
+    runner.Add("CollisionGrid::RunLength", [](Uint64 cIterations)
+    {
+        Uint64 sum = 0;
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            sum += s_collisionGrid.RunLength(i % Constants::MapRows, (i / 5) % Constants::MapCols, static_cast<Direction>(i & 3));
+        }
+        BenchmarkSink(sum);
+    });
+
+    runner.Add("CollisionGrid::Build", [](Uint64 cIterations)
+    {
+        CollisionGrid collisionGrid(Constants::MapRows, Constants::MapCols);
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            collisionGrid.Build(Constants::CollisionMap);
+        }
+        BenchmarkSink(collisionGrid.ExitsAt(Constants::PlayerStartRow, Constants::PlayerStartCol));
+    });
+
+    // Pellets left the way it would be done without the board, a scan of the whole map, against the board eating
+    // one and keeping the count as it goes
+    runner.Add("Pellets left (map scan)", [](Uint64 cIterations)
+    {
+        Uint64 sum = 0;
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            Uint32 cPellets = 0;
+            for (Uint32 cell = 0; cell < Constants::MapRows * Constants::MapCols; cell++)
+            {
+                Uint16 index = Constants::MapIndicies[cell];
+                cPellets += ((index == Constants::TileIndexPellet) || (index == Constants::TileIndexPowerPellet)) ? 1 : 0;
+            }
+            sum += cPellets;
+        }
+        BenchmarkSink(sum);
+    });
+
+    runner.Add("PelletBoard::Eat", [](Uint64 cIterations)
+    {
+        MemoryArena arena(c_cbBenchArena);
+        PelletBoard pellets(Constants::MapRows, Constants::MapCols, &arena);
+        pellets.Build(Constants::MapIndicies, Constants::TileIndexPellet, Constants::TileIndexPowerPellet, Constants::TileIndexEmpty);
+        Uint64 sum = 0;
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            // Walks every cell, so the board is cleared and reset every few thousand iterations
+            Uint32 cell = static_cast<Uint32>(i % (Constants::MapRows * Constants::MapCols));
+            sum += static_cast<Uint64>(pellets.Eat(cell / Constants::MapCols, cell % Constants::MapCols)) + pellets.Remaining();
+            if (pellets.IsCleared())
+            {
+                pellets.Reset(nullptr, nullptr);
+            }
+        }
+        BenchmarkSink(sum);
+    });
+
+    runner.Add("PelletBoard::Reset", [](Uint64 cIterations)
+    {
+        MemoryArena arena(c_cbBenchArena);
+        PelletBoard pellets(Constants::MapRows, Constants::MapCols, &arena);
+        pellets.Build(Constants::MapIndicies, Constants::TileIndexPellet, Constants::TileIndexPowerPellet, Constants::TileIndexEmpty);
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            pellets.Reset(nullptr, nullptr);
+        }
+        BenchmarkSink(pellets.Remaining());
+    });
+
+    runner.Add("DoPlayerBoundsCheck", [](Uint64 cIterations)
+    {
+        Sprite *pSprite = CreateBenchPlayer(s_entityStore, s_tiledMap);
+        SDL_Point startPoint = s_tiledMap.GetTileCoordinates(Constants::PlayerStartRow, Constants::PlayerStartCol);
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            // Alternate directions so every branch is taken, and keep the position fixed so the velocity is
+            // reset to something non-zero each time
+            Fixed speed = (i & 1) ? Constants::PlayerSpeed : -Constants::PlayerSpeed;
+            pSprite->SetVelocity((i & 2) ? speed : 0, (i & 2) ? 0 : speed);
+            pSprite->ResetPosition(FixedFromInt(startPoint.x + static_cast<int>(i % 16)), FixedFromInt(startPoint.y));
+            DoPlayerBoundsCheck(pSprite, &s_tiledMap, &s_collisionGrid);
+        }
+        BenchmarkSink(static_cast<Uint64>(pSprite->DX() + 2));
+        delete pSprite;
+    });
+
+    runner.Add("Sprite::Update", [](Uint64 cIterations)
+    {
+        Sprite *pSprite = CreateBenchPlayer(s_entityStore, s_tiledMap);
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            pSprite->Update();
+        }
+        BenchmarkSink(static_cast<Uint64>(pSprite->X()));
+        delete pSprite;
+    });
+
+    // Bulk update of a store full of animated actors running into the maze's walls, reported per actor
+    auto AddUpdateAllBenchmark = [&runner](const char *szName, Uint32 cActors)
+    {
+        runner.Add(szName, [cActors](Uint64 cIterations)
+        {
+            MemoryArena arena(c_cbBenchArena);
+            EntityStore entityStore(cActors, &arena);
+            Sprite *pSheetOwner = CreateBenchPlayer(entityStore, s_tiledMap);
+            PopulateBenchStore(entityStore, pSheetOwner, cActors);
+            PlaceBenchActors(entityStore, s_tiledMap, s_collisionGrid);
+
+            // Each call moves every actor, so one "op" is one actor
+            for (Uint64 i = 0; i < cIterations; i += cActors)
+            {
+                entityStore.UpdateAll();
+            }
+            BenchmarkSink(static_cast<Uint64>(entityStore.X()[cActors - 1]));
+            delete pSheetOwner;
+        });
+    };
+    AddUpdateAllBenchmark("EntityStore::UpdateAll/1k (per actor)", 1000);
+    AddUpdateAllBenchmark("EntityStore::UpdateAll/8k (per actor)", 8000);
+
+    // Serially, then split into jobs across 2, 4, 8 and 16 threads (the caller plus workers), in mazes full of actors
+    // running into walls.  Both counts are past EntityStore::c_minParallelEntities, the larger is a full store.  Past
+    // the core count the extra threads only add overhead.  The pools live for the whole run so thread start up isn't
+    // measured
+    static ThreadPool *s_ppThreadPools[] =
+    {
+        new ThreadPool(1, Constants::ThreadPoolMaxQueuedTasks),
+        new ThreadPool(3, Constants::ThreadPoolMaxQueuedTasks),
+        new ThreadPool(7, Constants::ThreadPoolMaxQueuedTasks),
+        new ThreadPool(15, Constants::ThreadPoolMaxQueuedTasks),
+    };
+    const Uint32 cThreadPools = sizeof(s_ppThreadPools) / sizeof(s_ppThreadPools[0]);
+    VerifyWallCollision(s_tiledMap, s_collisionGrid);
+    VerifyParallelUpdate(s_tiledMap, s_collisionGrid, s_ppThreadPools, cThreadPools);
+
+    static const Uint32 c_parallelActorCounts[] = { 16 * 1024, EntityStore::c_maxEntities };
+    for (Uint32 cParallelActors : c_parallelActorCounts)
+    {
+        // Filling a store this big takes longer than updating it, so it's built once for the whole run and the
+        // timed part only puts everyone back where they started
+        MemoryArena *pArena = new MemoryArena(c_cbBenchArena);
+        EntityStore *pEntityStore = new EntityStore(cParallelActors, pArena);
+        PopulateBenchStore(*pEntityStore, CreateBenchPlayer(*pEntityStore, s_tiledMap), cParallelActors);
+
+        for (Uint32 i = 0; i <= cThreadPools; i++)
+        {
+            ThreadPool *pThreadPool = (i == 0) ? nullptr : s_ppThreadPools[i - 1];
+            char szName[96];
+            SDL_snprintf(szName, sizeof(szName), "EntityStore::UpdateAll/%uk, %u thread(s) (per actor)", cParallelActors / 1024,
+                (pThreadPool != nullptr) ? pThreadPool->WorkerCount() + 1 : 1);
+            runner.Add(szName, [pEntityStore, pThreadPool, cParallelActors](Uint64 cIterations)
+            {
+                PlaceBenchActors(*pEntityStore, s_tiledMap, s_collisionGrid);
+                for (Uint64 i = 0; i < cIterations; i += cParallelActors)
+                {
+                    if (pThreadPool != nullptr)
+                    {
+                        pEntityStore->UpdateAll(pThreadPool);
+                    }
+                    else
+                    {
+                        pEntityStore->UpdateAll();
+                    }
+                }
+                BenchmarkSink(static_cast<Uint64>(pEntityStore->X()[cParallelActors - 1]));
+            });
+        }
+    }
+
+    runner.Add("AnimationLibrary::FrameAt", [](Uint64 cIterations)
+    {
+        AnimationLibrary animations(4, 64);
+        Uint16 loop = animations.AddClip(Constants::PlayerAnimation_LEFT, Constants::PlayerAnimationFrameCount, AnimationType::Loop, Constants::PlayerAnimationSpeed);
+        Uint16 once = animations.AddClip(Constants::PlayerAnimation_DEATH, Constants::PlayerAnimationDeathFrameCount, AnimationType::Once, Constants::PlayerAnimationSpeed);
+        Uint64 sum = 0;
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            sum += animations.FrameAt((i & 1) ? loop : once, static_cast<Uint32>(i));
+        }
+        BenchmarkSink(sum);
+    });
+
+    // Thousands of actors sharing a few clips, started at different ticks.  The update works out every frame, drawing
+    // only reads them back
+    runner.Add("EntityStore::CurrentFrame/8k (per actor)", [](Uint64 cIterations)
+    {
+        const Uint32 cActors = 8192;
+        MemoryArena arena(c_cbBenchArena);
+        EntityStore entityStore(cActors, &arena);
+        Sprite *pSheetOwner = CreateBenchPlayer(entityStore, s_tiledMap);
+        PopulateBenchStore(entityStore, pSheetOwner, cActors);
+        Uint64 sum = 0;
+        for (Uint64 i = 0; i < cIterations; i += cActors)
+        {
+            entityStore.UpdateAll();
+            for (Uint32 index = 0; index < cActors; index++)
+            {
+                sum += entityStore.CurrentFrame(index);
+            }
+        }
+        BenchmarkSink(sum);
+        delete pSheetOwner;
+    });
+
+    // Sprites coming and going during play, from the heap and from a pool in the level arena
+    static Uint16 s_staticSheet = s_entityStore.CreateSheet(nullptr, Constants::PlayerSpriteWidth, Constants::PlayerSpriteHeight, 1, 0);
+    runner.Add("Sprite new/delete", [](Uint64 cIterations)
+    {
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            Sprite *pSprite = new Sprite(&s_entityStore, s_staticSheet);
+            BenchmarkSink(pSprite->Handle());
+            delete pSprite;
+        }
+    });
+
+    runner.Add("ObjectPool<Sprite>::Create/Destroy", [](Uint64 cIterations)
+    {
+        MemoryArena arena(c_cbBenchArena);
+        ObjectPool<Sprite> sprites(&arena, Constants::MaxSprites);
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            Sprite *pSprite = sprites.Create(&s_entityStore, s_staticSheet);
+            BenchmarkSink(pSprite->Handle());
+            sprites.Destroy(pSprite);
+        }
+    });
+
+    // A level's worth of map set up and torn down, the teardown is an arena Reset
+    runner.Add("TiledMap::Initialize", [](Uint64 cIterations)
+    {
+        MemoryArena arena(c_cbBenchArena);
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            arena.Reset();
+            TiledMap tiledMap(Constants::MapRows, Constants::MapCols, Constants::ScreenWidth, Constants::ScreenHeight, &arena);
+            InitializeBenchMap(tiledMap);
+            BenchmarkSink(tiledMap.GetMapBounds().w);
+        }
+    });
+}
@@ -0,0 +1,110 @@
+#include <vector>
+#include "benchmark.h"
+#include "collisiongrid.h"
+#include "constants.h"
+#include "flowfield.h"
+#include "threadpool.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+// A maze much bigger than the arcade one, walls on every other cell of every other row so most of it is open
+static const Uint16 c_bigMazeSize = 256;
+
+// Every target moves to another tile every iteration, so every field is rebuilt each Update.  That's the worst case,
+// in the game most targets stay on their tile for several ticks
+static void RegisterUpdate(BenchmarkRunner &runner, const char *szMap, CollisionGrid *pCollisionGrid, const std::vector<SDL_Point> *pOpenCells, ThreadPool *pThreadPool)
+{
+    char szName[96];
+    SDL_snprintf(szName, sizeof(szName), "FlowFieldService::Update (%s, %u targets, %u worker(s))", szMap, Constants::FlowFieldMaxTargets, pThreadPool->WorkerCount());
+    runner.Add(szName, [pCollisionGrid, pOpenCells, pThreadPool](Uint64 cIterations)
+    {
+        FlowFieldService flowFields(pCollisionGrid, pThreadPool, Constants::FlowFieldMaxTargets);
+        Uint32 cCells = static_cast<Uint32>(pOpenCells->size());
+        Uint64 sum = 0;
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            for (Uint32 slot = 0; slot < Constants::FlowFieldMaxTargets; slot++)
+            {
+                const SDL_Point &target = (*pOpenCells)[((i * Constants::FlowFieldMaxTargets) + (slot * 97)) % cCells];
+                flowFields.SetTarget(slot, target.y, target.x);
+            }
+            sum += flowFields.Update();
+        }
+        BenchmarkSink(sum + flowFields.Field(0)[0]);
+    });
+}
+
+void RegisterFlowFieldBenchmarks(BenchmarkRunner &runner)
+{
+    static CollisionGrid s_collisionGrid(Constants::MapRows, Constants::MapCols);
+    static CollisionGrid s_bigCollisionGrid(c_bigMazeSize, c_bigMazeSize);
+    static std::vector<SDL_Point> s_openCells;
+    static std::vector<SDL_Point> s_bigOpenCells;
+    s_collisionGrid.Build(Constants::CollisionMap);
+
+    std::vector<Uint16> bigMaze(c_bigMazeSize * c_bigMazeSize);
+    for (Uint16 r = 0; r < c_bigMazeSize; r++)
+    {
+        for (Uint16 c = 0; c < c_bigMazeSize; c++)
+        {
+            bigMaze[(r * c_bigMazeSize) + c] = ((r & 1) && (c & 1)) ? 1 : 0;
+        }
+    }
+    s_bigCollisionGrid.Build(bigMaze.data());
+
+    for (Uint16 r = 0; r < Constants::MapRows; r++)
+    {
+        for (Uint16 c = 0; c < Constants::MapCols; c++)
+        {
+            if (s_collisionGrid.IsWalkable(r, c))
+            {
+                s_openCells.push_back({ c, r });
+            }
+        }
+    }
+    for (Uint16 r = 0; r < c_bigMazeSize; r++)
+    {
+        for (Uint16 c = 0; c < c_bigMazeSize; c++)
+        {
+            if (s_bigCollisionGrid.IsWalkable(r, c))
+            {
+                s_bigOpenCells.push_back({ c, r });
+            }
+        }
+    }
+
+    // Same work on no workers (everything on this thread), one, and then doubling up to every core.  The pools live
+    // for the whole run so thread start up isn't measured
+    static std::vector<ThreadPool*> s_threadPools;
+    Uint32 cMaxWorkers = static_cast<Uint32>(SDL_max(SDL_GetCPUCount() - 1, 1));
+    s_threadPools.push_back(new ThreadPool(0, Constants::ThreadPoolMaxQueuedTasks));
+    for (Uint32 cWorkers = 1; cWorkers < cMaxWorkers; cWorkers *= 2)
+    {
+        s_threadPools.push_back(new ThreadPool(cWorkers, Constants::ThreadPoolMaxQueuedTasks));
+    }
+    s_threadPools.push_back(new ThreadPool(cMaxWorkers, Constants::ThreadPoolMaxQueuedTasks));
+    for (ThreadPool *pThreadPool : s_threadPools)
+    {
+        RegisterUpdate(runner, "arcade maze", &s_collisionGrid, &s_openCells, pThreadPool);
+    }
+    for (ThreadPool *pThreadPool : s_threadPools)
+    {
+        RegisterUpdate(runner, "256x256 maze", &s_bigCollisionGrid, &s_bigOpenCells, pThreadPool);
+    }
+
+    // Same target every time, the fields are reused and Update is just the check
+    runner.Add("FlowFieldService::Update (targets unchanged)", [](Uint64 cIterations)
+    {
+        FlowFieldService flowFields(&s_collisionGrid, s_threadPools[0], Constants::FlowFieldMaxTargets);
+        for (Uint32 slot = 0; slot < Constants::FlowFieldMaxTargets; slot++)
+        {
+            flowFields.SetTarget(slot, s_openCells[slot].y, s_openCells[slot].x);
+        }
+        Uint64 sum = 0;
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            sum += flowFields.Update();
+        }
+        BenchmarkSink(sum);
+    });
+}
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <vector>
+#include "benchmark.h"
+#include "constants.h"
+#include "memoryarena.h"
+#include "movementkernel.h"
+#include "tiledmap.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+// N actors scattered over (and a little past) the map, each moving along one axis at player speed.  Scattered
+// starts mean a good share of them are inside walls or heading into one, so both outcomes of the check get
+// exercised
+class MovementActors
+{
+public:
+    MovementActors(const SDL_Rect &bounds, Uint32 cActors) :
+        _x(cActors), _y(cActors), _dx(cActors), _dy(cActors), _xPrevious(cActors), _yPrevious(cActors)
+    {
+        Uint32 seed = 0x5EED + cActors;
+        for (Uint32 i = 0; i < cActors; i++)
+        {
+            // xorshift32, same generator ScriptedInput uses
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            _x[i] = FixedFromInt(bounds.x - 16 + static_cast<int>(seed % (bounds.w + 32))) + (((seed >> 24) & 1) * (FixedOne / 2));
+            _y[i] = FixedFromInt(bounds.y - 16 + static_cast<int>((seed >> 8) % (bounds.h + 32)));
+            Fixed speed = ((seed >> 28) & 1) ? Constants::PlayerSpeed : -Constants::PlayerSpeed;
+            _dx[i] = ((seed >> 29) & 1) ? speed : 0;
+            _dy[i] = ((seed >> 29) & 1) ? 0 : speed;
+        }
+    }
+
+    MovementBatch Batch()
+    {
+        return { _x.data(), _y.data(), _dx.data(), _dy.data(), _xPrevious.data(), _yPrevious.data(), static_cast<Uint32>(_x.size()) };
+    }
+
+    bool operator==(const MovementActors &other) const
+    {
+        size_t cb = _x.size() * sizeof(Fixed);
+        return (SDL_memcmp(_x.data(), other._x.data(), cb) == 0) && (SDL_memcmp(_y.data(), other._y.data(), cb) == 0) &&
+            (SDL_memcmp(_dx.data(), other._dx.data(), cb) == 0) && (SDL_memcmp(_dy.data(), other._dy.data(), cb) == 0) &&
+            (SDL_memcmp(_xPrevious.data(), other._xPrevious.data(), cb) == 0) && (SDL_memcmp(_yPrevious.data(), other._yPrevious.data(), cb) == 0);
+    }
+
+private:
+    std::vector<Fixed> _x;
+    std::vector<Fixed> _y;
+    std::vector<Fixed> _dx;
+    std::vector<Fixed> _dy;
+    std::vector<Fixed> _xPrevious;
+    std::vector<Fixed> _yPrevious;
+};
+
+// Run every available path from the same start and make sure they agree bit for bit with the scalar one.  An odd
+// actor count leaves a remainder for the scalar tail to pick up
+static bool VerifyKernelPaths(const SDL_Rect &bounds, const MovementKernelMap &kernelMap, KernelPath bestPath)
+{
+    const Uint32 cActors = 10007;
+    const Uint32 cSteps = 300;
+
+    MovementActors reference(bounds, cActors);
+    MovementBatch referenceBatch = reference.Batch();
+    for (Uint32 step = 0; step < cSteps; step++)
+    {
+        MoveAndCollide(referenceBatch, kernelMap, KernelPath::Scalar);
+    }
+
+    bool fResult = true;
+    for (int path = static_cast<int>(KernelPath::SSE2); path <= static_cast<int>(bestPath); path++)
+    {
+        MovementActors actors(bounds, cActors);
+        MovementBatch batch = actors.Batch();
+        for (Uint32 step = 0; step < cSteps; step++)
+        {
+            MoveAndCollide(batch, kernelMap, static_cast<KernelPath>(path));
+        }
+
+        bool fMatch = (actors == reference);
+        printf("MoveAndCollide %s vs scalar: %s\n", KernelPathName(static_cast<KernelPath>(path)), fMatch ? "bit-identical" : "MISMATCH");
+        fResult &= fMatch;
+    }
+    return fResult;
+}
+
+void RegisterMovementBenchmarks(BenchmarkRunner &runner)
+{
+    static MemoryArena s_arena(64 * 1024);
+    static TiledMap s_tiledMap(Constants::MapRows, Constants::MapCols, Constants::ScreenWidth, Constants::ScreenHeight, &s_arena);
+    static MovementKernelMap s_kernelMap;
+
+    SDL_Rect textureRect = { 0, 0, Constants::TileTextureWidth, Constants::TileTextureHeight };
+    SDL_Rect tileRect = { 0, 0, Constants::TileWidth, Constants::TileHeight };
+    s_tiledMap.Initialize(textureRect, tileRect, nullptr, Constants::MapIndicies, Constants::MapRows * Constants::MapCols);
+    if (!InitializeMovementKernelMap(s_kernelMap, &s_tiledMap, Constants::CollisionMap,
+        (Constants::PlayerSpriteWidth / 2) - Constants::TileWidth / 2, (Constants::PlayerSpriteHeight / 2) - Constants::TileHeight / 2))
+    {
+        return;
+    }
+
+    KernelPath bestPath = BestKernelPath();
+    printf("MoveAndCollide best path on this machine: %s\n", KernelPathName(bestPath));
+    SDL_Rect bounds = s_tiledMap.GetMapBounds();
+    VerifyKernelPaths(bounds, s_kernelMap, bestPath);
+
+    // Reported per actor.  Everyone stops at a wall or wanders off the map after a while, so put the actors back
+    // every few steps to keep the mix of blocked and moving actors realistic
+    auto AddMoveAndCollideBenchmark = [&runner, bounds](const char *szName, Uint32 cActors, KernelPath path)
+    {
+        runner.Add(szName, [bounds, cActors, path](Uint64 cIterations)
+        {
+            const MovementActors start(bounds, cActors);
+            MovementActors actors = start;
+            MovementBatch batch = actors.Batch();
+            Uint32 cSteps = 0;
+            for (Uint64 i = 0; i < cIterations; i += cActors)
+            {
+                if (++cSteps == 64)
+                {
+                    actors = start;
+                    batch = actors.Batch();
+                    cSteps = 0;
+                }
+                MoveAndCollide(batch, s_kernelMap, path);
+            }
+            BenchmarkSink(static_cast<Uint64>(batch.pX[cActors - 1]));
+        });
+    };
+
+    AddMoveAndCollideBenchmark("MoveAndCollide/scalar/1k (per actor)", 1000, KernelPath::Scalar);
+    AddMoveAndCollideBenchmark("MoveAndCollide/scalar/10k (per actor)", 10000, KernelPath::Scalar);
+    AddMoveAndCollideBenchmark("MoveAndCollide/scalar/100k (per actor)", 100000, KernelPath::Scalar);
+    if (bestPath >= KernelPath::SSE2)
+    {
+        AddMoveAndCollideBenchmark("MoveAndCollide/sse2/1k (per actor)", 1000, KernelPath::SSE2);
+        AddMoveAndCollideBenchmark("MoveAndCollide/sse2/10k (per actor)", 10000, KernelPath::SSE2);
+        AddMoveAndCollideBenchmark("MoveAndCollide/sse2/100k (per actor)", 100000, KernelPath::SSE2);
+    }
+    if (bestPath >= KernelPath::AVX2)
+    {
+        AddMoveAndCollideBenchmark("MoveAndCollide/avx2/1k (per actor)", 1000, KernelPath::AVX2);
+        AddMoveAndCollideBenchmark("MoveAndCollide/avx2/10k (per actor)", 10000, KernelPath::AVX2);
+        AddMoveAndCollideBenchmark("MoveAndCollide/avx2/100k (per actor)", 100000, KernelPath::AVX2);
+    }
+}
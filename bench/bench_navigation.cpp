@@ -0,0 +1,125 @@
+#include <vector>
+#include "benchmark.h"
+#include "collisiongrid.h"
+#include "constants.h"
+#include "navigationtable.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+// What the table replaces, a breadth first search over the grid for every query
+static Uint16 SearchDistance(const CollisionGrid &collisionGrid, Uint16 fromRow, Uint16 fromCol, Uint16 toRow, Uint16 toCol, std::vector<Uint16> &distances, std::vector<Uint32> &queue)
+{
+    const Uint16 cRows = collisionGrid.Rows();
+    const Uint16 cCols = collisionGrid.Cols();
+    if (!collisionGrid.IsWalkable(fromRow, fromCol) || !collisionGrid.IsWalkable(toRow, toCol))
+    {
+        return NavigationTable::c_unreachable;
+    }
+
+    // Through a local, assign takes a reference and the constant has no definition to bind it to
+    const Uint16 unreachable = NavigationTable::c_unreachable;
+    distances.assign(cRows * cCols, unreachable);
+    Uint32 iHead = 0;
+    Uint32 iTail = 0;
+    distances[(fromRow * cCols) + fromCol] = 0;
+    queue[iTail++] = (fromRow * cCols) + fromCol;
+    while (iHead < iTail)
+    {
+        Uint32 cell = queue[iHead++];
+        Uint16 r = cell / cCols;
+        Uint16 c = cell % cCols;
+        if ((r == toRow) && (c == toCol))
+        {
+            return distances[cell];
+        }
+
+        Uint8 exits = collisionGrid.ExitsAt(r, c);
+        Uint32 up = (r == 0) ? (cRows - 1) : (r - 1);
+        Uint32 down = (r == (cRows - 1)) ? 0 : (r + 1);
+        Uint32 left = (c == 0) ? (cCols - 1) : (c - 1);
+        Uint32 right = (c == (cCols - 1)) ? 0 : (c + 1);
+        Uint32 neighbors[4] = { (up * cCols) + c, (down * cCols) + c, (r * cCols) + left, (r * cCols) + right };
+        for (int d = 0; d < 4; d++)
+        {
+            if ((exits & (1 << d)) && (distances[neighbors[d]] == NavigationTable::c_unreachable))
+            {
+                distances[neighbors[d]] = distances[cell] + 1;
+                queue[iTail++] = neighbors[d];
+            }
+        }
+    }
+    return NavigationTable::c_unreachable;
+}
+
+void RegisterNavigationBenchmarks(BenchmarkRunner &runner)
+{
+    static CollisionGrid s_collisionGrid(Constants::MapRows, Constants::MapCols);
+    static NavigationTable s_navigationTable;
+    static std::vector<SDL_Point> s_openCells;
+    s_collisionGrid.Build(Constants::CollisionMap);
+    s_navigationTable.Build(&s_collisionGrid);
+    for (Uint16 r = 0; r < Constants::MapRows; r++)
+    {
+        for (Uint16 c = 0; c < Constants::MapCols; c++)
+        {
+            if (s_collisionGrid.IsWalkable(r, c))
+            {
+                s_openCells.push_back({ c, r });
+            }
+        }
+    }
+
+    // Whole table, one search per open cell
+    runner.Add("NavigationTable::Build", [](Uint64 cIterations)
+    {
+        NavigationTable navigationTable;
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            navigationTable.Build(&s_collisionGrid);
+        }
+        BenchmarkSink(navigationTable.NodeCount());
+    });
+
+    // Pairs of open cells picked with a stride so they aren't all neighbors
+    runner.Add("NavigationTable::Distance", [](Uint64 cIterations)
+    {
+        Uint32 cCells = static_cast<Uint32>(s_openCells.size());
+        Uint64 sum = 0;
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            const SDL_Point &from = s_openCells[i % cCells];
+            const SDL_Point &to = s_openCells[(i * 97) % cCells];
+            sum += s_navigationTable.Distance(from.y, from.x, to.y, to.x);
+        }
+        BenchmarkSink(sum);
+    });
+
+    runner.Add("NavigationTable::NextDirection", [](Uint64 cIterations)
+    {
+        Uint32 cCells = static_cast<Uint32>(s_openCells.size());
+        Uint64 sum = 0;
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            const SDL_Point &from = s_openCells[i % cCells];
+            const SDL_Point &to = s_openCells[(i * 97) % cCells];
+            Direction direction = Direction::Up;
+            sum += s_navigationTable.NextDirection(from.y, from.x, to.y, to.x, direction) ? static_cast<int>(direction) : 4;
+        }
+        BenchmarkSink(sum);
+    });
+
+    runner.Add("Search per query (distance)", [](Uint64 cIterations)
+    {
+        std::vector<Uint16> distances;
+        std::vector<Uint32> queue(Constants::MapRows * Constants::MapCols);
+        Uint32 cCells = static_cast<Uint32>(s_openCells.size());
+        Uint64 sum = 0;
+        for (Uint64 i = 0; i < cIterations; i++)
+        {
+            const SDL_Point &from = s_openCells[i % cCells];
+            const SDL_Point &to = s_openCells[(i * 97) % cCells];
+            sum += SearchDistance(s_collisionGrid, from.y, from.x, to.y, to.x, distances, queue);
+        }
+        BenchmarkSink(sum);
+    });
+}
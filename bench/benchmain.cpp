@@ -0,0 +1,69 @@
+// benchmain.cpp : Entry point for the engine microbenchmarks (make bench)
+//
+#include <stdio.h>
+#include "SDL.h"
+#include "benchmark.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+// Each bench_*.cpp file registers its benchmarks here
+void RegisterEngineBenchmarks(BenchmarkRunner &runner);
+void RegisterMovementBenchmarks(BenchmarkRunner &runner);
+void RegisterNavigationBenchmarks(BenchmarkRunner &runner);
+void RegisterFlowFieldBenchmarks(BenchmarkRunner &runner);
+void RegisterBroadphaseBenchmarks(BenchmarkRunner &runner);
+
+// Usage: xplat-pmc-bench.exe [--filter text] [--save results.json] [--compare baseline.json] [--threshold percent]
+int main(int argc, char* argv[])
+{
+    const char *szSaveFileName = nullptr;
+    const char *szBaselineFileName = nullptr;
+    const char *szFilter = nullptr;
+    double thresholdPercent = 10.0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool fHasValue = (i + 1 < argc);
+        if ((SDL_strcmp(argv[i], "--save") == 0) && fHasValue)
+        {
+            szSaveFileName = argv[++i];
+        }
+        else if ((SDL_strcmp(argv[i], "--compare") == 0) && fHasValue)
+        {
+            szBaselineFileName = argv[++i];
+        }
+        else if ((SDL_strcmp(argv[i], "--filter") == 0) && fHasValue)
+        {
+            szFilter = argv[++i];
+        }
+        else if ((SDL_strcmp(argv[i], "--threshold") == 0) && fHasValue)
+        {
+            thresholdPercent = SDL_atof(argv[++i]);
+        }
+        else
+        {
+            printf("Usage: %s [--filter text] [--save results.json] [--compare baseline.json] [--threshold percent]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    BenchmarkRunner runner;
+    runner.SetFilter(szFilter);
+    RegisterEngineBenchmarks(runner);
+    RegisterMovementBenchmarks(runner);
+    RegisterNavigationBenchmarks(runner);
+    RegisterFlowFieldBenchmarks(runner);
+    RegisterBroadphaseBenchmarks(runner);
+    runner.RunAll();
+
+    int result = 0;
+    if ((szSaveFileName != nullptr) && !runner.SaveJson(szSaveFileName))
+    {
+        result = 1;
+    }
+    if ((szBaselineFileName != nullptr) && !runner.CompareWithBaseline(szBaselineFileName, thresholdPercent))
+    {
+        result = 2;
+    }
+    return result;
+}
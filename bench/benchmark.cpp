@@ -0,0 +1,157 @@
+#include "benchmark.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+static volatile Uint64 s_benchmarkSink = 0;
+
+void XplatGameTutorial::PacManClone::BenchmarkSink(Uint64 value)
+{
+    s_benchmarkSink = s_benchmarkSink + value;
+}
+
+BenchmarkRunner::BenchmarkRunner() :
+    _nsPerCounter(1e9 / static_cast<double>(SDL_GetPerformanceFrequency()))
+{
+}
+
+void BenchmarkRunner::Add(const char *szName, BenchmarkFunction function)
+{
+    Benchmark benchmark = { szName, function };
+    _benchmarks.push_back(benchmark);
+}
+
+// Wall time of a single repeat in nanoseconds
+double BenchmarkRunner::TimeRepeat(BenchmarkFunction &function, Uint64 cIterations)
+{
+    Uint64 startCounter = SDL_GetPerformanceCounter();
+    function(cIterations);
+    return (SDL_GetPerformanceCounter() - startCounter) * _nsPerCounter;
+}
+
+void BenchmarkRunner::RunAll()
+{
+    printf("%-40s %14s %14s %12s\n", "benchmark", "ns/op (p50)", "ns/op (min)", "iterations");
+    for (Benchmark &benchmark : _benchmarks)
+    {
+        if (!_filter.empty() && (benchmark.name.find(_filter) == std::string::npos))
+        {
+            continue;
+        }
+
+        // Grow the iteration count until a repeat is long enough to time reliably
+        const double nsTarget = c_msTargetRepeat * 1e6;
+        Uint64 cIterations = 1;
+        double nsRepeat = TimeRepeat(benchmark.function, cIterations);
+        while ((nsRepeat < nsTarget) && (cIterations < (1ull << 40)))
+        {
+            double scale = (nsRepeat > 0) ? SDL_min(nsTarget / nsRepeat, 10.0) : 10.0;
+            cIterations = static_cast<Uint64>(cIterations * SDL_max(scale * 1.1, 2.0));
+            nsRepeat = TimeRepeat(benchmark.function, cIterations);
+        }
+
+        for (Uint32 i = 0; i < c_cWarmupRepeats; i++)
+        {
+            TimeRepeat(benchmark.function, cIterations);
+        }
+
+        double nsPerOp[c_cRepeats];
+        for (Uint32 i = 0; i < c_cRepeats; i++)
+        {
+            nsPerOp[i] = TimeRepeat(benchmark.function, cIterations) / cIterations;
+        }
+        std::sort(nsPerOp, nsPerOp + c_cRepeats);
+
+        BenchmarkResult result = { benchmark.name, nsPerOp[c_cRepeats / 2], nsPerOp[0], cIterations };
+        _results.push_back(result);
+        printf("%-40s %14.2f %14.2f %12llu\n", result.name.c_str(), result.nsPerOpMedian, result.nsPerOpMin,
+            static_cast<unsigned long long>(result.cIterations));
+    }
+}
+
+bool BenchmarkRunner::SaveJson(const char *szFileName)
+{
+    FILE *pFile = fopen(szFileName, "w");
+    if (pFile == nullptr)
+    {
+        printf("BenchmarkRunner::SaveJson() : failed to open %s\n", szFileName);
+        return false;
+    }
+
+    fprintf(pFile, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < _results.size(); i++)
+    {
+        const BenchmarkResult &result = _results[i];
+        fprintf(pFile, "    { \"name\": \"%s\", \"ns_per_op\": %.4f, \"min_ns_per_op\": %.4f, \"iterations\": %llu }%s\n",
+            result.name.c_str(), result.nsPerOpMedian, result.nsPerOpMin, static_cast<unsigned long long>(result.cIterations),
+            (i + 1 < _results.size()) ? "," : "");
+    }
+    fprintf(pFile, "  ]\n}\n");
+    fclose(pFile);
+    printf("Saved %u results to %s\n", static_cast<Uint32>(_results.size()), szFileName);
+    return true;
+}
+
+// Only has to read back what SaveJson writes, so this just scans for name / ns_per_op pairs rather than being
+// a general JSON parser
+bool BenchmarkRunner::CompareWithBaseline(const char *szFileName, double thresholdPercent)
+{
+    FILE *pFile = fopen(szFileName, "rb");
+    if (pFile == nullptr)
+    {
+        printf("BenchmarkRunner::CompareWithBaseline() : failed to open %s\n", szFileName);
+        return false;
+    }
+    std::string json;
+    char buffer[4096];
+    size_t cbRead = 0;
+    while ((cbRead = fread(buffer, 1, sizeof(buffer), pFile)) > 0)
+    {
+        json.append(buffer, cbRead);
+    }
+    fclose(pFile);
+
+    std::vector<BenchmarkResult> baseline;
+    size_t position = 0;
+    while ((position = json.find("\"name\": \"", position)) != std::string::npos)
+    {
+        position += strlen("\"name\": \"");
+        size_t nameEnd = json.find('"', position);
+        size_t valuePosition = json.find("\"ns_per_op\": ", nameEnd);
+        if ((nameEnd == std::string::npos) || (valuePosition == std::string::npos))
+        {
+            break;
+        }
+        BenchmarkResult result = { json.substr(position, nameEnd - position), 0.0, 0.0, 0 };
+        result.nsPerOpMedian = strtod(json.c_str() + valuePosition + strlen("\"ns_per_op\": "), nullptr);
+        baseline.push_back(result);
+        position = valuePosition;
+    }
+
+    bool fResult = true;
+    printf("\nComparing against %s (regression threshold %.1f%%)\n", szFileName, thresholdPercent);
+    printf("%-40s %14s %14s %9s\n", "benchmark", "baseline", "current", "change");
+    for (const BenchmarkResult &result : _results)
+    {
+        auto it = std::find_if(baseline.begin(), baseline.end(),
+            [&result](const BenchmarkResult &other) { return other.name == result.name; });
+        if (it == baseline.end())
+        {
+            printf("%-40s %14s %14.2f %9s\n", result.name.c_str(), "-", result.nsPerOpMedian, "new");
+            continue;
+        }
+
+        double changePercent = ((result.nsPerOpMedian - it->nsPerOpMedian) / it->nsPerOpMedian) * 100.0;
+        bool fRegressed = changePercent > thresholdPercent;
+        printf("%-40s %14.2f %14.2f %+8.1f%%%s\n", result.name.c_str(), it->nsPerOpMedian, result.nsPerOpMedian,
+            changePercent, fRegressed ? "  REGRESSION" : "");
+        if (fRegressed)
+        {
+            fResult = false;
+        }
+    }
+    return fResult;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "SDL.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Keeps the optimizer from throwing away the work being measured
+    void BenchmarkSink(Uint64 value);
+
+    // A benchmark body runs the operation cIterations times
+    typedef std::function<void(Uint64 cIterations)> BenchmarkFunction;
+
+    struct BenchmarkResult
+    {
+        std::string name;
+        double nsPerOpMedian;   // What we compare on, the median is steadier than the mean
+        double nsPerOpMin;
+        Uint64 cIterations;     // Iterations per repeat after calibration
+    };
+
+    // Minimal harness: calibrate the iteration count so a repeat takes ~c_msTargetRepeat, warm up, then time
+    // c_cRepeats repeats and report ns/op.  Results can be saved as JSON and compared against a saved baseline
+    class BenchmarkRunner
+    {
+    public:
+        static const Uint32 c_cWarmupRepeats = 2;
+        static const Uint32 c_cRepeats = 15;
+        static const Uint32 c_msTargetRepeat = 20;
+
+        BenchmarkRunner();
+
+        // Only run benchmarks whose name contains the filter (nullptr runs everything)
+        void SetFilter(const char *szFilter) { _filter = (szFilter != nullptr) ? szFilter : ""; }
+        void Add(const char *szName, BenchmarkFunction function);
+        void RunAll();
+
+        const std::vector<BenchmarkResult>& Results() { return _results; }
+        bool SaveJson(const char *szFileName);
+        // Prints a side by side comparison, returns false if anything got slower by more than thresholdPercent
+        bool CompareWithBaseline(const char *szFileName, double thresholdPercent);
+
+    private:
+        struct Benchmark
+        {
+            std::string name;
+            BenchmarkFunction function;
+        };
+
+        double TimeRepeat(BenchmarkFunction &function, Uint64 cIterations);
+
+        std::string _filter;
+        std::vector<Benchmark> _benchmarks;
+        std::vector<BenchmarkResult> _results;
+        double _nsPerCounter;   // Nanoseconds per performance counter tick
+    };
+}
+}
@@ -0,0 +1,143 @@
+#include "include/collisiongrid.h"
+#include "include/bitscan.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+CollisionGrid::CollisionGrid(Uint16 rows, Uint16 cols) :
+    _cRows(rows),
+    _cCols(cols),
+    _cWordsPerRow((cols + 63) / 64),
+    _pWalkable(nullptr),
+    _pExits(nullptr)
+{
+    // Everything starts as a wall, including the extra row and cell that out of range lookups land on
+    _pWalkable = new Uint64[(_cRows + 1) * _cWordsPerRow] { };
+    _pExits = new Uint8[((_cRows * _cCols) + 2) / 2] { };
+}
+
+CollisionGrid::~CollisionGrid()
+{
+    delete[] _pExits;
+    delete[] _pWalkable;
+}
+
+void CollisionGrid::Build(const Uint16 *pCollisionMap)
+{
+    SDL_memset(_pWalkable, 0, (_cRows + 1) * _cWordsPerRow * sizeof(Uint64));
+    for (Uint16 r = 0; r < _cRows; r++)
+    {
+        Uint64 *pRow = &_pWalkable[r * _cWordsPerRow];
+        for (Uint16 c = 0; c < _cCols; c++)
+        {
+            pRow[c >> 6] |= static_cast<Uint64>(pCollisionMap[(r * _cCols) + c] == 0) << (c & 63);
+        }
+    }
+
+    for (Uint16 r = 0; r < _cRows; r++)
+    {
+        for (Uint16 c = 0; c < _cCols; c++)
+        {
+            SetExits(r, c);
+        }
+    }
+}
+
+void CollisionGrid::SetWalkable(Uint16 row, Uint16 col, bool fWalkable)
+{
+    if ((row >= _cRows) || (col >= _cCols))
+    {
+        return;
+    }
+
+    Uint64 &word = _pWalkable[(row * _cWordsPerRow) + (col >> 6)];
+    Uint64 bit = static_cast<Uint64>(1) << (col & 63);
+    word = fWalkable ? (word | bit) : (word & ~bit);
+
+    // Neighbours wrap the same way the exits do
+    SetExits(row, col);
+    SetExits((row + _cRows - 1) % _cRows, col);
+    SetExits((row + 1) % _cRows, col);
+    SetExits(row, (col + _cCols - 1) % _cCols);
+    SetExits(row, (col + 1) % _cCols);
+}
+
+// A wall has no exits, an open cell can go to each open neighbour.  Off the edge means the other side of the map
+void CollisionGrid::SetExits(Uint16 row, Uint16 col)
+{
+    Uint8 exits = 0;
+    if (IsWalkable(row, col))
+    {
+        exits |= IsWalkable((row == 0) ? (_cRows - 1) : (row - 1), col) ? ExitBit(Direction::Up) : 0;
+        exits |= IsWalkable((row == (_cRows - 1)) ? 0 : (row + 1), col) ? ExitBit(Direction::Down) : 0;
+        exits |= IsWalkable(row, (col == 0) ? (_cCols - 1) : (col - 1)) ? ExitBit(Direction::Left) : 0;
+        exits |= IsWalkable(row, (col == (_cCols - 1)) ? 0 : (col + 1)) ? ExitBit(Direction::Right) : 0;
+    }
+
+    Uint32 index = (row * _cCols) + col;
+    int shift = (index & 1) << 2;
+    _pExits[index >> 1] = static_cast<Uint8>((_pExits[index >> 1] & ~(0xF << shift)) | (exits << shift));
+}
+
+Uint16 CollisionGrid::CountWalkableInRow(Uint16 row) const
+{
+    int cWalkable = 0;
+    if (row < _cRows)
+    {
+        for (Uint32 w = 0; w < _cWordsPerRow; w++)
+        {
+            cWalkable += CountBits(_pWalkable[(row * _cWordsPerRow) + w]);
+        }
+    }
+    return static_cast<Uint16>(cWalkable);
+}
+
+Uint16 CollisionGrid::CountWalkableInCol(Uint16 col) const
+{
+    Uint16 cWalkable = 0;
+    for (Uint16 r = 0; r < _cRows; r++)
+    {
+        cWalkable += IsWalkable(r, col) ? 1 : 0;
+    }
+    return cWalkable;
+}
+
+// Left/right look for the nearest wall bit a word at a time, the padding past the last column reads as a wall
+Uint16 CollisionGrid::RunLength(Uint16 row, Uint16 col, Direction direction) const
+{
+    if ((row >= _cRows) || (col >= _cCols))
+    {
+        return 0;
+    }
+
+    const Uint64 *pRow = &_pWalkable[row * _cWordsPerRow];
+    if (direction == Direction::Right)
+    {
+        Uint32 w = col >> 6;
+        Uint64 walls = ~pRow[w] & ~((static_cast<Uint64>(2) << (col & 63)) - 1);  // Only the bits after col
+        while ((walls == 0) && (++w < _cWordsPerRow))
+        {
+            walls = ~pRow[w];
+        }
+        int wallCol = (walls == 0) ? _cCols : SDL_min(static_cast<int>((w << 6) + LowestBit(walls)), static_cast<int>(_cCols));
+        return static_cast<Uint16>(wallCol - col - 1);
+    }
+    else if (direction == Direction::Left)
+    {
+        int w = col >> 6;
+        Uint64 walls = ~pRow[w] & ((static_cast<Uint64>(1) << (col & 63)) - 1);    // Only the bits before col
+        while ((walls == 0) && (--w >= 0))
+        {
+            walls = ~pRow[w];
+        }
+        int wallCol = (walls == 0) ? -1 : ((w << 6) + HighestBit(walls));
+        return static_cast<Uint16>(col - wallCol - 1);
+    }
+
+    int step = (direction == Direction::Down) ? 1 : -1;
+    Uint16 cRun = 0;
+    for (int r = row + step; (r >= 0) && (r < _cRows) && IsWalkable(r, col); r += step)
+    {
+        cRun++;
+    }
+    return cRun;
+}
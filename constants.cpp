@@ -4,11 +4,14 @@ namespace XplatGameTutorial
 {
 namespace PacManClone
 {
-    const Uint32 Constants::TicksPerFrame = Constants::c_msPerFrame;        // Alias
+    const Fixed Constants::PlayerSpeed = (3 * FixedOne) / 2;                // 1.5, ~90 px/s at 60 steps a second
     const SDL_Color Constants::SDLColorGrey = { 128, 128, 128, 255 };       // Grey used for "background"
     const SDL_Color Constants::SDLColorMagenta = { 0xFF, 0, 0xFF, 0 };      // Color Key used for transparency
     const SDL_Color Constants::RenderDrawColor = Constants::SDLColorGrey;   // sets background when renderer cleared
     const char * const Constants::WindowTitle = "Pac-Man Clone";
+    const char * const Constants::ProfileCsvFileName = "./frametimes.csv";
+    const char * const Constants::AtlasCacheFileName = "./grfx/atlas.cache";
+    const char * const Constants::AssetPackFileName = "./grfx/assets.pak";
 
     // This is the map data for the tiles, each index represents a different tile to render
     Uint16 Constants::MapIndicies[MapRows * MapCols] =
@@ -0,0 +1,547 @@
+#include "include/entitystore.h"
+#include <stdio.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+EntityStore::EntityStore(Uint32 cMaxEntities, MemoryArena *pLevelArena) :
+    _cMaxEntities(cMaxEntities),
+    _cEntities(0),
+    _cFreeSlots(0),
+    _cSheets(0),
+    _pLevelArena(pLevelArena),
+    _animations(c_maxClips, c_maxClipFrames),
+    _clock(0),
+    _pCollisionGrid(nullptr),
+    _xMap(0),
+    _yMap(0),
+    _cxMap(0),
+    _cyMap(0),
+    _tileSize(0),
+    _tileShift(0)
+{
+    static_assert(c_minParallelEntities <= c_maxEntities, "the parallel update has to be reachable by a full store");
+    SDL_assert((cMaxEntities > 0) && (cMaxEntities <= c_maxEntities));
+
+    _pX = new Fixed[_cMaxEntities];
+    _pY = new Fixed[_cMaxEntities];
+    _pDX = new Fixed[_cMaxEntities];
+    _pDY = new Fixed[_cMaxEntities];
+    _pXPrevious = new Fixed[_cMaxEntities];
+    _pYPrevious = new Fixed[_cMaxEntities];
+    _pClip = new Uint16[_cMaxEntities];
+    _pAnimationStart = new Uint32[_cMaxEntities];
+    _pAnimation = new Uint16[_cMaxEntities];
+    _pFrame = new Uint16[_cMaxEntities];
+    _pWallCollision = new SDL_bool[_cMaxEntities];
+    _pSheet = new Uint16[_cMaxEntities];
+    _pStaticFrame = new Uint16[_cMaxEntities];
+    _pFrameOffsetX = new Sint16[_cMaxEntities];
+    _pFrameOffsetY = new Sint16[_cMaxEntities];
+    _pLayer = new Uint16[_cMaxEntities];
+    _pVisible = new SDL_bool[_cMaxEntities];
+
+    _pIndexToSlot = new Uint32[_cMaxEntities];
+    _pSlotToIndex = new Uint32[_cMaxEntities];
+    _pGeneration = new Uint16[_cMaxEntities] { };
+    _pFreeSlots = new Uint32[_cMaxEntities];
+
+    // Hand out low slots first
+    for (Uint32 i = 0; i < _cMaxEntities; i++)
+    {
+        _pFreeSlots[i] = _cMaxEntities - 1 - i;
+    }
+    _cFreeSlots = _cMaxEntities;
+
+    SDL_memset(_sheets, 0, sizeof(_sheets));
+}
+
+EntityStore::~EntityStore()
+{
+    // The sheets go with the level arena
+    delete[] _pFreeSlots;
+    delete[] _pGeneration;
+    delete[] _pSlotToIndex;
+    delete[] _pIndexToSlot;
+
+    delete[] _pVisible;
+    delete[] _pLayer;
+    delete[] _pFrameOffsetY;
+    delete[] _pFrameOffsetX;
+    delete[] _pStaticFrame;
+    delete[] _pSheet;
+    delete[] _pWallCollision;
+    delete[] _pFrame;
+    delete[] _pAnimation;
+    delete[] _pAnimationStart;
+    delete[] _pClip;
+    delete[] _pYPrevious;
+    delete[] _pXPrevious;
+    delete[] _pDY;
+    delete[] _pDX;
+    delete[] _pY;
+    delete[] _pX;
+}
+
+Uint16 EntityStore::CreateSheet(TextureWrapper *pTextureWrapper, Uint16 cxFrame, Uint16 cyFrame, Uint16 cFramesTotal, Uint16 cAnimationsTotal)
+{
+    if (_cSheets == c_maxSheets)
+    {
+        printf("EntityStore::CreateSheet() : out of sheets (%u), share one between sprites instead\n", c_maxSheets);
+        return InvalidSheet;
+    }
+
+    SpriteSheet &spriteSheet = _sheets[_cSheets];
+    spriteSheet.pTextureWrapper = pTextureWrapper;
+    spriteSheet.sourceRect = { 0, 0, 0, 0 };
+    if (pTextureWrapper != nullptr)
+    {
+        spriteSheet.sourceRect.w = pTextureWrapper->Width();
+        spriteSheet.sourceRect.h = pTextureWrapper->Height();
+    }
+    spriteSheet.cxFrame = cxFrame;
+    spriteSheet.cyFrame = cyFrame;
+    spriteSheet.cFramesTotal = cFramesTotal;
+    spriteSheet.pFrames = nullptr;
+    spriteSheet.cAnimationsTotal = cAnimationsTotal;
+    spriteSheet.pClips = nullptr;
+    return _cSheets++;
+}
+
+// Loads a single frame at the given coordinates on the texture to the specifed index
+bool EntityStore::LoadFrame(Uint16 sheet, Uint16 frameIndex, Uint16 xTexture, Uint16 yTexture)
+{
+    // A Sprite whose sheet couldn't be created ends up here with InvalidSheet
+    if (sheet >= _cSheets)
+    {
+        printf("EntityStore::LoadFrame() : no sheet %u\n", sheet);
+        return false;
+    }
+
+    SpriteSheet &spriteSheet = _sheets[sheet];
+
+    // We've made several assumption in the implementation, so validate them
+    SDL_assert((spriteSheet.pTextureWrapper != nullptr) && (!spriteSheet.pTextureWrapper->IsNull()));
+    SDL_assert(spriteSheet.cxFrame > 0);
+    SDL_assert(spriteSheet.cyFrame > 0);
+    SDL_assert(spriteSheet.cFramesTotal > 0);
+
+    bool fResult = true;
+
+    // Index bounds check
+    if (frameIndex >= spriteSheet.cFramesTotal)
+    {
+        printf("EntityStore::LoadFrame() : frame index out of range\n");
+        fResult = false;
+    }
+
+    // Texture bounds check
+    if ((xTexture + spriteSheet.cxFrame > spriteSheet.sourceRect.w) ||
+        (yTexture + spriteSheet.cyFrame > spriteSheet.sourceRect.h))
+    {
+        printf("EntityStore::LoadFrame() : frame bounds out of range {x:%d y:%d w:%d h:%d}\n",
+            xTexture, yTexture, spriteSheet.sourceRect.w, spriteSheet.sourceRect.h);
+        fResult = false;
+    }
+
+    if (fResult)
+    {
+        // On first frame load, allocate the frames
+        if (spriteSheet.pFrames == nullptr)
+        {
+            spriteSheet.pFrames = _pLevelArena->AllocateArray<SDL_Rect>(spriteSheet.cFramesTotal);
+            if (spriteSheet.pFrames == nullptr)
+            {
+                return false;
+            }
+        }
+
+        spriteSheet.pFrames[frameIndex].x = spriteSheet.sourceRect.x + xTexture;
+        spriteSheet.pFrames[frameIndex].y = spriteSheet.sourceRect.y + yTexture;
+        spriteSheet.pFrames[frameIndex].w = spriteSheet.cxFrame; // Every frame in the sheet is the same size
+        spriteSheet.pFrames[frameIndex].h = spriteSheet.cyFrame;
+    }
+    return fResult;
+}
+
+// Point the sheet at a new texture area, shifting any frames already loaded by the same amount
+void EntityStore::RemapSheet(Uint16 sheet, TextureWrapper *pTextureWrapper, const SDL_Rect &sourceRect)
+{
+    SpriteSheet &spriteSheet = _sheets[sheet];
+    if (spriteSheet.pFrames != nullptr)
+    {
+        int dx = sourceRect.x - spriteSheet.sourceRect.x;
+        int dy = sourceRect.y - spriteSheet.sourceRect.y;
+        for (Uint16 i = 0; i < spriteSheet.cFramesTotal; i++)
+        {
+            // Frames never loaded are still empty, leave them that way
+            if (spriteSheet.pFrames[i].w > 0)
+            {
+                spriteSheet.pFrames[i].x += dx;
+                spriteSheet.pFrames[i].y += dy;
+            }
+        }
+    }
+    spriteSheet.pTextureWrapper = pTextureWrapper;
+    spriteSheet.sourceRect = sourceRect;
+}
+
+void EntityStore::LoadAnimationSequence(Uint16 sheet, Uint16 index, AnimationType animationType, const int* pSequence, Uint16 cFramesInSequence, Uint16 animationSpeed)
+{
+    if (sheet >= _cSheets)
+    {
+        printf("EntityStore::LoadAnimationSequence() : no sheet %u\n", sheet);
+        return;
+    }
+
+    SpriteSheet &spriteSheet = _sheets[sheet];
+
+    // First time allocate the clip table, animations not loaded yet show the static frame
+    if (spriteSheet.pClips == nullptr)
+    {
+        spriteSheet.pClips = _pLevelArena->AllocateArray<Uint16>(spriteSheet.cAnimationsTotal);
+        if (spriteSheet.pClips == nullptr)
+        {
+            return;
+        }
+        for (Uint16 i = 0; i < spriteSheet.cAnimationsTotal; i++)
+        {
+            spriteSheet.pClips[i] = AnimationLibrary::c_noClip;
+        }
+    }
+
+    spriteSheet.pClips[index] = _animations.AddClip(pSequence, cFramesInSequence, animationType, animationSpeed);
+}
+
+EntityHandle EntityStore::Create(Uint16 sheet)
+{
+    if (_cFreeSlots == 0)
+    {
+        printf("EntityStore::Create() : store is full (%u entities)\n", _cMaxEntities);
+        return InvalidEntityHandle;
+    }
+    if (sheet >= _cSheets)
+    {
+        printf("EntityStore::Create() : no sheet %u\n", sheet);
+        return InvalidEntityHandle;
+    }
+
+    Uint32 slot = _pFreeSlots[--_cFreeSlots];
+    Uint32 index = _cEntities++;
+    _pSlotToIndex[slot] = index;
+    _pIndexToSlot[index] = slot;
+
+    // Same defaults a Sprite always had
+    _pX[index] = 0;
+    _pY[index] = 0;
+    _pDX[index] = 0;
+    _pDY[index] = 0;
+    _pXPrevious[index] = 0;
+    _pYPrevious[index] = 0;
+    // Animation 0 if the sheet has its animations already, otherwise whatever SetAnimation picks later
+    _pClip[index] = (_sheets[sheet].pClips != nullptr) ? _sheets[sheet].pClips[0] : AnimationLibrary::c_noClip;
+    _pAnimation[index] = (_sheets[sheet].pClips != nullptr) ? 0 : c_noAnimation;
+    _pAnimationStart[index] = _clock;
+    _pSheet[index] = sheet;
+    _pStaticFrame[index] = 0;
+    _pFrameOffsetX[index] = 0;
+    _pFrameOffsetY[index] = 0;
+    _pLayer[index] = 0;
+    _pVisible[index] = SDL_TRUE;
+    _pWallCollision[index] = SDL_FALSE;
+    _pFrame[index] = FrameAt(index, _clock);
+
+    return (static_cast<Uint32>(_pGeneration[slot]) << 16) | slot;
+}
+
+void EntityStore::Destroy(EntityHandle handle)
+{
+    if (!IsValid(handle))
+    {
+        return;
+    }
+
+    // Fill the hole with the last entity so the arrays stay packed
+    Uint32 slot = handle & 0xFFFF;
+    Uint32 index = _pSlotToIndex[slot];
+    Uint32 last = --_cEntities;
+    if (index != last)
+    {
+        _pX[index] = _pX[last];
+        _pY[index] = _pY[last];
+        _pDX[index] = _pDX[last];
+        _pDY[index] = _pDY[last];
+        _pXPrevious[index] = _pXPrevious[last];
+        _pYPrevious[index] = _pYPrevious[last];
+        _pClip[index] = _pClip[last];
+        _pAnimationStart[index] = _pAnimationStart[last];
+        _pAnimation[index] = _pAnimation[last];
+        _pFrame[index] = _pFrame[last];
+        _pWallCollision[index] = _pWallCollision[last];
+        _pSheet[index] = _pSheet[last];
+        _pStaticFrame[index] = _pStaticFrame[last];
+        _pFrameOffsetX[index] = _pFrameOffsetX[last];
+        _pFrameOffsetY[index] = _pFrameOffsetY[last];
+        _pLayer[index] = _pLayer[last];
+        _pVisible[index] = _pVisible[last];
+
+        Uint32 lastSlot = _pIndexToSlot[last];
+        _pIndexToSlot[index] = lastSlot;
+        _pSlotToIndex[lastSlot] = index;
+    }
+
+    _pGeneration[slot]++;
+    _pFreeSlots[_cFreeSlots++] = slot;
+}
+
+bool EntityStore::IsValid(EntityHandle handle)
+{
+    Uint32 slot = handle & 0xFFFF;
+    return (handle != InvalidEntityHandle) &&
+        (slot < _cMaxEntities) &&
+        (_pGeneration[slot] == (handle >> 16)) &&
+        (_pSlotToIndex[slot] < _cEntities) &&
+        (_pIndexToSlot[_pSlotToIndex[slot]] == slot);
+}
+
+void EntityStore::SetAnimation(Uint32 index, Uint16 animation)
+{
+    // If this isn't already the current animation
+    // Because if it is, you wanted ResetAnimation().  The index is compared, not the clip, another index on the
+    // sheet may have the same sequence and so the same clip
+    if (_pAnimation[index] != animation)
+    {
+        // Store it and start the sequence over from now
+        _pAnimation[index] = animation;
+        _pClip[index] = _sheets[_pSheet[index]].pClips[animation];
+        _pAnimationStart[index] = _clock;
+        _pFrame[index] = FrameAt(index, _clock);
+    }
+}
+
+void EntityStore::ResetAnimation(Uint32 index)
+{
+    _pAnimationStart[index] = _clock;
+    _pFrame[index] = FrameAt(index, _clock);
+}
+
+void EntityStore::SetStaticFrame(Uint32 index, Uint16 frame)
+{
+    // We're assuming this sheet has no animations, so assert it
+    SDL_assert(_sheets[_pSheet[index]].pClips == nullptr);
+    _pStaticFrame[index] = frame;
+    _pFrame[index] = frame;
+}
+
+void EntityStore::SetCollisionMap(TiledMap *pTiledMap, const CollisionGrid *pCollisionGrid)
+{
+    SDL_Rect mapBounds = pTiledMap->GetMapBounds();
+    _pCollisionGrid = pCollisionGrid;
+    _xMap = FixedFromInt(mapBounds.x);
+    _yMap = FixedFromInt(mapBounds.y);
+    _cxMap = FixedFromInt(mapBounds.w);
+    _cyMap = FixedFromInt(mapBounds.h);
+    _tileSize = pTiledMap->TileSize();
+    _tileShift = pTiledMap->TileShift();
+}
+
+void EntityStore::UpdateAll()
+{
+    UpdateRange(0, _cEntities);
+    SwapBuffers();
+    _clock++;
+}
+
+void EntityStore::UpdateAll(ThreadPool *pThreadPool)
+{
+    if (_cEntities < c_minParallelEntities)
+    {
+        UpdateAll();
+        return;
+    }
+
+    pThreadPool->ParallelFor((_cEntities + c_entitiesPerJob - 1) / c_entitiesPerJob, UpdateJob, this);
+    SwapBuffers();
+    _clock++;
+}
+
+void EntityStore::UpdateJob(void *pContext, Uint32 index)
+{
+    EntityStore *pThis = static_cast<EntityStore*>(pContext);
+    Uint32 first = index * c_entitiesPerJob;
+    pThis->UpdateRange(first, SDL_min(c_entitiesPerJob, pThis->_cEntities - first));
+}
+
+// The previous positions aren't needed any more, so they're where the next positions go.  After the swap the
+// positions from the start of the tick are the previous ones, just as if they had been copied
+void EntityStore::UpdateRange(Uint32 first, Uint32 count)
+{
+    // A straight pass over the position/velocity arrays first, the compiler can vectorize this
+    Uint32 end = first + count;
+    for (Uint32 i = first; i < end; i++)
+    {
+        _pXPrevious[i] = _pX[i] + _pDX[i];
+        _pYPrevious[i] = _pY[i] + _pDY[i];
+    }
+
+    if (_pCollisionGrid != nullptr)
+    {
+        for (Uint32 i = first; i < end; i++)
+        {
+            if (_pWallCollision[i] == SDL_TRUE)
+            {
+                CollideWithWalls(i);
+            }
+        }
+    }
+
+    // The clock only moves once every job is done, the frames are for the tick being written
+    Uint32 clock = _clock + 1;
+    for (Uint32 i = first; i < end; i++)
+    {
+        _pFrame[i] = FrameAt(i, clock);
+    }
+}
+
+// DoPlayerBoundsCheck for any entity, between the move and the swap.  The next position is in _pXPrevious/_pYPrevious
+// and the current one (the previous one after the swap) in _pX/_pY.  Only this entity's own state is written, so
+// it's safe from any job
+void EntityStore::CollideWithWalls(Uint32 index)
+{
+    Fixed x = _pXPrevious[index];
+    Fixed y = _pYPrevious[index];
+    Fixed xMapEnd = _xMap + _cxMap;
+    Fixed yMapEnd = _yMap + _cyMap;
+
+    // The only way off the map is a tunnel, come back in on the other side.  That's a jump, so the position it
+    // moved from goes with it (like Sprite::ResetPosition) and it isn't interpolated across the map
+    if ((x < _xMap) || (x >= xMapEnd) || (y < _yMap) || (y >= yMapEnd))
+    {
+        x += (x < _xMap) ? _cxMap : ((x >= xMapEnd) ? -_cxMap : 0);
+        y += (y < _yMap) ? _cyMap : ((y >= yMapEnd) ? -_cyMap : 0);
+        _pXPrevious[index] = x;
+        _pYPrevious[index] = y;
+        _pX[index] = x;
+        _pY[index] = y;
+    }
+
+    // The leading edge of the frame (less the transparent half tile) in the direction of travel
+    const SpriteSheet &spriteSheet = _sheets[_pSheet[index]];
+    Fixed xProbe = x;
+    Fixed yProbe = y;
+    if (_pDX[index] != 0)
+    {
+        Fixed reach = FixedFromInt((spriteSheet.cxFrame / 2) - (_tileSize / 2));
+        xProbe += (_pDX[index] < 0) ? -reach : reach;
+    }
+    else
+    {
+        Fixed reach = FixedFromInt((spriteSheet.cyFrame / 2) - (_tileSize / 2));
+        yProbe += (_pDY[index] < 0) ? -reach : reach;
+    }
+    xProbe += (xProbe < _xMap) ? _cxMap : ((xProbe >= xMapEnd) ? -_cxMap : 0);
+    yProbe += (yProbe < _yMap) ? _cyMap : ((yProbe >= yMapEnd) ? -_cyMap : 0);
+
+    // TiledMap::GetTileRowCol, a probe still off the map checks [0][0]
+    int row = (yProbe - _yMap) >> (FixedShift + _tileShift);
+    int col = (xProbe - _xMap) >> (FixedShift + _tileShift);
+    if ((row < 0) || (row >= _pCollisionGrid->Rows()) || (col < 0) || (col >= _pCollisionGrid->Cols()))
+    {
+        row = 0;
+        col = 0;
+    }
+    if (!_pCollisionGrid->IsWalkable(static_cast<Uint16>(row), static_cast<Uint16>(col)))
+    {
+        _pDX[index] = 0;
+        _pDY[index] = 0;
+    }
+}
+
+template <typename T>
+static void SwapArrays(T *&pFirst, T *&pSecond)
+{
+    T *pTemp = pFirst;
+    pFirst = pSecond;
+    pSecond = pTemp;
+}
+
+void EntityStore::SwapBuffers()
+{
+    SwapArrays(_pX, _pXPrevious);
+    SwapArrays(_pY, _pYPrevious);
+}
+
+// set new positio based on velocity
+void EntityStore::Update(Uint32 index)
+{
+    _pXPrevious[index] = _pX[index];
+    _pYPrevious[index] = _pY[index];
+    _pX[index] += _pDX[index];
+    _pY[index] += _pDY[index];
+}
+
+void EntityStore::RenderAll(RenderBatch *pRenderBatch, double alpha)
+{
+    for (Uint32 i = 0; i < _cEntities; i++)
+    {
+        Render(i, pRenderBatch, _pLayer[i], alpha);
+    }
+}
+
+// Find the index to the current frame in the current animation (or the static frame) and queue it at the
+// interpolated position plus the frame offset
+void EntityStore::Render(Uint32 index, RenderBatch *pRenderBatch, Uint16 layer, double alpha)
+{
+    if (_pVisible[index] == SDL_TRUE)
+    {
+        const SpriteSheet &spriteSheet = _sheets[_pSheet[index]];
+        Uint16 frameIndex = CurrentFrame(index);
+
+        int x = FixedToInt(FixedLerp(_pXPrevious[index], _pX[index], alpha));
+        int y = FixedToInt(FixedLerp(_pYPrevious[index], _pY[index], alpha));
+        SDL_Rect targetRect{ x + _pFrameOffsetX[index], y + _pFrameOffsetY[index], spriteSheet.cxFrame, spriteSheet.cyFrame };
+        pRenderBatch->AddQuad(
+            spriteSheet.pTextureWrapper->Ptr(),
+            spriteSheet.pFrames[frameIndex],
+            targetRect,
+            layer);
+    }
+}
+
+Uint32 EntityStore::CaptureSprites(SnapshotSprite *pSprites, Uint32 cMaxSprites)
+{
+    Uint32 cSprites = 0;
+    for (Uint32 i = 0; (i < _cEntities) && (cSprites < cMaxSprites); i++)
+    {
+        if (_pVisible[i] == SDL_TRUE)
+        {
+            SnapshotSprite &sprite = pSprites[cSprites++];
+            sprite.x = _pX[i];
+            sprite.y = _pY[i];
+            sprite.xPrevious = _pXPrevious[i];
+            sprite.yPrevious = _pYPrevious[i];
+            sprite.sheet = _pSheet[i];
+            sprite.frame = CurrentFrame(i);
+            sprite.xFrameOffset = _pFrameOffsetX[i];
+            sprite.yFrameOffset = _pFrameOffsetY[i];
+            sprite.layer = _pLayer[i];
+        }
+    }
+    return cSprites;
+}
+
+void EntityStore::RenderSnapshotSprites(const RenderSnapshot *pSnapshot, RenderBatch *pRenderBatch, double alpha)
+{
+    for (Uint32 i = 0; i < pSnapshot->cSprites; i++)
+    {
+        const SnapshotSprite &sprite = pSnapshot->pSprites[i];
+        const SpriteSheet &spriteSheet = _sheets[sprite.sheet];
+        int x = FixedToInt(FixedLerp(sprite.xPrevious, sprite.x, alpha));
+        int y = FixedToInt(FixedLerp(sprite.yPrevious, sprite.y, alpha));
+        SDL_Rect targetRect{ x + sprite.xFrameOffset, y + sprite.yFrameOffset, spriteSheet.cxFrame, spriteSheet.cyFrame };
+        pRenderBatch->AddQuad(
+            spriteSheet.pTextureWrapper->Ptr(),
+            spriteSheet.pFrames[sprite.frame],
+            targetRect,
+            sprite.layer);
+    }
+}
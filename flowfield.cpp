@@ -0,0 +1,247 @@
+#include "include/flowfield.h"
+#include <stdio.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+static const Uint32 c_noNeighbor = 0xFFFFFFFF;
+
+// Same tie breaking as the navigation table, up, then left, then down
+static const Direction c_directionPriority[4] = { Direction::Up, Direction::Left, Direction::Down, Direction::Right };
+
+FlowFieldService::FlowFieldService(const CollisionGrid *pCollisionGrid, ThreadPool *pThreadPool, Uint32 cMaxTargets) :
+    _pCollisionGrid(pCollisionGrid),
+    _pThreadPool(pThreadPool),
+    _cRows(pCollisionGrid->Rows()),
+    _cCols(pCollisionGrid->Cols()),
+    _cCells(pCollisionGrid->Rows() * pCollisionGrid->Cols()),
+    _pNeighbors(nullptr),
+    _cMaxTargets(cMaxTargets),
+    _pSlots(nullptr),
+    _pPending(nullptr),
+    _fGridChanged(false),
+    _fTooManyOpenCells(false)
+{
+    _pNeighbors = new Uint32[_cCells * 4];
+    IndexNeighbors();
+
+    _pSlots = new Slot[_cMaxTargets]{};
+    for (Uint32 i = 0; i < _cMaxTargets; i++)
+    {
+        Slot &slot = _pSlots[i];
+        for (Uint8 *&pField : slot.pFields)
+        {
+            pField = new Uint8[_cCells];
+        }
+        slot.pDistances = new Uint16[_cCells];
+        slot.pQueue = new Uint32[_cCells];
+        SDL_AtomicSet(&slot.generation, 0);
+    }
+    _pPending = new Uint32[_cMaxTargets];
+}
+
+FlowFieldService::~FlowFieldService()
+{
+    for (Uint32 i = 0; i < _cMaxTargets; i++)
+    {
+        for (Uint8 *pField : _pSlots[i].pFields)
+        {
+            delete[] pField;
+        }
+        delete[] _pSlots[i].pDistances;
+        delete[] _pSlots[i].pQueue;
+    }
+    delete[] _pSlots;
+    delete[] _pPending;
+    delete[] _pNeighbors;
+}
+
+// Where each exit of every cell leads, stepping off one edge of the map comes back in on the other like the grid's
+// exits.  Shared by every search, so they don't each have to unpack the exits again
+void FlowFieldService::IndexNeighbors()
+{
+    Uint32 cOpenCells = 0;
+    for (Uint16 r = 0; r < _cRows; r++)
+    {
+        for (Uint16 c = 0; c < _cCols; c++)
+        {
+            cOpenCells += _pCollisionGrid->IsWalkable(r, c) ? 1 : 0;
+            Uint8 exits = _pCollisionGrid->ExitsAt(r, c);
+            Uint32 up = (r == 0) ? (_cRows - 1) : (r - 1);
+            Uint32 down = (r == (_cRows - 1)) ? 0 : (r + 1);
+            Uint32 left = (c == 0) ? (_cCols - 1) : (c - 1);
+            Uint32 right = (c == (_cCols - 1)) ? 0 : (c + 1);
+            Uint32 *pNeighbors = &_pNeighbors[((r * _cCols) + c) * 4];
+            pNeighbors[static_cast<int>(Direction::Up)] = (exits & CollisionGrid::ExitBit(Direction::Up)) ? ((up * _cCols) + c) : c_noNeighbor;
+            pNeighbors[static_cast<int>(Direction::Down)] = (exits & CollisionGrid::ExitBit(Direction::Down)) ? ((down * _cCols) + c) : c_noNeighbor;
+            pNeighbors[static_cast<int>(Direction::Left)] = (exits & CollisionGrid::ExitBit(Direction::Left)) ? ((r * _cCols) + left) : c_noNeighbor;
+            pNeighbors[static_cast<int>(Direction::Right)] = (exits & CollisionGrid::ExitBit(Direction::Right)) ? ((r * _cCols) + right) : c_noNeighbor;
+        }
+    }
+
+    // 0xFFFF marks a cell not reached yet, so the furthest one has to be closer than that
+    _fTooManyOpenCells = (cOpenCells > c_maxOpenCells);
+    SDL_assert(!_fTooManyOpenCells);
+    if (_fTooManyOpenCells)
+    {
+        printf("FlowFieldService::IndexNeighbors() : more than %u open cells, fields will be empty\n", c_maxOpenCells);
+    }
+}
+
+void FlowFieldService::SetTarget(Uint32 slot, Uint16 row, Uint16 col)
+{
+    SDL_assert(slot < _cMaxTargets);
+    _pSlots[slot].fActive = true;
+    _pSlots[slot].targetRow = row;
+    _pSlots[slot].targetCol = col;
+}
+
+void FlowFieldService::ClearTarget(Uint32 slot)
+{
+    SDL_assert(slot < _cMaxTargets);
+    _pSlots[slot].fActive = false;
+}
+
+void FlowFieldService::GridChanged()
+{
+    _fGridChanged = true;
+}
+
+Uint32 FlowFieldService::Update()
+{
+    if (_fGridChanged)
+    {
+        // Nothing is searching right now, so the shared neighbors can change under nobody
+        IndexNeighbors();
+        for (Uint32 i = 0; i < _cMaxTargets; i++)
+        {
+            _pSlots[i].fBuilt = false;
+        }
+        _fGridChanged = false;
+    }
+
+    Uint32 cPending = 0;
+    for (Uint32 i = 0; i < _cMaxTargets; i++)
+    {
+        const Slot &slot = _pSlots[i];
+        if (slot.fActive && (!slot.fBuilt || (slot.targetRow != slot.builtRow) || (slot.targetCol != slot.builtCol)))
+        {
+            _pPending[cPending++] = i;
+        }
+    }
+
+    // One task per field, each has its own buffers so they never touch each other
+    _pThreadPool->ParallelFor(cPending, BuildTask, this);
+    return cPending;
+}
+
+void FlowFieldService::BuildTask(void *pContext, Uint32 index)
+{
+    FlowFieldService *pThis = static_cast<FlowFieldService*>(pContext);
+    pThis->BuildField(pThis->_pSlots[pThis->_pPending[index]]);
+}
+
+// Breadth first out of the target gives every cell's distance to it (exits are symmetric, so that's also the
+// distance from it), then each cell points at the neighbor one move closer, in priority order
+void FlowFieldService::BuildField(Slot &slot)
+{
+    // This buffer was published two generations ago, readers see it as rebuilding (the generation that published the
+    // one after it is out) before anything in it changes
+    Uint32 generation = static_cast<Uint32>(SDL_AtomicGet(&slot.generation)) + 1;
+    Uint8 *pField = slot.pFields[generation % 3];
+    Uint16 *pDistances = slot.pDistances;
+    SDL_MemoryBarrierRelease();
+    SDL_memset(pField, c_noDirection, _cCells);
+    SDL_memset(pDistances, 0xFF, _cCells * sizeof(Uint16));
+
+    if (!_fTooManyOpenCells && (slot.targetRow < _cRows) && (slot.targetCol < _cCols) && _pCollisionGrid->IsWalkable(slot.targetRow, slot.targetCol))
+    {
+        Uint32 *pQueue = slot.pQueue;
+        Uint32 iHead = 0;
+        Uint32 iTail = 0;
+        Uint32 target = (slot.targetRow * _cCols) + slot.targetCol;
+        pDistances[target] = 0;
+        pQueue[iTail++] = target;
+        while (iHead < iTail)
+        {
+            Uint32 cell = pQueue[iHead++];
+            const Uint32 *pNeighbors = &_pNeighbors[cell * 4];
+            for (int d = 0; d < 4; d++)
+            {
+                Uint32 neighbor = pNeighbors[d];
+                if ((neighbor != c_noNeighbor) && (pDistances[neighbor] == 0xFFFF))
+                {
+                    pDistances[neighbor] = pDistances[cell] + 1;
+                    pQueue[iTail++] = neighbor;
+                }
+            }
+        }
+
+        // Only the cells the search reached can have a direction, and they're all in the queue
+        for (Uint32 i = 1; i < iTail; i++)
+        {
+            Uint32 cell = pQueue[i];
+            const Uint32 *pNeighbors = &_pNeighbors[cell * 4];
+            for (int p = 0; p < 4; p++)
+            {
+                Uint32 neighbor = pNeighbors[static_cast<int>(c_directionPriority[p])];
+                if ((neighbor != c_noNeighbor) && (pDistances[neighbor] == (pDistances[cell] - 1)))
+                {
+                    pField[cell] = static_cast<Uint8>(c_directionPriority[p]);
+                    break;
+                }
+            }
+        }
+    }
+
+    // Publish, the field has to be written before readers can pick it up
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&slot.generation, static_cast<int>(generation));
+    slot.builtRow = slot.targetRow;
+    slot.builtCol = slot.targetCol;
+    slot.fBuilt = true;
+}
+
+const Uint8 *FlowFieldService::Field(Uint32 slot, Uint32 *pGeneration)
+{
+    SDL_assert(slot < _cMaxTargets);
+    Uint32 generation = static_cast<Uint32>(SDL_AtomicGet(&_pSlots[slot].generation));
+    SDL_MemoryBarrierAcquire();
+    if (pGeneration != nullptr)
+    {
+        *pGeneration = generation;
+    }
+    return (generation == 0) ? nullptr : _pSlots[slot].pFields[generation % 3];
+}
+
+bool FlowFieldService::FieldIntact(Uint32 slot, Uint32 generation)
+{
+    SDL_assert(slot < _cMaxTargets);
+    // The reads of the field have to be done before the generation is looked at again.  Its buffer is only rebuilt
+    // once the generation after the next one is out
+    SDL_MemoryBarrierAcquire();
+    return static_cast<Uint32>(SDL_AtomicGet(&_pSlots[slot].generation)) - generation < 2;
+}
+
+bool FlowFieldService::DirectionAt(Uint32 slot, Uint16 row, Uint16 col, Direction &direction)
+{
+    if ((row >= _cRows) || (col >= _cCols))
+    {
+        return false;
+    }
+
+    Uint32 generation = 0;
+    const Uint8 *pField = nullptr;
+    Uint8 cell = c_noDirection;
+    do
+    {
+        pField = Field(slot, &generation);
+        cell = (pField != nullptr) ? pField[(row * _cCols) + col] : c_noDirection;
+    } while ((pField != nullptr) && !FieldIntact(slot, generation));
+
+    if (cell == c_noDirection)
+    {
+        return false;
+    }
+    direction = static_cast<Direction>(cell);
+    return true;
+}
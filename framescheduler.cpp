@@ -0,0 +1,60 @@
+#include "include/framescheduler.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+FrameScheduler::FrameScheduler(Uint32 stepsPerSecond, Uint32 maxCatchUpSteps) :
+    _frequency(SDL_GetPerformanceFrequency()),
+    _counterPerStep(0),
+    _maxAccumulator(0),
+    _accumulator(0),
+    _lastCounter(SDL_GetPerformanceCounter()),
+    _cSteps(0),
+    _cDroppedSteps(0)
+{
+    SDL_assert(stepsPerSecond > 0);
+    SDL_assert(maxCatchUpSteps > 0);
+    _counterPerStep = _frequency / stepsPerSecond;
+    _maxAccumulator = _counterPerStep * maxCatchUpSteps;
+}
+
+void FrameScheduler::BeginFrame()
+{
+    Uint64 counter = SDL_GetPerformanceCounter();
+    _accumulator += counter - _lastCounter;
+    _lastCounter = counter;
+
+    // Too far behind, throw away whatever won't fit in the catch up budget
+    if (_accumulator > _maxAccumulator)
+    {
+        _cDroppedSteps += (_accumulator - _maxAccumulator) / _counterPerStep;
+        _accumulator = _maxAccumulator;
+    }
+}
+
+bool FrameScheduler::StepDue()
+{
+    bool fResult = false;
+    if (_accumulator >= _counterPerStep)
+    {
+        _accumulator -= _counterPerStep;
+        _cSteps++;
+        fResult = true;
+    }
+    return fResult;
+}
+
+double FrameScheduler::Alpha()
+{
+    return static_cast<double>(_accumulator) / static_cast<double>(_counterPerStep);
+}
+
+Uint32 FrameScheduler::MsUntilNextStep()
+{
+    Uint64 elapsed = _accumulator + (SDL_GetPerformanceCounter() - _lastCounter);
+    Uint32 msResult = 0;
+    if (elapsed < _counterPerStep)
+    {
+        msResult = static_cast<Uint32>(((_counterPerStep - elapsed) * 1000) / _frequency);
+    }
+    return msResult;
+}
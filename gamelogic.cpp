@@ -0,0 +1,155 @@
+#include "include/gamelogic.h"
+#include "include/constants.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Animation and unit velocity of a turn each way, in Direction order
+    static const Uint16 c_turnAnimations[] = { Constants::AnimationIndexUp, Constants::AnimationIndexDown, Constants::AnimationIndexLeft, Constants::AnimationIndexRight };
+    static const int c_turnDX[] = { 0, 0, -1, 1 };
+    static const int c_turnDY[] = { -1, 1, 0, 0 };
+
+    // Given a player's current state (location, direction, animation) check if the player can move in a given direction, and if
+    // so position the player on the new track at the new velocity
+    bool DoPlayerInputCheck(Sprite *pSprite, TiledMap *pTiledMap, const CollisionGrid *pCollisionGrid, Direction direction, Uint16 row, Uint16 col, Uint16 animationIndex, Fixed dx, Fixed dy)
+    {
+        // If we can move and we're not already moving in the direction
+        if ((pCollisionGrid->CanMove(row, col, direction) == SDL_TRUE) &&
+            !pSprite->IsPlaying(animationIndex))
+        {
+            // Set a new animation and position the player with a new velocity
+            pSprite->SetAnimation(animationIndex);
+            SDL_Point tilePoint = pTiledMap->GetTileCoordinates(row, col);
+            pSprite->ResetPosition(FixedFromInt(tilePoint.x), FixedFromInt(tilePoint.y));
+            pSprite->SetVelocity(dx, dy);
+            return true;
+        }
+        return false;
+    }
+
+    // Checked every tick while a turn is pending, so it's taken on the first tick the player is on a tile that allows
+    // it rather than only if the key happens to be down then
+    bool DoBufferedTurn(Sprite *pSprite, TiledMap *pTiledMap, const CollisionGrid *pCollisionGrid, BufferedTurn *pTurn)
+    {
+        if (pTurn->fPending == SDL_FALSE)
+        {
+            return false;
+        }
+
+        int turn = static_cast<int>(pTurn->direction);
+        if (pSprite->IsPlaying(c_turnAnimations[turn]))
+        {
+            // Nothing to turn, already going that way
+            pTurn->fPending = SDL_FALSE;
+            return false;
+        }
+
+        Uint16 row = 0;
+        Uint16 col = 0;
+        pTiledMap->GetTileRowCol(pSprite->X(), pSprite->Y(), row, col);
+        bool fTaken = DoPlayerInputCheck(pSprite, pTiledMap, pCollisionGrid, pTurn->direction, row, col, c_turnAnimations[turn],
+            c_turnDX[turn] * Constants::PlayerSpeed, c_turnDY[turn] * Constants::PlayerSpeed);
+        if (fTaken)
+        {
+            pTurn->fPending = SDL_FALSE;
+        }
+        return fTaken;
+    }
+
+    // Even if no input is pressed, the player may run into a wall, so we need to handle collisions
+    // after the player is moved
+    void DoPlayerBoundsCheck(Sprite *pSprite, TiledMap *pTiledMap, const CollisionGrid *pCollisionGrid)
+    {
+        // The only way off the map is a tunnel (the exits wrap around there), so come back in on the other side
+        // Everything stays in 16.16 fixed point, so this comes out the same on every build
+        SDL_Rect mapBounds = pTiledMap->GetMapBounds();
+        Fixed xMap = FixedFromInt(mapBounds.x);
+        Fixed yMap = FixedFromInt(mapBounds.y);
+        Fixed xMapEnd = FixedFromInt(mapBounds.x + mapBounds.w);
+        Fixed yMapEnd = FixedFromInt(mapBounds.y + mapBounds.h);
+        Fixed cxMap = FixedFromInt(mapBounds.w);
+        Fixed cyMap = FixedFromInt(mapBounds.h);
+        Fixed x = pSprite->X();
+        Fixed y = pSprite->Y();
+        if ((x < xMap) || (x >= xMapEnd) || (y < yMap) || (y >= yMapEnd))
+        {
+            x += (x < xMap) ? cxMap : ((x >= xMapEnd) ? -cxMap : 0);
+            y += (y < yMap) ? cyMap : ((y >= yMapEnd) ? -cyMap : 0);
+            pSprite->ResetPosition(x, y);
+        }
+
+        Fixed xProbe = x;
+        Fixed yProbe = y;
+
+        // Need to check bounds in direction moving (account for width of half the sprite)
+        // This is because the sprite is double the size of the tiles and placed along the centerline
+        // in the direction of movement.  So 1/2 of its size in a given direction is the "edge" of the
+        // sprite on the screen (minus a pixel or 2 of transparency)
+        if (pSprite->DX() != 0) // If we're not moving in this axis, then don't bother
+        {
+            if (pSprite->DX() < 0)
+            {
+                xProbe -= FixedFromInt((Constants::PlayerSpriteWidth / 2) - Constants::TileWidth / 2);
+            }
+            else
+            {
+                xProbe += FixedFromInt((Constants::PlayerSpriteWidth / 2) - Constants::TileWidth / 2);
+            }
+        }
+        else  // We cann't be moving in both directions at once
+        {
+            if (pSprite->DY() < 0)  // Same logic for y axis if moving
+            {
+                yProbe -= FixedFromInt((Constants::PlayerSpriteHeight / 2) - Constants::TileHeight / 2);
+            }
+            else
+            {
+                yProbe += FixedFromInt((Constants::PlayerSpriteHeight / 2) - Constants::TileHeight / 2);
+            }
+        }
+
+        // The edge we're checking may be in the tunnel on the other side
+        xProbe += (xProbe < xMap) ? cxMap : ((xProbe >= xMapEnd) ? -cxMap : 0);
+        yProbe += (yProbe < yMap) ? cyMap : ((yProbe >= yMapEnd) ? -cyMap : 0);
+
+        // Now get the row, col we're in
+        Uint16 row = 0;
+        Uint16 col = 0;
+        pTiledMap->GetTileRowCol(xProbe, yProbe, row, col);
+
+        // If we wandered into a bad cell, stop
+        if (!pCollisionGrid->IsWalkable(row, col))
+        {
+            pSprite->SetVelocity(0, 0);
+        }
+    }
+
+    // The board does the bookkeeping, this only finds the player's tile and starts the level over once it's clear
+    PelletType DoPlayerPelletCheck(Sprite *pSprite, TiledMap *pTiledMap, PelletBoard *pPellets, PelletTileCallback pfnTileChanged, void *pContext)
+    {
+        Uint16 row = 0;
+        Uint16 col = 0;
+        if (!pTiledMap->GetTileRowCol(pSprite->X(), pSprite->Y(), row, col))
+        {
+            return PelletType::None;
+        }
+
+        PelletType pellet = pPellets->Eat(row, col);
+        if (pellet != PelletType::None)
+        {
+            if (pfnTileChanged != nullptr)
+            {
+                pfnTileChanged(pContext, row, col, pPellets->EmptyTile());
+            }
+
+            // Level cleared, there's only the one level so it starts over with the pellets back
+            if (pPellets->IsCleared())
+            {
+                pPellets->Reset(pfnTileChanged, pContext);
+            }
+        }
+        return pellet;
+    }
+}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "SDL.h"
+#include "entitystore.h"
+#include "tiledmap.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Two entities (packed EntityStore indicies, first < second) whose frames may touch
+    struct ActorPair
+    {
+        Uint32 first;
+        Uint32 second;
+    };
+
+    // Actor against actor collisions (player and ghosts, fruit, projectiles) without testing every pair.  Each tick
+    // Build sorts the visible entities by the map tile their frame's center is on (the cell TiledMap::GetTileRowCol
+    // gives), a counting sort into flat arrays sized once up front, so nothing is allocated per tick.  Only entities
+    // in the same or nearby cells become candidate pairs, how far "nearby" reaches is worked out from the largest
+    // frame, and the narrowphase is an overlap test of their frame rects (frame size at the SetFrameOffset offset).
+    //
+    // Below c_minBucketedEntities visible entities clearing and summing the cell table costs more than comparing every
+    // pair, so they're all candidates instead.  Pairs come out in cell order (index order when not bucketed), the
+    // same every run for the same state.  Nothing wraps through the tunnel, the frames are compared in world pixels
+    class ActorBroadphase
+    {
+    public:
+        // cMaxEntities should match the store's, cMaxPairs is the most pairs a Find call keeps
+        ActorBroadphase(Uint16 rows, Uint16 cols, Uint32 cMaxEntities, Uint32 cMaxPairs);
+        ~ActorBroadphase();
+
+        // Bucket every visible entity, once per tick after everything has moved.  Entities off the map go in the
+        // nearest edge cell
+        void Build(EntityStore *pEntityStore, TiledMap *pTiledMap);
+
+        // Every pair from the last Build close enough that their frames could overlap, returns how many (see Pairs)
+        Uint32 FindCandidatePairs();
+        // The candidates whose frames really do overlap, returns how many (see Pairs)
+        Uint32 FindContacts();
+        const ActorPair *Pairs() const { return _pPairs; }
+        Uint32 PairCount() const { return _cPairs; }
+        // Pairs a Find call had no room for, 0 unless cMaxPairs is too small
+        Uint32 DroppedPairs() const { return _cDroppedPairs; }
+
+        // Narrowphase, the frame rects of two entities from the last Build overlap
+        bool Overlaps(Uint32 first, Uint32 second) const
+        {
+            const ActorBox &a = _pBoxes[first];
+            const ActorBox &b = _pBoxes[second];
+            return (a.left < b.right) & (b.left < a.right) & (a.top < b.bottom) & (b.top < a.bottom);
+        }
+
+    private:
+        static const Uint32 c_noCell = 0xFFFFFFFF;
+        static const Uint32 c_minBucketedEntities = 32;
+
+        // Frame rect in world pixels, right and bottom exclusive
+        struct ActorBox
+        {
+            int left;
+            int top;
+            int right;
+            int bottom;
+        };
+
+        // Shared by both Finds, the narrowphase runs as each candidate turns up when only contacts are wanted
+        Uint32 FindPairs(bool fContactsOnly);
+
+        Uint16 _cRows;
+        Uint16 _cCols;
+        Uint32 _cMaxEntities;
+        Uint32 _cMaxPairs;
+        Uint32 *_pCellStart;        // [_cRows * _cCols + 1], the cell's entities are _pCellEntities[start, next start)
+        Uint32 *_pCellFill;         // Next free spot per cell while sorting
+        Uint32 *_pCellEntities;     // Entities sorted by cell (then by index), just in index order when not bucketed
+        Uint32 *_pEntityCell;       // Cell of each entity, c_noCell if it isn't visible
+        ActorBox *_pBoxes;          // [_cMaxEntities]
+        Uint32 _cEntities;          // Entities in the store at the last Build, visible or not
+        Uint32 _cSorted;            // Visible ones, the count of _pCellEntities
+        Uint16 _reach;              // Cells either way a neighbour can be and still overlap
+        bool _fBucketed;            // Too few entities to be worth sorting when false
+        ActorPair *_pPairs;
+        Uint32 _cPairs;
+        Uint32 _cDroppedPairs;
+    };
+}
+}
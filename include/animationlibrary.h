@@ -0,0 +1,64 @@
+#pragma once
+#include "SDL.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Used to control animation behavior when then
+    // end of the sequence is reached
+    enum class AnimationType
+    {
+        Loop = 0,  // start over
+        Once = 1,  // stop
+    };
+
+    // An animation consists of a sequence of frames, each shown for the same number of simulation ticks.  Clips
+    // never change once added, their frames live in the library's pool
+    struct AnimationClip
+    {
+        Uint32 iFirstFrame;         // Into the library's frame pool
+        Uint16 cFrames;             // Total frames in the sequence
+        Uint16 ticksPerFrame;       // Ticks each frame is shown for
+        AnimationType type;         // Loop or once
+    };
+
+    // Every animation clip, defined once and shared by whatever plays it.  Nothing about playing a clip is stored
+    // here or stepped per tick: a player only keeps the clip id and the tick it started on, and the frame is worked
+    // out from how long ago that was whenever it's needed.  So any number of actors can run the same clip (in step
+    // or not) for the cost of a few bytes each
+    class AnimationLibrary
+    {
+    public:
+        static const Uint16 c_noClip = 0xFFFF;
+
+        AnimationLibrary(Uint16 cMaxClips, Uint32 cMaxFrames);
+        ~AnimationLibrary();
+
+        // Returns the clip id, the existing one if an identical clip was added before.  c_noClip if full
+        Uint16 AddClip(const int *pSequence, Uint16 cFrames, AnimationType type, Uint16 ticksPerFrame);
+
+        // Frame showing elapsedTicks after the clip started.  A looping clip wraps, one played once holds its last frame
+        Uint16 FrameAt(Uint16 clip, Uint32 elapsedTicks) const
+        {
+            SDL_assert(clip < _cClips);
+            const AnimationClip &animationClip = _pClips[clip];
+            Uint32 step = elapsedTicks / animationClip.ticksPerFrame;
+            step = (animationClip.type == AnimationType::Loop) ? (step % animationClip.cFrames) : SDL_min(step, animationClip.cFrames - 1u);
+            return _pFrames[animationClip.iFirstFrame + step];
+        }
+
+        const AnimationClip &Clip(Uint16 clip) const { return _pClips[clip]; }
+        Uint16 ClipCount() const { return _cClips; }
+        Uint32 FrameCount() const { return _cFrames; }
+
+    private:
+        AnimationClip *_pClips;
+        Uint16 _cClips;
+        Uint16 _cMaxClips;
+        Uint16 *_pFrames;           // Every clip's frames back to back
+        Uint32 _cFrames;
+        Uint32 _cMaxFrames;
+    };
+}
+}
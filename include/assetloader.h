@@ -0,0 +1,77 @@
+#pragma once
+#include "SDL.h"
+#include "utils.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Index of a request made to the AssetLoader
+    typedef Uint32 AssetHandle;
+    static const AssetHandle InvalidAssetHandle = 0xFFFFFFFF;
+
+    enum class AssetState
+    {
+        Free = 0,
+        Queued,         // Waiting for a worker
+        Decoding,       // A worker has it
+        Decoded,        // Surface ready, waiting for Pump to upload it
+        Ready,          // Done, take the result
+        Failed
+    };
+
+    // Decodes images on a small pool of worker threads.  Workers only do the renderer-free part (LoadSurface: file
+    // read, PNG inflate, color key), uploads happen on the thread that owns the renderer when it calls Pump or Wait.
+    // The handle returned by a request works like a future: poll State() or block in Wait(), then take the result
+    class AssetLoader
+    {
+    public:
+        AssetLoader(Uint32 cWorkers, Uint32 cMaxRequests);
+        ~AssetLoader();
+
+        // Queue an image.  With fUpload the result is a texture (TakeTexture), otherwise a surface (TakeSurface)
+        // for something that wants the pixels, like the atlas
+        AssetHandle Load(const char *szFileName, SDL_Color *pSdlTransparencyColorKey, bool fUpload);
+
+        // Main thread only: upload anything decoded so far
+        void Pump(SDL_Renderer *pSDLRenderer);
+        // Main thread only: pump until the request is done, true if it succeeded
+        bool Wait(AssetHandle handle, SDL_Renderer *pSDLRenderer);
+        AssetState State(AssetHandle handle);
+
+        // Ownership passes to the caller and the request is freed
+        SDL_Surface* TakeSurface(AssetHandle handle);
+        TextureWrapper* TakeTexture(AssetHandle handle);
+
+        Uint32 WorkerCount() { return _cWorkers; }
+
+    private:
+        struct AssetRequest
+        {
+            AssetState state;
+            char *pszFileName;
+            SDL_bool fColorKey;
+            SDL_Color colorKey;
+            bool fUpload;
+            SDL_Surface *pSurface;
+            TextureWrapper *pTextureWrapper;
+        };
+
+        static int WorkerThread(void *pData);
+        void WorkerLoop();
+        void FreeRequest(AssetHandle handle);
+
+        Uint32 _cWorkers;
+        SDL_Thread **_ppWorkers;
+        Uint32 _cMaxRequests;
+        AssetRequest *_pRequests;
+        AssetHandle *_pQueue;           // Ring of queued handles, _cMaxRequests long so it can never overflow
+        Uint32 _iQueueHead;
+        Uint32 _cQueued;
+        bool _fQuit;
+        SDL_mutex *_pMutex;             // Guards everything above
+        SDL_cond *_pWorkQueued;         // Signalled when a request is queued (or on quit)
+        SDL_cond *_pWorkDone;           // Signalled when a worker finishes a request
+    };
+}
+}
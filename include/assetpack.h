@@ -0,0 +1,84 @@
+#pragma once
+#include "SDL.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // On-disk layout of an asset pack (built offline by tools/assetpacker.cpp, make pack).  Everything is little
+    // endian:
+    //
+    //   AssetPackHeader
+    //   payloads, each starting on a c_assetPackAlignment boundary
+    //   AssetPackEntry[cEntries]   (the index, at indexOffset)
+    //
+    // Images are stored decoded, ARGB8888 with the color key already turned into alpha (what LoadSurface returns),
+    // so they can be handed to SDL as they are
+    static const Uint32 c_assetPackMagic = 0x50434D50;     // "PMCP"
+    static const Uint32 c_assetPackVersion = 3;
+    static const Uint32 c_assetPackAlignment = 16;
+    static const Uint32 c_assetPackMaxName = 48;
+
+    enum class AssetPackEntryType : Uint32
+    {
+        Image = 1,          // width x height pixels, pitch bytes per row
+        Grid16 = 2,         // width (cols) x height (rows) Uint16s
+        Table32 = 3         // width Sint32s
+    };
+
+    struct AssetPackHeader
+    {
+        Uint32 magic;
+        Uint32 version;
+        Uint32 cEntries;
+        Uint32 indexOffset;
+        Uint32 tablesVersion;               // Constants::TablesVersion the grids and tables were written with
+    };
+
+    struct AssetPackEntry
+    {
+        char szName[c_assetPackMaxName];    // Image entries use the file name the image was packed from
+        AssetPackEntryType type;
+        Uint32 offset;                      // Of the payload from the start of the file
+        Uint32 cbSize;
+        Uint32 width;
+        Uint32 height;
+        Uint32 pitch;
+    };
+
+    // Maps a pack into memory, read only, and hands out pointers straight into it.  Everything returned is only
+    // valid while the pack is open
+    class AssetPack
+    {
+    public:
+        AssetPack();
+        ~AssetPack();
+
+        bool Open(const char *szFileName);
+        void Close();
+        bool IsOpen() { return _pBase != nullptr; }
+        // Layout the grids and tables follow, compare with Constants::TablesVersion before using them
+        Uint32 TablesVersion() { return _tablesVersion; }
+
+        const AssetPackEntry* Find(const char *szName, AssetPackEntryType type);
+        // A surface over the packed pixels, no copy and no decode.  Free it with SDL_FreeSurface as usual (that
+        // leaves the pixels alone), but not after the pack is closed
+        SDL_Surface* CreateSurface(const char *szName);
+        // Map grids and tables, cCount must match what's packed
+        const Uint16* Grid(const char *szName, Uint32 cRows, Uint32 cCols);
+        const Sint32* Table(const char *szName, Uint32 cCount);
+
+    private:
+        const Uint8 *_pBase;            // Start of the mapping
+        size_t _cbFile;
+        const AssetPackEntry *_pEntries;
+        Uint32 _cEntries;
+        Uint32 _tablesVersion;
+#ifdef _WIN32
+        void *_hFile;
+        void *_hMapping;
+#endif
+        bool _fMapped;                  // false if we had to fall back to reading the file into memory
+    };
+}
+}
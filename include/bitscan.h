@@ -0,0 +1,46 @@
+#pragma once
+#include "SDL.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Bit tricks for the 64 bit word boards (CollisionGrid, PelletBoard)
+
+    // Index of the lowest/highest set bit, the word must not be 0
+    inline int LowestBit(Uint64 word)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, word);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(word);
+#endif
+    }
+
+    inline int HighestBit(Uint64 word)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, word);
+        return static_cast<int>(index);
+#else
+        return 63 - __builtin_clzll(word);
+#endif
+    }
+
+    // Plain SWAR count, POPCNT isn't something we can assume on every CPU we run on
+    inline int CountBits(Uint64 word)
+    {
+        word = word - ((word >> 1) & 0x5555555555555555ULL);
+        word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+        word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return static_cast<int>((word * 0x0101010101010101ULL) >> 56);
+    }
+}
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "SDL.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Simple enum to denote the 4 possible directions
+    // The sprites can move
+    enum class Direction
+    {
+        Up = 0,
+        Down,
+        Left,
+        Right
+    };
+
+    // Walkability of the map packed one bit per cell (rows padded to 64 bit words), plus a 4 bit mask per cell of
+    // the directions that can be moved in from it (bit n == Direction n).  An open cell on the edge of the map leads
+    // to the open cell across from it (the tunnel), so those exits wrap around.
+    //
+    // Movement queries are a single load out of the exits.  Anything outside the map reads a blocked cell with no
+    // exits, so callers don't need to range check first
+    class CollisionGrid
+    {
+    public:
+        CollisionGrid(Uint16 rows, Uint16 cols);
+        ~CollisionGrid();
+
+        // (Re)build everything from a collision map, 0s are legal free space and anything else is a wall
+        void Build(const Uint16 *pCollisionMap);
+        // Change one cell, its exits and its neighbours' are recomputed
+        void SetWalkable(Uint16 row, Uint16 col, bool fWalkable);
+
+        bool IsWalkable(Uint16 row, Uint16 col) const
+        {
+            bool fInside = (row < _cRows) & (col < _cCols);
+            Uint32 word = fInside ? ((row * _cWordsPerRow) + (col >> 6)) : (_cRows * _cWordsPerRow);
+            return ((_pWalkable[word] >> (col & 63)) & 1) != 0;
+        }
+        // Directions that can be moved in from [row][col], see ExitBit
+        Uint8 ExitsAt(Uint16 row, Uint16 col) const
+        {
+            Uint32 index = ExitIndex(row, col);
+            return (_pExits[index >> 1] >> ((index & 1) << 2)) & 0xF;
+        }
+        // Check the collision map for the cell next to [row][col] in the given direction
+        SDL_bool CanMove(Uint16 row, Uint16 col, Direction direction) const
+        {
+            return static_cast<SDL_bool>((ExitsAt(row, col) >> static_cast<int>(direction)) & 1);
+        }
+        static Uint8 ExitBit(Direction direction) { return static_cast<Uint8>(1 << static_cast<int>(direction)); }
+
+        // Bulk scans.  Open cells in a whole row or column
+        Uint16 CountWalkableInRow(Uint16 row) const;
+        Uint16 CountWalkableInCol(Uint16 col) const;
+        // Open cells that can be moved through in a straight line from [row][col] before a wall or the edge of the map
+        // (tunnels aren't followed), not counting [row][col] itself
+        Uint16 RunLength(Uint16 row, Uint16 col, Direction direction) const;
+
+        Uint16 Rows() const { return _cRows; }
+        Uint16 Cols() const { return _cCols; }
+        // Bytes used by the bits and exits
+        Uint32 SizeInBytes() const { return (_cRows + 1) * _cWordsPerRow * sizeof(Uint64) + ((_cRows * _cCols + 2) / 2); }
+
+    private:
+        // Index into the exits, or the blocked one past the end
+        Uint32 ExitIndex(Uint16 row, Uint16 col) const
+        {
+            bool fInside = (row < _cRows) & (col < _cCols);
+            return fInside ? ((row * _cCols) + col) : (_cRows * _cCols);
+        }
+        void SetExits(Uint16 row, Uint16 col);
+
+        Uint16 _cRows;
+        Uint16 _cCols;
+        Uint32 _cWordsPerRow;       // 64 cells per word, the bits past _cCols are always 0
+        Uint64 *_pWalkable;         // [_cRows + 1][_cWordsPerRow], 1 == open.  The extra row is all walls
+        Uint8 *_pExits;             // Two cells per byte (low nibble first), plus an extra cell with no exits
+    };
+}
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "SDL.h"
+#include "fixedpoint.h"
 
 namespace XplatGameTutorial
 {
@@ -10,22 +11,77 @@ namespace PacManClone
     public:
         static const Uint16 ScreenWidth = 800;
         static const Uint16 ScreenHeight = 600;
-        static const Uint32 FramesPerSecond = 60;
-        static const Uint32 TicksPerFrame;
+        static const Uint32 SimulationStepsPerSecond = 60;  // Fixed simulation rate, independent of refresh rate
+        static const Uint32 MaxCatchUpSteps = 5;            // Most simulation steps run in one rendered frame
         static const SDL_Color SDLColorGrey;
         static const SDL_Color SDLColorMagenta;
         static const SDL_Color RenderDrawColor;
         static const char * const WindowTitle;
+        static const char * const ProfileCsvFileName;       // Frame phase samples written here in profiling builds
         static const Uint16 MapRows = 36;
         static const Uint16 MapCols = 28;
         static const Uint16 TileTextureWidth = 192;
         static const Uint16 TileTextureHeight = 192;
         static const Uint16 TileWidth = 16;
         static const Uint16 TileHeight = 16;
+        static const Uint16 TileIndexPellet = 16;           // Tiles on tiles.png the pellet board is built from
+        static const Uint16 TileIndexPowerPellet = 13;
+        static const Uint16 TileIndexEmpty = 49;            // Left behind when a pellet is eaten
         static const Uint16 PlayerSpriteWidth = 32;
         static const Uint16 PlayerSpriteHeight = 32;
         static const Uint16 PlayerStartRow = 26;
         static const Uint16 PlayerStartCol = 13;
+        static const Fixed PlayerSpeed;                     // Pixels per simulation step
+
+        // Rendering goes through a batch, layers are drawn from low to high
+        static const Uint32 MaxBatchQuads = 2048;
+        static const Uint16 RenderLayerMap = 0;
+        static const Uint16 RenderLayerSprites = 1;
+
+        // Textures are packed into atlas pages no bigger than this, the layout is cached in AtlasCacheFileName
+        static const int AtlasMaxPageSize = 2048;
+        static const char * const AtlasCacheFileName;
+
+        // Textures loaded through the texture cache, unreferenced ones are evicted past the budget
+        static const Uint64 TextureCacheBudgetBytes = 64 * 1024 * 1024;
+        static const Uint32 TextureCacheMaxEntries = 64;
+
+        // Pre-decoded assets built by make pack, used instead of the PNGs when present
+        static const char * const AssetPackFileName;
+
+        // Images are decoded on up to this many worker threads (one less than the CPU count)
+        static const int AssetLoaderMaxWorkers = 4;
+        static const Uint32 AssetLoaderMaxRequests = 64;
+
+        // Work shared out over one less worker thread than the CPU count, tasks per worker queue
+        static const Uint32 ThreadPoolMaxQueuedTasks = 256;
+
+        // Targets the flow field service keeps a field for (the player is slot 0)
+        static const Uint32 FlowFieldMaxTargets = 16;
+
+        // Drawn frames allowed to allocate at the start, and again after the map's caches are rebuilt, while SDL's
+        // buffers and the caches grow to size
+        static const Uint32 RenderWarmupFrames = 3;
+
+        // Capacity of the entity store (every actor on screen)
+        static const Uint32 MaxEntities = 8192;
+        // Actor pairs the broadphase keeps per step
+        static const Uint32 MaxContactPairs = 4096;
+
+        // Everything a level allocates comes out of one arena of this size, freed in one go when the level ends.
+        // Sprites (actors handled one at a time) come from a pool of MaxSprites in it
+        static const Uint32 LevelArenaBytes = 1024 * 1024;
+        static const Uint32 MaxSprites = 64;
+
+        // Map changes the simulation can have waiting for the render thread to pick up
+        static const Uint32 RenderSnapshotMaxTiles = 1024;
+
+        // Key events the render thread can have waiting for the simulation (a power of 2)
+        static const Uint32 InputQueueMaxEvents = 256;
+
+        // Headless (--headless) benchmark runs
+        static const Uint32 HeadlessDefaultTicks = 1000000;
+        static const Uint32 HeadlessInputSeed = 0x5EED;
 
         // Indices to tiles that make up the map - for your own sanity use a level editor (several free ones exist) or better
         // yet develop your own tool early in the design process
@@ -33,7 +89,7 @@ namespace PacManClone
         static Uint16 MapIndicies[MapRows * MapCols];
         static Uint16 CollisionMap[MapRows * MapCols];
 
-        static const Uint16 PlayerAnimationSpeed = 5;
+        static const Uint16 PlayerAnimationSpeed = 5;       // Simulation steps per animation frame
 
         // Animations
         static const Uint16 AnimationIndexUp = 0;
@@ -52,9 +108,10 @@ namespace PacManClone
         static int PlayerAnimation_RIGHT[PlayerAnimationFrameCount];
         static int PlayerAnimation_DEATH[PlayerAnimationDeathFrameCount];
 
-    private:
-        static const Uint32 c_msPerSecond = 1000;
-        static const Uint32 c_msPerFrame = (c_msPerSecond / FramesPerSecond);
+        // Layout of the map grids and animation tables above: their sizes, the tile and frame numbering.  Bump it
+        // whenever that changes, an asset pack written for another layout is turned down instead of misread.  The
+        // values in a pack that matches are the ones used (make pack after editing them)
+        static const Uint32 TablesVersion = 1;
     };
     
 }
@@ -0,0 +1,217 @@
+#pragma once
+#include "SDL.h"
+#include "utils.h"
+#include "fixedpoint.h"
+#include "animationlibrary.h"
+#include "collisiongrid.h"
+#include "memoryarena.h"
+#include "renderbatch.h"
+#include "rendersnapshot.h"
+#include "threadpool.h"
+#include "tiledmap.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Stable reference to an entity, [generation:16][slot:16].  The slot is reused after Destroy but the generation
+    // changes, so a stale handle is detected instead of silently pointing at whatever moved in
+    typedef Uint32 EntityHandle;
+    static const EntityHandle InvalidEntityHandle = 0xFFFFFFFF;
+    // What CreateSheet returns once every sheet is taken
+    static const Uint16 InvalidSheet = 0xFFFF;
+
+    // Frames and animation sequences shared by every entity drawn from the same sheet of a texture
+    struct SpriteSheet
+    {
+        TextureWrapper *pTextureWrapper;    // Not owned
+        SDL_Rect sourceRect;                // Area of the texture the sheet lives in, frame coordinates are relative to it
+        Uint16 cxFrame;                     // Width of a frame
+        Uint16 cyFrame;                     // Height of a frame
+        Uint16 cFramesTotal;                // Total number of frames
+        SDL_Rect *pFrames;                  // Frame rects in the texture
+        Uint16 cAnimationsTotal;            // Total number of animation sequences
+        Uint16 *pClips;                     // Clip in the store's library for each animation index, nullptr until
+                                            // the first sequence is loaded (static sprites never have any)
+    };
+
+    // Keeps the state of every actor in parallel arrays instead of one heap object per actor, so the bulk passes
+    // (UpdateAll, RenderAll) walk memory in order.  Live entities are packed at [0, Count()); removing one moves the
+    // last entity into its place, which is why callers hold an EntityHandle and not an index.
+    //
+    // Sprite is a thin view over a single entity for code that wants to deal with one actor at a time
+    class EntityStore
+    {
+    public:
+        // Slots have to fit in the low 16 bits of a handle
+        static const Uint32 c_maxEntities = 0x10000;
+
+        // Sheets (frames and animation tables) are allocated from pLevelArena, which has to outlive the store.
+        // cMaxEntities is at most c_maxEntities
+        EntityStore(Uint32 cMaxEntities, MemoryArena *pLevelArena);
+        ~EntityStore();
+
+        // SHEETS
+        // Returns the new sheet id, or InvalidSheet once all c_maxSheets are taken.  Sheets live as long as the store
+        // (nothing frees one), so every actor drawn from the same frames should share a single sheet, create the
+        // first Sprite with its texture and the rest with Sprite(EntityStore*, Uint16 sheet)
+        Uint16 CreateSheet(TextureWrapper *pTextureWrapper, Uint16 cxFrame, Uint16 cyFrame, Uint16 cFramesTotal, Uint16 cAnimationsTotal);
+        // See Sprite::LoadFrame
+        bool LoadFrame(Uint16 sheet, Uint16 frameIndex, Uint16 xTexture, Uint16 yTexture);
+        // See Sprite::LoadAnimationSequence.  The sequence goes into the store's AnimationLibrary, shared with any
+        // other sheet that loads the same one
+        void LoadAnimationSequence(Uint16 sheet, Uint16 index, AnimationType animationType, const int* pSequence, Uint16 cFramesInSequence, Uint16 animationSpeed);
+        const SpriteSheet& Sheet(Uint16 sheet) { return _sheets[sheet]; }
+        // Move the sheet to sourceRect on another texture (e.g. its place on an atlas page).  Frames already
+        // loaded are moved with it, frames loaded after are relative to sourceRect
+        void RemapSheet(Uint16 sheet, TextureWrapper *pTextureWrapper, const SDL_Rect &sourceRect);
+
+        // ENTITIES
+        // Returns InvalidEntityHandle if the store is full or the sheet doesn't exist
+        EntityHandle Create(Uint16 sheet);
+        void Destroy(EntityHandle handle);
+        bool IsValid(EntityHandle handle);
+        // Current packed index of a live entity, only good until the next Destroy
+        Uint32 IndexOf(EntityHandle handle)
+        {
+            SDL_assert(IsValid(handle));
+            return _pSlotToIndex[handle & 0xFFFF];
+        }
+        Uint32 Count() { return _cEntities; }
+
+        // Per entity state changes, these mirror the Sprite API
+        void SetAnimation(Uint32 index, Uint16 animation);
+        void ResetAnimation(Uint32 index);
+        void SetStaticFrame(Uint32 index, Uint16 frame);
+        // Frame on its sheet the entity shows right now, from its clip and the clock (or its static frame).  Worked out
+        // by the update each tick and by anything that changes the animation in between
+        Uint16 CurrentFrame(Uint32 index) { return _pFrame[index]; }
+
+        // MAP
+        // The map entities with wall collision on are kept in, both have to outlive the store (or the next call)
+        void SetCollisionMap(TiledMap *pTiledMap, const CollisionGrid *pCollisionGrid);
+
+        // BULK PASSES
+        // Advance the clock a tick and, for every entity: move it by its velocity, stop it at a wall if it has wall
+        // collision on (see DoPlayerBoundsCheck, the same check for any frame size), and work out the frame it shows.
+        // A tick reads the current state and writes the next state into separate buffers, which are swapped at the
+        // end (the old positions become the previous positions), so an entity's update only ever sees the state
+        // everyone had at the start of the tick
+        void UpdateAll();
+        // Same, with the entities split into jobs of c_entitiesPerJob run on pThreadPool.  A job only writes its own
+        // entities, so the result is bit for bit the same as UpdateAll.  Anything touching more than one entity
+        // (contacts, pick ups) is the merge, it belongs after this on the calling thread in entity order, once the
+        // new state is settled.  Below c_minParallelEntities handing out the jobs costs more than they save and it
+        // just runs UpdateAll
+        void UpdateAll(ThreadPool *pThreadPool);
+        // Move a single entity, the clock only moves with UpdateAll
+        void Update(Uint32 index);
+        // Queue every visible entity on its layer, positions are blended by alpha (see Sprite::Render)
+        void RenderAll(RenderBatch *pRenderBatch, double alpha);
+        void Render(Uint32 index, RenderBatch *pRenderBatch, Uint16 layer, double alpha);
+        // Copy what RenderAll would draw into pSprites (up to cMaxSprites), returns how many.  The render thread then
+        // draws it with RenderSnapshotSprites while the simulation carries on
+        Uint32 CaptureSprites(SnapshotSprite *pSprites, Uint32 cMaxSprites);
+        // Same as RenderAll, from a snapshot.  Only reads the sheets, which don't change once loaded
+        void RenderSnapshotSprites(const RenderSnapshot *pSnapshot, RenderBatch *pRenderBatch, double alpha);
+
+        // Parallel arrays, indexed [0, Count())
+        Fixed *X() { return _pX; }
+        Fixed *Y() { return _pY; }
+        Fixed *DX() { return _pDX; }
+        Fixed *DY() { return _pDY; }
+        Fixed *XPrevious() { return _pXPrevious; }
+        Fixed *YPrevious() { return _pYPrevious; }
+        Uint16 *SheetIds() { return _pSheet; }
+        Uint16 *Clips() { return _pClip; }
+        // Animation index on the entity's sheet that was last set, c_noAnimation before that.  Two indicies can share
+        // a clip (same sequence), so this and not the clip says which one is playing
+        Uint16 *PlayingAnimations() { return _pAnimation; }
+        Uint32 *AnimationStarts() { return _pAnimationStart; }
+        Uint16 *StaticFrames() { return _pStaticFrame; }
+        Sint16 *FrameOffsetsX() { return _pFrameOffsetX; }
+        Sint16 *FrameOffsetsY() { return _pFrameOffsetY; }
+        Uint16 *Layers() { return _pLayer; }
+        SDL_bool *Visible() { return _pVisible; }
+        // Stopped by the walls of the collision map (SetCollisionMap), off by default
+        SDL_bool *WallCollision() { return _pWallCollision; }
+
+        // Ticks run by UpdateAll, what every animation is timed against
+        Uint32 Clock() { return _clock; }
+        const AnimationLibrary& Animations() { return _animations; }
+
+        static const Uint32 c_entitiesPerJob = 512;
+        static const Uint16 c_noAnimation = 0xFFFF;
+        // Eight jobs, enough to go round a few cores.  An entity costs around 20ns to update with its wall check
+        // and frame (bench_engine.cpp, which also prints the scaling), so that's some 80us of work against the few
+        // microseconds it takes to wake the workers
+        static const Uint32 c_minParallelEntities = 8 * c_entitiesPerJob;
+
+    private:
+        static const Uint16 c_maxSheets = 64;
+        static const Uint16 c_maxClips = 256;
+        static const Uint32 c_maxClipFrames = 4096;
+
+        // Write the next state of entities [first, first + count) from the current state
+        void UpdateRange(Uint32 first, Uint32 count);
+        // Wrap the next position of an entity that's left the map through the tunnel and stop it if the edge it's
+        // heading for is in a wall
+        void CollideWithWalls(Uint32 index);
+        // Frame the entity shows at clock
+        Uint16 FrameAt(Uint32 index, Uint32 clock)
+        {
+            Uint16 clip = _pClip[index];
+            return (clip == AnimationLibrary::c_noClip) ? _pStaticFrame[index] : _animations.FrameAt(clip, clock - _pAnimationStart[index]);
+        }
+        static void UpdateJob(void *pContext, Uint32 index);
+        // Make the next state current
+        void SwapBuffers();
+
+        Uint32 _cMaxEntities;           // Capacity of every array below
+        Uint32 _cEntities;              // Live entities, packed at the front
+
+        // Hot state
+        Fixed *_pX;                     // Position, world pixels in 16.16
+        Fixed *_pY;
+        Fixed *_pDX;                    // Velocity, pixels per step in 16.16
+        Fixed *_pDY;
+        Fixed *_pXPrevious;             // Position before the last update, for render interpolation
+        Fixed *_pYPrevious;
+        Uint16 *_pClip;                 // Clip playing, AnimationLibrary::c_noClip shows the static frame
+        Uint32 *_pAnimationStart;       // Clock when the clip was (re)started
+        Uint16 *_pAnimation;            // Sheet animation index _pClip came from, c_noAnimation if none
+        Uint16 *_pFrame;                // Frame showing, from the clip (or static frame) at the clock
+        SDL_bool *_pWallCollision;      // Stopped by walls
+
+        // Colder state
+        Uint16 *_pSheet;                // Sheet the frames come from
+        Uint16 *_pStaticFrame;          // Frame drawn by sheets with no animations
+        Sint16 *_pFrameOffsetX;         // Offset of the frame from the position
+        Sint16 *_pFrameOffsetY;
+        Uint16 *_pLayer;                // Render layer used by RenderAll
+        SDL_bool *_pVisible;            // Visibility flag
+
+        // Handle bookkeeping
+        Uint32 *_pIndexToSlot;          // Packed index -> handle slot
+        Uint32 *_pSlotToIndex;          // Handle slot -> packed index
+        Uint16 *_pGeneration;           // Bumped each time a slot is freed
+        Uint32 *_pFreeSlots;            // Stack of unused slots
+        Uint32 _cFreeSlots;
+
+        SpriteSheet _sheets[c_maxSheets];
+        Uint16 _cSheets;
+        MemoryArena *_pLevelArena;      // Sheet frames and clip tables
+        AnimationLibrary _animations;
+        Uint32 _clock;
+
+        // Collision map, nullptr until SetCollisionMap.  The map's bounds are kept in 16.16 like the positions
+        const CollisionGrid *_pCollisionGrid;
+        Fixed _xMap;
+        Fixed _yMap;
+        Fixed _cxMap;
+        Fixed _cyMap;
+        Uint16 _tileSize;
+        Uint16 _tileShift;
+    };
+}
+}
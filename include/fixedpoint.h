@@ -0,0 +1,40 @@
+#pragma once
+#include "SDL.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // 16.16 signed fixed point, used for every position and velocity the simulation keeps.  Integer adds and shifts
+    // give the same bits on every compiler and CPU (and in every SIMD lane), which doubles don't promise, and half
+    // the size.  That's +/-32K pixels of range with 1/65536 of a pixel of precision, plenty for a tile map
+    typedef Sint32 Fixed;
+
+    static const int FixedShift = 16;
+    static const Fixed FixedOne = 1 << FixedShift;
+
+    inline Fixed FixedFromInt(int value)
+    {
+        // Through unsigned so negative values don't shift into undefined behavior
+        return static_cast<Fixed>(static_cast<Uint32>(value) << FixedShift);
+    }
+
+    // Whole pixel the value is in, rounds toward negative infinity (so -0.5 is pixel -1, unlike a cast)
+    inline int FixedToInt(Fixed value)
+    {
+        return value >> FixedShift;
+    }
+
+    // For rendering and printing only, the simulation never goes back to floating point
+    inline double FixedToDouble(Fixed value)
+    {
+        return static_cast<double>(value) / FixedOne;
+    }
+
+    // Blend from a to b by alpha [0, 1], for render interpolation
+    inline Fixed FixedLerp(Fixed a, Fixed b, double alpha)
+    {
+        return a + static_cast<Fixed>((b - a) * alpha);
+    }
+}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "SDL.h"
+#include "collisiongrid.h"
+#include "threadpool.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Flow fields over a CollisionGrid: for one target, the Direction to move from every cell to get closer to it
+    // along a shortest path (tunnels included, ties go Up, Left, Down then Right like NavigationTable).  Anything
+    // chasing that target just reads its cell.
+    //
+    // Each target has a slot.  Update recomputes, in parallel on the thread pool, only the slots whose target moved to
+    // another tile since its field was built (or everything after GridChanged), the rest keep their field.  A slot
+    // has three buffers used in turn, each Update builds into the one published two Updates ago and then publishes it
+    // by bumping the slot's generation, so Field never takes a lock.  The field it returns stays untouched through
+    // the next Update, a reader that might hold on to it longer checks FieldIntact after reading (a seqlock).
+    //
+    // Distances are kept in 16 bits, a grid with more than c_maxOpenCells open cells gets no directions at all
+    class FlowFieldService
+    {
+    public:
+        static const Uint8 c_noDirection = 0xFF;    // Walls, the target itself and cells that can't reach it
+        static const Uint32 c_maxOpenCells = 0xFFFF;
+
+        // The grid and pool must outlive the service
+        FlowFieldService(const CollisionGrid *pCollisionGrid, ThreadPool *pThreadPool, Uint32 cMaxTargets);
+        ~FlowFieldService();
+
+        // Point slot at a tile, the field follows on the next Update
+        void SetTarget(Uint32 slot, Uint16 row, Uint16 col);
+        // Stop updating slot, its last field stays readable
+        void ClearTarget(Uint32 slot);
+        // Call after changing the grid (CollisionGrid::SetWalkable), every field is rebuilt on the next Update
+        void GridChanged();
+
+        // Rebuild every field whose target changed tile, returns how many were rebuilt.  Called from one thread
+        Uint32 Update();
+
+        // Latest complete field for slot, [row * Cols() + col] is a Direction or c_noDirection.  nullptr until the
+        // first Update after SetTarget.  Safe from any thread, the buffer stays untouched until the second Update
+        // after this one.  pGeneration (if any) gets what to hand FieldIntact
+        const Uint8 *Field(Uint32 slot, Uint32 *pGeneration);
+        const Uint8 *Field(Uint32 slot) { return Field(slot, nullptr); }
+        // Call after reading a field, true if nothing has started rebuilding it since Field handed it out with
+        // generation.  Otherwise what was read may be torn, get the field again and reread
+        bool FieldIntact(Uint32 slot, Uint32 generation);
+        // Way to go from [row][col] toward slot's target, false if there's no field yet or no way to go
+        bool DirectionAt(Uint32 slot, Uint16 row, Uint16 col, Direction &direction);
+
+        Uint32 MaxTargets() { return _cMaxTargets; }
+        Uint16 Rows() { return _cRows; }
+        Uint16 Cols() { return _cCols; }
+
+    private:
+        struct Slot
+        {
+            bool fActive;
+            bool fBuilt;            // The published field is for builtRow/builtCol on the current grid
+            Uint16 targetRow;
+            Uint16 targetCol;
+            Uint16 builtRow;
+            Uint16 builtCol;
+            Uint8 *pFields[3];      // Generation g is in pFields[g % 3]
+            SDL_atomic_t generation;    // Of the published field, 0 before the first one.  Only the building thread sets it
+            Uint16 *pDistances;     // Search scratch
+            Uint32 *pQueue;
+        };
+
+        static void BuildTask(void *pContext, Uint32 index);
+        void IndexNeighbors();
+        void BuildField(Slot &slot);
+
+        const CollisionGrid *_pCollisionGrid;   // Not owned
+        ThreadPool *_pThreadPool;               // Not owned
+        Uint16 _cRows;
+        Uint16 _cCols;
+        Uint32 _cCells;
+        Uint32 *_pNeighbors;        // [cell][Direction], the cell an exit leads to or c_noNeighbor
+        Uint32 _cMaxTargets;
+        Slot *_pSlots;
+        Uint32 *_pPending;          // Slots being rebuilt by the current Update
+        bool _fGridChanged;
+        bool _fTooManyOpenCells;    // More than c_maxOpenCells, the distances would overflow
+    };
+}
+}
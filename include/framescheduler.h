@@ -0,0 +1,48 @@
+#pragma once
+#include "SDL.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Decouples the simulation rate from the display rate.  Real time (from the high resolution performance counter)
+    // is added to an accumulator each frame and the simulation is stepped in fixed size steps until the accumulator
+    // is drained.  What's left over is how far we are between the last two simulation states, which the renderer
+    // uses to interpolate.  If we fall too far behind (debugger, window drag, slow machine) only a limited number of
+    // catch up steps are run and the rest of the time is dropped, otherwise we'd never recover
+    //
+    // Usage:
+    //     scheduler.BeginFrame();
+    //     while (scheduler.StepDue()) { Simulate(); }
+    //     Render(scheduler.Alpha());
+    class FrameScheduler
+    {
+    public:
+        // stepsPerSecond - fixed simulation rate
+        // maxCatchUpSteps - most steps that will be run in a single frame
+        FrameScheduler(Uint32 stepsPerSecond, Uint32 maxCatchUpSteps);
+
+        // Sample the clock and add the elapsed time to the accumulator
+        void BeginFrame();
+        // If a whole step is in the accumulator, consume it and return true
+        bool StepDue();
+        // Fraction [0, 1) of a step left in the accumulator, the blend factor between previous and current state
+        double Alpha();
+        // Time until the next step is due, for sleeping when nothing else limits the frame rate
+        Uint32 MsUntilNextStep();
+
+        // Stats
+        Uint64 StepCount() { return _cSteps; }
+        Uint64 DroppedStepCount() { return _cDroppedSteps; }
+
+    private:
+        Uint64 _frequency;          // Performance counter ticks per second
+        Uint64 _counterPerStep;     // Performance counter ticks in a single step
+        Uint64 _maxAccumulator;     // Cap on the accumulator (maxCatchUpSteps worth)
+        Uint64 _accumulator;        // Unsimulated time
+        Uint64 _lastCounter;        // Counter at the last BeginFrame
+        Uint64 _cSteps;             // Total steps run
+        Uint64 _cDroppedSteps;      // Total steps skipped because we were too far behind
+    };
+}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "SDL.h"
+#include "collisiongrid.h"
+#include "pelletboard.h"
+#include "sprite.h"
+#include "tiledmap.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // A turn the player asked for and hasn't been able to take yet.  Pressing a direction a few pixels before a
+    // junction is normal, so instead of being dropped the turn waits here until the player is on a tile it can be
+    // taken from, or the next direction pressed replaces it
+    struct BufferedTurn
+    {
+        Direction direction;
+        SDL_bool fPending;
+        Direction lastPressed;      // Direction of the latest press, held keys fall back to it while it's still down
+    };
+
+    // Given a player's current state (location, direction, animation) check if the player can move in a given direction, and if
+    // so position the player on the new track at the new velocity.  Returns true if it did
+    bool DoPlayerInputCheck(Sprite *pSprite, TiledMap *pTiledMap, const CollisionGrid *pCollisionGrid, Direction direction, Uint16 row, Uint16 col, Uint16 animationIndex, Fixed dx, Fixed dy);
+
+    // Take the buffered turn if the player's tile allows it, returns true if it was taken this tick.  The buffer is
+    // cleared then, or when the player is already going that way
+    bool DoBufferedTurn(Sprite *pSprite, TiledMap *pTiledMap, const CollisionGrid *pCollisionGrid, BufferedTurn *pTurn);
+
+    // Even if no input is pressed, the player may run into a wall, so we need to handle collisions
+    // after the player is moved.  Leaving the map through a tunnel brings the player back in on the other side.
+    // The game has the store do this for every entity with wall collision as part of UpdateAll, this is the single
+    // sprite version it's checked against
+    void DoPlayerBoundsCheck(Sprite *pSprite, TiledMap *pTiledMap, const CollisionGrid *pCollisionGrid);
+
+    // Eat the pellet on the player's tile, if there is one, and return what it was.  pfnTileChanged (if any) gets the
+    // eaten cell, or when that was the last pellet every cell the board reset puts one back on, so the map is redrawn
+    // a cell at a time
+    PelletType DoPlayerPelletCheck(Sprite *pSprite, TiledMap *pTiledMap, PelletBoard *pPellets, PelletTileCallback pfnTileChanged, void *pContext);
+}
+}
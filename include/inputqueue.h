@@ -0,0 +1,66 @@
+#pragma once
+#include "SDL.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // A key going down or up, as its button bit (see InputButtonFromScancode)
+    struct InputEvent
+    {
+        Uint32 msTimestamp;         // When SDL saw it (SDL_GetTicks time)
+        Uint8 button;
+        Uint8 fDown;
+    };
+
+    struct InputLatencyStats
+    {
+        Uint32 cTurns;              // Key presses that led to a turn (the first turn after each)
+        double msMean;              // From the key press to the tick the turn was taken, including any wait for the
+        Uint32 msMax;               // player to reach a tile the turn could be taken from
+        Uint32 cDropped;            // Events lost to a full queue
+    };
+
+    // Carries key events from the thread pumping SDL's events to the simulation through a lock-free single producer,
+    // single consumer ring.  The simulation folds them into one set of buttons per tick, so a key pressed and released
+    // between two ticks still shows up on the next one instead of falling between two samples of the keyboard
+    class InputQueue
+    {
+    public:
+        InputQueue(Uint32 cMaxEvents);
+        ~InputQueue();
+
+        // EVENT THREAD
+        // Queue an SDL_KEYDOWN or SDL_KEYUP.  Keys the simulation doesn't use and auto repeats are left out.  False if
+        // the queue is full and the event was dropped
+        bool PushKeyEvent(const SDL_KeyboardEvent &keyEvent);
+
+        // SIMULATION THREAD
+        // Take every event queued so far.  Returns the buttons held now plus any pressed since the last call, even
+        // if they were released again.  If a direction was pressed since the last call, only the one pressed last (in
+        // event order) is returned, with InputButtonFreshDirection, so ProcessInput knows which one to turn to
+        Uint8 NextTickButtons();
+        // A turn the button asked for was taken.  The first one after each press counts the time since that press,
+        // later ones (the key still held) aren't counted
+        void NoteTurnTaken(Uint8 button);
+        // Only once the simulation has stopped
+        InputLatencyStats LatencyStats();
+
+    private:
+        static const Uint32 c_cButtons = 8;
+
+        InputEvent *_pEvents;
+        Uint32 _cMaxEvents;         // Power of 2
+        SDL_atomic_t _head;         // Next slot written, only the event thread moves it
+        SDL_atomic_t _tail;         // Next slot read, only the simulation moves it
+        SDL_atomic_t _cDropped;
+
+        // Simulation side
+        Uint8 _heldButtons;
+        Uint32 _msPressed[c_cButtons];  // Latest press of each button not turned on yet, 0 if none
+        Uint32 _cTurns;
+        Uint64 _msLatencyTotal;
+        Uint32 _msLatencyMax;
+    };
+}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "SDL.h"
+#include "entitystore.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Hash of the simulation state that matters for reproducing a run, every entity's position and animation (clip
+    // and start tick) and the clock.  Two runs that got the same input tick for tick must come out with the same
+    // value every tick
+    Uint32 SimulationChecksum(EntityStore *pEntityStore);
+
+    // A tick's input is the buttons ProcessInput looks at packed one bit each (1 << button).  The direction buttons
+    // are numbered like Direction, WASD land on the same ones as the arrows
+    static const Uint8 InputButtonDeath = 4;            // X
+    static const Uint8 InputButtonQuit = 5;             // ESC
+    // Not a key.  Set on a tick a direction was pressed, that direction is then the only one set (the one pressed
+    // last if there were several) even if others are still held.  Without it the direction bits are the ones held
+    static const Uint8 InputButtonFreshDirection = 6;
+    static const Uint8 InputDirectionButtons = 0x0F;
+
+    // Bit of the button a key is on, -1 if ProcessInput doesn't use it
+    int InputButtonFromScancode(SDL_Scancode scancode);
+
+    // Logs the buttons ProcessInput saw each tick, and the SimulationChecksum after the tick, so the run can be played
+    // back with InputReplay.  Ticks are stored as runs of identical input since keys are held for many ticks at a time.
+    //
+    // File layout (little endian): "PMCR", version, tick count, run bytes, then the runs (button bits and a LEB128
+    // tick count each) and a 32 bit checksum per tick
+    class InputRecorder
+    {
+    public:
+        InputRecorder();
+        ~InputRecorder();
+
+        // Call once per tick with the buttons given to ProcessInput and the checksum after the tick ran
+        void Record(Uint8 buttons, Uint32 checksum);
+        bool Save(const char *szFileName);
+
+        Uint32 TickCount() { return _cTicks; }
+
+    private:
+        void AppendRun();
+
+        Uint8 *_pRuns;
+        Uint32 _cbRuns;
+        Uint32 _cbMaxRuns;
+        Uint32 *_pChecksums;        // One per tick
+        Uint32 _cTicks;
+        Uint32 _cMaxTicks;
+        Uint8 _currentButtons;      // Input of the run still being counted
+        Uint32 _cCurrentRun;
+    };
+
+    // Plays back a file written by InputRecorder: hands out the recorded buttons tick by tick, to go through
+    // ProcessInput like live input, and checks the simulation lands on the recorded checksum after each one
+    class InputReplay
+    {
+    public:
+        InputReplay();
+        ~InputReplay();
+
+        bool Load(const char *szFileName);
+
+        // Buttons for the next tick, false once every recorded tick has been played
+        bool NextButtons(Uint8 *pButtons);
+        // Compare the state after the tick NextButtons last returned with the recording, false on a mismatch
+        bool VerifyTick(Uint32 checksum);
+
+        Uint32 TickCount() { return _cTicks; }
+        Uint32 CurrentTick() { return _iTick; }
+        Uint32 MismatchCount() { return _cMismatches; }
+        // First tick (1 based) that didn't match, 0 if none
+        Uint32 FirstMismatchTick() { return _firstMismatchTick; }
+
+    private:
+        Uint8 *_pFile;              // Whole file
+        const Uint8 *_pRuns;
+        const Uint8 *_pRunsEnd;
+        const Uint8 *_pNextRun;
+        const Uint8 *_pChecksums;   // Unaligned, read a byte at a time
+        Uint32 _cTicks;
+        Uint32 _iTick;              // Ticks handed out so far
+        Uint32 _cRunRemaining;      // Ticks left in the current run
+        Uint32 _cMismatches;
+        Uint32 _firstMismatchTick;
+        Uint8 _buttons;             // Of the current run
+    };
+}
+}
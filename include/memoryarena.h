@@ -0,0 +1,218 @@
+#pragma once
+#include "SDL.h"
+#include <stdio.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Linear allocator over one block, for whatever lives exactly as long as a level (map chunks, sprite sheets,
+    // pools of actors).  Allocating is a pointer bump and nothing is freed on its own, Reset (or destroying the
+    // arena) drops it all at once at level teardown.  Nothing in it gets a destructor run, so it either holds plain
+    // data or its owner destroys it first (ObjectPool does that for its objects)
+    class MemoryArena
+    {
+    public:
+        MemoryArena(size_t cbCapacity);
+        ~MemoryArena();
+
+        // cb bytes aligned to alignment (a power of 2), nullptr if the arena is full
+        void *Allocate(size_t cb, size_t alignment);
+        // count zeroed Ts, like new T[count] { } but without the heap
+        template<typename T>
+        T *AllocateArray(size_t count)
+        {
+            static_assert(std::is_trivially_destructible<T>::value, "arena memory is never destroyed, only plain data");
+            T *pArray = static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+            if (pArray != nullptr)
+            {
+                SDL_memset(pArray, 0, count * sizeof(T));
+            }
+            return pArray;
+        }
+        // Drop every allocation, the memory is reused by the next level
+        void Reset();
+
+        size_t BytesUsed() { return _cbUsed; }
+        size_t Capacity() { return _cbCapacity; }
+        // Most ever used at once, to size the arena
+        size_t HighWater() { return _cbHighWater; }
+
+    private:
+        Uint8 *_pBase;
+        size_t _cbCapacity;
+        size_t _cbUsed;
+        size_t _cbHighWater;
+    };
+
+    // A fixed number of Ts carved out of an arena, handed out and taken back without touching the heap so actors
+    // can come and go during play.  Create constructs one in a free slot, Destroy runs its destructor and the slot
+    // goes to the next Create.  Anything still alive when the pool goes away is destroyed then
+    template<typename T>
+    class ObjectPool
+    {
+    public:
+        ObjectPool(MemoryArena *pArena, Uint32 cMaxObjects) :
+            _pSlots(static_cast<Slot*>(pArena->Allocate(cMaxObjects * sizeof(Slot), alignof(Slot)))),
+            _pLive(pArena->AllocateArray<SDL_bool>(cMaxObjects)),
+            _pFreeSlots(pArena->AllocateArray<Uint32>(cMaxObjects)),
+            _cFreeSlots(0),
+            _cMaxObjects(cMaxObjects)
+        {
+            SDL_assert((_pSlots != nullptr) && (_pLive != nullptr) && (_pFreeSlots != nullptr));
+
+            // Hand out low slots first
+            for (Uint32 i = 0; i < _cMaxObjects; i++)
+            {
+                _pFreeSlots[i] = _cMaxObjects - 1 - i;
+            }
+            _cFreeSlots = _cMaxObjects;
+        }
+
+        ~ObjectPool()
+        {
+            for (Uint32 slot = 0; slot < _cMaxObjects; slot++)
+            {
+                if (_pLive[slot] == SDL_TRUE)
+                {
+                    reinterpret_cast<T*>(&_pSlots[slot])->~T();
+                }
+            }
+        }
+
+        // Construct a T from args, nullptr if every slot is taken
+        template<typename... Args>
+        T *Create(Args&&... args)
+        {
+            if (_cFreeSlots == 0)
+            {
+                printf("ObjectPool::Create() : pool is full (%u objects)\n", _cMaxObjects);
+                return nullptr;
+            }
+
+            Uint32 slot = _pFreeSlots[--_cFreeSlots];
+            _pLive[slot] = SDL_TRUE;
+            return new (&_pSlots[slot]) T(std::forward<Args>(args)...);
+        }
+
+        void Destroy(T *pObject)
+        {
+            if (pObject == nullptr)
+            {
+                return;
+            }
+
+            Uint32 slot = static_cast<Uint32>(reinterpret_cast<Slot*>(pObject) - _pSlots);
+            SDL_assert((slot < _cMaxObjects) && (_pLive[slot] == SDL_TRUE));
+            pObject->~T();
+            _pLive[slot] = SDL_FALSE;
+            _pFreeSlots[_cFreeSlots++] = slot;
+        }
+
+        Uint32 Count() { return _cMaxObjects - _cFreeSlots; }
+        Uint32 Capacity() { return _cMaxObjects; }
+
+    private:
+        // Room for one T, constructed in place
+        typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Slot;
+
+        Slot *_pSlots;
+        SDL_bool *_pLive;           // Slot holds a constructed T
+        Uint32 *_pFreeSlots;        // Stack of unused slots
+        Uint32 _cFreeSlots;
+        Uint32 _cMaxObjects;
+    };
+
+    // Frames a loop expects to allocate in: the first few, while SDL's buffers and the caches grow to size, and a
+    // few more after anything that rebuilds them (a new chunk cache, a device reset).  Only the frames after that
+    // are checked by ASSERT_NO_ALLOCATIONS_ONCE_WARM
+    class AllocationWarmup
+    {
+    public:
+        AllocationWarmup(Uint32 cFrames) :
+            _cFrames(cFrames),
+            _cLeft(cFrames),
+            _fWarmingUp(true)
+        {
+        }
+
+        // Once as each frame starts drawing, frames that don't draw anything count as the one before
+        void BeginFrame()
+        {
+            _fWarmingUp = (_cLeft > 0);
+            _cLeft -= _fWarmingUp ? 1 : 0;
+        }
+        // Something is about to allocate again, the warm up starts over (this frame included)
+        void Restart()
+        {
+            _fWarmingUp = true;
+            _cLeft = _cFrames;
+        }
+        bool IsWarmingUp() const { return _fWarmingUp; }
+
+    private:
+        Uint32 _cFrames;
+        Uint32 _cLeft;
+        bool _fWarmingUp;
+    };
+
+    // Debug builds count every operator new per thread, and every SDL_malloc once TRACK_SDL_ALLOCATIONS has run, so
+    // the frame loops can assert they run entirely out of the pools and arenas set up before the first frame.  Plain
+    // malloc calls (the C runtime, graphics drivers) aren't seen.  Release builds leave the heap alone
+#ifndef NDEBUG
+#define PMC_ALLOCATION_TRACKING
+#endif
+
+#ifdef PMC_ALLOCATION_TRACKING
+    // Heap allocations (new, new[] and SDL's) the calling thread has made so far
+    Uint64 ThreadAllocationCount();
+    // Route SDL's allocator through the count, before SDL_Init so nothing it allocates is missed
+    void TrackSDLAllocations();
+
+    // Asserts nothing the enclosing scope ran on this thread allocated from the heap, unless pWarmup (if any) says
+    // it's still warming up when the scope ends
+    class ScopedNoAllocations
+    {
+    public:
+        ScopedNoAllocations(const char *szScope, const AllocationWarmup *pWarmup = nullptr) :
+            _szScope(szScope),
+            _pWarmup(pWarmup),
+            _cAllocationsStart(ThreadAllocationCount())
+        {
+        }
+
+        ~ScopedNoAllocations()
+        {
+            if ((_pWarmup != nullptr) && _pWarmup->IsWarmingUp())
+            {
+                return;
+            }
+            Uint64 cAllocations = ThreadAllocationCount() - _cAllocationsStart;
+            if (cAllocations != 0)
+            {
+                printf("%s made %u heap allocation(s)\n", _szScope, static_cast<Uint32>(cAllocations));
+            }
+            SDL_assert(cAllocations == 0);
+        }
+
+    private:
+        const char *_szScope;
+        const AllocationWarmup *_pWarmup;
+        Uint64 _cAllocationsStart;
+    };
+
+#define ALLOCATION_CONCAT_INNER(a, b) a##b
+#define ALLOCATION_CONCAT(a, b) ALLOCATION_CONCAT_INNER(a, b)
+#define ASSERT_NO_ALLOCATIONS(szScope) XplatGameTutorial::PacManClone::ScopedNoAllocations ALLOCATION_CONCAT(scopedNoAllocations, __LINE__)(szScope)
+#define ASSERT_NO_ALLOCATIONS_ONCE_WARM(szScope, pWarmup) XplatGameTutorial::PacManClone::ScopedNoAllocations ALLOCATION_CONCAT(scopedNoAllocations, __LINE__)(szScope, pWarmup)
+#define TRACK_SDL_ALLOCATIONS() XplatGameTutorial::PacManClone::TrackSDLAllocations()
+#else
+#define ASSERT_NO_ALLOCATIONS(szScope)
+#define ASSERT_NO_ALLOCATIONS_ONCE_WARM(szScope, pWarmup)
+#define TRACK_SDL_ALLOCATIONS()
+#endif
+}
+}
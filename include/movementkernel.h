@@ -0,0 +1,61 @@
+#pragma once
+#include "SDL.h"
+#include "tiledmap.h"
+#include "fixedpoint.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Which implementation MoveAndCollide uses.  Auto picks the widest one the CPU supports
+    enum class KernelPath
+    {
+        Auto = 0,
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    // Everything the kernel needs to know about the map, flattened so it can be broadcast into vector registers.
+    // Build it once per map with InitializeMovementKernelMap
+    struct MovementKernelMap
+    {
+        Sint32 xMap;            // Map bounds on screen (TiledMap::GetMapBounds)
+        Sint32 yMap;
+        Sint32 cxMap;
+        Sint32 cyMap;
+        Sint32 tileShift;       // log2 of the tile size, tiles must be a power of 2
+        Sint32 cCols;           // Columns in the collision map
+        Sint32 xProbe;          // How far ahead of the position (in the direction of travel) the wall check is made
+        Sint32 yProbe;
+        Sint32 *pCollision;     // Collision map widened to 32 bits so it can be gathered, 1 == wall
+    };
+
+    // Parallel arrays for N actors, any of which may be moving
+    struct MovementBatch
+    {
+        Fixed *pX;              // Position (16.16)
+        Fixed *pY;
+        Fixed *pDX;             // Velocity (16.16), zeroed for actors that end up in a wall
+        Fixed *pDY;
+        Fixed *pXPrevious;      // Receives the position before the move (for render interpolation)
+        Fixed *pYPrevious;
+        Uint32 cActors;
+    };
+
+    // Copies what's needed out of the map and collision data.  xProbe/yProbe match DoPlayerBoundsCheck for sprites of
+    // that size (half the sprite less half a tile)
+    bool InitializeMovementKernelMap(MovementKernelMap &kernelMap, TiledMap *pTiledMap, const Uint16 *pCollisionMap, Sint32 xProbe, Sint32 yProbe);
+    void FreeMovementKernelMap(MovementKernelMap &kernelMap);
+
+    // For every actor: integrate the position, probe ahead in the direction of travel, convert the probe to a tile and
+    // stop the actor if that tile is a wall.  This is Sprite::Update followed by DoPlayerBoundsCheck, for N actors at
+    // once (except that tunnels don't wrap, actors stop at the edge of the map), and every path gives bit-identical
+    // results to the scalar one
+    void MoveAndCollide(MovementBatch &batch, const MovementKernelMap &kernelMap, KernelPath path);
+
+    // The path Auto resolves to on this machine
+    KernelPath BestKernelPath();
+    const char* KernelPathName(KernelPath path);
+}
+}
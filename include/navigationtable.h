@@ -0,0 +1,69 @@
+#pragma once
+#include "SDL.h"
+#include "collisiongrid.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Shortest path distances and first steps between every pair of open cells in a CollisionGrid, so "how far is
+    // it from A to B" and "which way do I go from A to get to B" are a table lookup.  Moves follow the grid's exits,
+    // tunnels included.
+    //
+    // The open cells are numbered and the tables are [target][from]: a 16 bit distance and a 2 bit Direction (4 per
+    // byte).  Each target's entries come from one breadth first search out of it.  When the grid changes every target
+    // goes stale, a stale target is searched again the first time it's asked about, or ahead of time by Refresh
+    class NavigationTable
+    {
+    public:
+        static const Uint16 c_unreachable = 0xFFFF;     // Distance to/from a wall, or across unconnected areas
+        static const Uint32 c_maxNodes = 4096;          // Open cells supported, the distances alone are 32MB at this size
+
+        NavigationTable();
+        ~NavigationTable();
+
+        // Number the grid's open cells and fill in every pair.  The grid must outlive the table
+        bool Build(const CollisionGrid *pCollisionGrid);
+        // Call after changing the grid (CollisionGrid::SetWalkable).  The cells are numbered again and every target is
+        // marked stale, nothing is searched until it's needed
+        bool GridChanged();
+        // Search up to cTargets stale targets (e.g. a few per frame after GridChanged), returns how many are left
+        Uint32 Refresh(Uint32 cTargets);
+
+        // Moves from [fromRow][fromCol] to [toRow][toCol], c_unreachable if there's no way there
+        Uint16 Distance(Uint16 fromRow, Uint16 fromCol, Uint16 toRow, Uint16 toCol);
+        // First move on a shortest path from [fromRow][fromCol] to [toRow][toCol], ties go Up, Left, Down then Right.
+        // False if there's no way there or we're already there
+        bool NextDirection(Uint16 fromRow, Uint16 fromCol, Uint16 toRow, Uint16 toCol, Direction &direction);
+
+        Uint32 NodeCount() { return _cNodes; }
+        Uint32 StaleCount() { return _cStale; }
+        // Bytes used by the tables
+        Uint32 SizeInBytes();
+
+    private:
+        static const Uint16 c_noNode = 0xFFFF;
+
+        // Node for a cell, c_noNode for walls and anything off the map
+        Uint16 NodeAt(Uint16 row, Uint16 col)
+        {
+            return ((row < _cRows) && (col < _cCols)) ? _pNodeOfCell[(row * _cCols) + col] : c_noNode;
+        }
+        bool IndexNodes();
+        void FreeTables();
+        void SearchFrom(Uint16 target);
+
+        const CollisionGrid *_pCollisionGrid;   // Not owned
+        Uint16 _cRows;
+        Uint16 _cCols;
+        Uint16 *_pNodeOfCell;       // [_cRows * _cCols], c_noNode for walls
+        Uint16 *_pNeighbors;        // [node][Direction], c_noNode where there's no exit
+        Uint32 _cNodes;
+        Uint16 *_pDistances;        // [target][from]
+        Uint8 *_pNextHops;          // [target][from] 2 bit Directions, 4 per byte
+        Uint8 *_pStale;             // [target], needs searching again
+        Uint32 _cStale;
+        Uint16 *_pQueue;            // Search scratch, one entry per node
+    };
+}
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "SDL.h"
+#include "memoryarena.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    enum class PelletType
+    {
+        None = 0,
+        Pellet,
+        Power
+    };
+
+    // Called for each cell whose tile changes, with the tile it should show now
+    typedef void (*PelletTileCallback)(void *pContext, Uint16 row, Uint16 col, Uint16 tileIndex);
+
+    // The pellets left in the maze packed one bit per cell (rows padded to 64 bit words), with the power pellets in a
+    // second board of the same shape.  Built once from the map's tile indicies, after that eating one is a bit test
+    // and clear and the count left is kept as they go, so nothing ever scans or rewrites the map.  The boards as
+    // built are kept next to the live ones, a level reset puts them back with a single copy.
+    //
+    // Everything comes out of the level's arena
+    class PelletBoard
+    {
+    public:
+        // pLevelArena holds the boards, it has to outlive this
+        PelletBoard(Uint16 rows, Uint16 cols, MemoryArena *pLevelArena);
+
+        // (Re)build both boards from tile indicies laid out like the map's, pelletTile and powerTile are the two
+        // kinds of pellet and emptyTile is what's left when one is eaten
+        void Build(const Uint16 *pMapIndicies, Uint16 pelletTile, Uint16 powerTile, Uint16 emptyTile);
+
+        // What's at [row][col], None outside the map
+        PelletType PelletAt(Uint16 row, Uint16 col) const
+        {
+            if ((row >= _cRows) || (col >= _cCols))
+            {
+                return PelletType::None;
+            }
+            Uint32 word = (row * _cWordsPerRow) + (col >> 6);
+            Uint64 bit = 1ULL << (col & 63);
+            return (_pPellets[word] & bit) == 0 ? PelletType::None : ((_pPower[word] & bit) == 0 ? PelletType::Pellet : PelletType::Power);
+        }
+        // Take the pellet at [row][col] off the board, returns what was there
+        PelletType Eat(Uint16 row, Uint16 col);
+        // Put back every pellet eaten since the last Build or Reset.  pfnTileChanged (if any) is told about each
+        // restored cell first, so only those get redrawn
+        void Reset(PelletTileCallback pfnTileChanged, void *pContext);
+
+        Uint32 Remaining() const { return _cRemaining; }
+        Uint32 Total() const { return _cTotal; }
+        bool IsCleared() const { return _cRemaining == 0; }
+        Uint16 EmptyTile() const { return _emptyTile; }
+        // Bytes used by the live and initial boards
+        Uint32 SizeInBytes() const { return 4 * _cRows * _cWordsPerRow * sizeof(Uint64); }
+
+    private:
+        Uint16 _cRows;
+        Uint16 _cCols;
+        Uint32 _cWordsPerRow;       // 64 cells per word, the bits past _cCols are always 0
+        Uint64 *_pBoards;           // Pellets then power pellets, [2][_cRows][_cWordsPerRow], one block so it copies at once
+        Uint64 *_pPellets;          // Every pellet, power ones included
+        Uint64 *_pPower;            // Power pellets only
+        Uint64 *_pInitialBoards;    // _pBoards as built
+        Uint32 _cRemaining;
+        Uint32 _cTotal;
+        Uint16 _pelletTile;
+        Uint16 _powerTile;
+        Uint16 _emptyTile;
+    };
+}
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include "SDL.h"
+
+// Frame phase instrumentation.  Build with PMC_PROFILING defined (make PROFILE=1) to turn it on, otherwise every
+// PROFILE_* macro below expands to nothing and none of this code is compiled in.
+//
+//     PROFILE_BEGIN_FRAME();                           // once at the top of each frame
+//     { PROFILE_SCOPE(ProfilePhase::Update); ... }     // time a block, repeated blocks in a frame add up
+//     PROFILE_REPORT("./frametimes.csv");              // print stats and dump the raw samples at exit
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // The parts of a frame we time.  Keep ProfilePhaseNames and ProfilePhaseColors in profiler.cpp in the same order
+    enum class ProfilePhase
+    {
+        Input = 0,
+        Update,         // Every entity moved, stopped at the walls and animated
+        Contacts,
+        Pellets,
+        FlowFields,
+        MapRender,
+        SpriteRender,
+        BatchFlush,
+        Present,
+        Sleep,
+        Count
+    };
+
+#ifdef PMC_PROFILING
+    // Summary of one phase over the samples currently in the ring buffer, all in milliseconds
+    struct ProfilePhaseStats
+    {
+        double msMin;
+        double msMean;
+        double msP50;
+        double msP95;
+        double msP99;
+        double msMax;
+        Uint32 cSamples;
+    };
+
+    // Keeps the time spent in each phase for the last c_cFrames frames in a ring buffer
+    class Profiler
+    {
+    public:
+        static const Uint32 c_cFrames = 1024;
+        static const Uint32 c_cPhases = static_cast<Uint32>(ProfilePhase::Count);
+
+        // One per process, the macros all go through this
+        static Profiler& Instance();
+
+        // Close out the current frame and start recording the next, the first call only starts recording
+        void BeginFrame();
+        // Add counter ticks to a phase in the current frame
+        void AddSample(ProfilePhase phase, Uint64 counterTicks)
+        {
+            _samples[static_cast<Uint32>(phase)][_iFrame] += counterTicks;
+        }
+        // Add the counter ticks another thread gathered with PROFILE_SCOPE_INTO, one entry per phase
+        void AddSamples(const Uint64 *pCounterTicks)
+        {
+            for (Uint32 phase = 0; phase < c_cPhases; phase++)
+            {
+                _samples[phase][_iFrame] += pCounterTicks[phase];
+            }
+        }
+
+        ProfilePhaseStats GetStats(ProfilePhase phase);
+        // Print the per phase stats to stdout and write every sample in the ring buffer to a CSV file
+        void Report(const char *szCsvFileName);
+        // Bar per phase showing the last frame (solid) and the mean (marker) against a 60Hz frame budget
+        void RenderOverlay(SDL_Renderer *pSDLRenderer);
+        void ToggleOverlay() { _fOverlay = (_fOverlay == SDL_TRUE) ? SDL_FALSE : SDL_TRUE; }
+
+    private:
+        Profiler();
+
+        Uint64 _frequency;                      // Performance counter ticks per second
+        Uint32 _iFrame;                         // Slot in the ring for the current frame
+        Uint32 _cFrames;                        // Completed frames in the ring (up to c_cFrames)
+        Uint64 _samples[c_cPhases][c_cFrames];  // Counter ticks per phase per frame
+        Uint64 _totals[c_cPhases];              // Running sum of the completed frames, for a cheap mean
+        SDL_bool _fRecording;                   // BeginFrame has been called, _iFrame is a real frame
+        SDL_bool _fOverlay;                     // Draw the overlay
+    };
+
+    // Times from construction to the end of the enclosing scope
+    class ScopedProfileTimer
+    {
+    public:
+        ScopedProfileTimer(ProfilePhase phase) :
+            _phase(phase),
+            _startCounter(SDL_GetPerformanceCounter())
+        {
+        }
+
+        ~ScopedProfileTimer()
+        {
+            Profiler::Instance().AddSample(_phase, SDL_GetPerformanceCounter() - _startCounter);
+        }
+
+    private:
+        ProfilePhase _phase;
+        Uint64 _startCounter;
+    };
+
+    // Same, but into pCounterTicks[phase], for threads other than the one running the frames.  That thread hands
+    // the counters over (e.g. in a RenderSnapshot) and the frame's thread adds them with PROFILE_ADD_SAMPLES
+    class ScopedProfileCounter
+    {
+    public:
+        ScopedProfileCounter(ProfilePhase phase, Uint64 *pCounterTicks) :
+            _pCounterTicks(&pCounterTicks[static_cast<Uint32>(phase)]),
+            _startCounter(SDL_GetPerformanceCounter())
+        {
+        }
+
+        ~ScopedProfileCounter()
+        {
+            *_pCounterTicks += SDL_GetPerformanceCounter() - _startCounter;
+        }
+
+    private:
+        Uint64 *_pCounterTicks;
+        Uint64 _startCounter;
+    };
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(phase) XplatGameTutorial::PacManClone::ScopedProfileTimer PROFILE_CONCAT(scopedProfileTimer, __LINE__)(phase)
+#define PROFILE_SCOPE_INTO(phase, pCounterTicks) XplatGameTutorial::PacManClone::ScopedProfileCounter PROFILE_CONCAT(scopedProfileCounter, __LINE__)(phase, pCounterTicks)
+#define PROFILE_ADD_SAMPLES(pCounterTicks) XplatGameTutorial::PacManClone::Profiler::Instance().AddSamples(pCounterTicks)
+#define PROFILE_BEGIN_FRAME() XplatGameTutorial::PacManClone::Profiler::Instance().BeginFrame()
+#define PROFILE_RENDER_OVERLAY(pSDLRenderer) XplatGameTutorial::PacManClone::Profiler::Instance().RenderOverlay(pSDLRenderer)
+#define PROFILE_TOGGLE_OVERLAY() XplatGameTutorial::PacManClone::Profiler::Instance().ToggleOverlay()
+#define PROFILE_REPORT(szCsvFileName) XplatGameTutorial::PacManClone::Profiler::Instance().Report(szCsvFileName)
+#else
+#define PROFILE_SCOPE(phase)
+#define PROFILE_SCOPE_INTO(phase, pCounterTicks)
+#define PROFILE_ADD_SAMPLES(pCounterTicks)
+#define PROFILE_BEGIN_FRAME()
+#define PROFILE_RENDER_OVERLAY(pSDLRenderer)
+#define PROFILE_TOGGLE_OVERLAY()
+#define PROFILE_REPORT(szCsvFileName)
+#endif
+}
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "SDL.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Per-frame counters so we can see what the batching is buying us
+    struct RenderBatchStats
+    {
+        Uint32 cQuads;              // Textured quads submitted
+        Uint32 cBatches;            // Draw submissions made to the renderer
+        Uint32 cTextureSwitches;    // Times the texture changed between submissions
+    };
+
+    // Collects textured quads for a frame and draws them with one geometry submission per run of quads that share
+    // a texture.  Quads are ordered by layer first (lower layers are drawn first), then grouped by texture.  Inside
+    // a layer, quads on the same texture keep the order they were added, but there is no ordering between textures,
+    // so anything that must overlap something else needs its own layer.  Adjacent layers drawn from the same texture
+    // (see TextureAtlas) share a submission
+    class RenderBatch
+    {
+    public:
+        // pSDLRenderer - renderer the batch is drawn to
+        // cMaxQuads - capacity, if exceeded the batch flushes early
+        RenderBatch(SDL_Renderer *pSDLRenderer, Uint32 cMaxQuads);
+        ~RenderBatch();
+
+        // Start a new frame, resets the counters
+        void Begin();
+        // Queue a quad, srcRect is in texture pixels and dstRect in world pixels (screen pixels plus the view origin)
+        void AddQuad(SDL_Texture *pTexture, const SDL_Rect &srcRect, const SDL_Rect &dstRect, Uint16 layer);
+        // Sort and draw everything queued so far
+        void Flush();
+
+        // World position drawn at the screen's top left corner, e.g. TiledMap::Camera().  Applies to quads added after it
+        void SetViewOrigin(SDL_Point viewOrigin) { _viewOrigin = viewOrigin; }
+
+        // Counters for the current (or just finished) frame
+        const RenderBatchStats& Stats() { return _stats; }
+
+    private:
+        // Sort key is [layer:16][texture slot:16][submission order:32] so a plain sort gives us draw order
+        struct Quad
+        {
+            Uint64 sortKey;
+            SDL_Rect srcRect;
+            SDL_Rect dstRect;
+        };
+
+        // Small table of textures seen in the frame, so we don't query the size per quad
+        struct TextureSlot
+        {
+            SDL_Texture *pTexture;
+            float cxTexture;
+            float cyTexture;
+        };
+
+        static const Uint16 c_maxTextureSlots = 16;
+
+        Uint16 FindTextureSlot(SDL_Texture *pTexture);
+        void DrawRun(Uint32 iFirst, Uint32 iEnd);
+
+        SDL_Renderer *_pSDLRenderer;    // Not owned
+        Uint32 _cMaxQuads;              // Capacity of the arrays below
+        Uint32 _cQuads;                 // Quads waiting to be drawn
+        Quad *_pQuads;                  // Queued quads
+        SDL_Vertex *_pVertices;         // 4 per quad, filled on Flush
+        int *_pIndices;                 // 6 per quad (2 triangles), these never change so are built once
+        TextureSlot _textureSlots[c_maxTextureSlots];
+        Uint16 _cTextureSlots;
+        SDL_Texture *_pLastTexture;     // Last texture drawn, used to count switches
+        RenderBatchStats _stats;
+        SDL_Point _viewOrigin;          // Subtracted from every dstRect
+    };
+}
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include "SDL.h"
+#include "fixedpoint.h"
+#include "profiler.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // What the renderer needs of one visible sprite, everything else about the entity stays with the simulation
+    struct SnapshotSprite
+    {
+        Fixed x;                    // Position after the last tick and before it, blended by the renderer
+        Fixed y;
+        Fixed xPrevious;
+        Fixed yPrevious;
+        Uint16 sheet;
+        Uint16 frame;               // Frame on the sheet, already resolved from the animation
+        Sint16 xFrameOffset;
+        Sint16 yFrameOffset;
+        Uint16 layer;
+    };
+
+    // A SetTile the renderer hasn't applied yet.  Sequence numbers only go up, so a change is applied exactly once
+    // however many snapshots carry it
+    struct SnapshotTile
+    {
+        Uint32 sequence;
+        Uint16 row;
+        Uint16 col;
+        Uint16 index;
+    };
+
+    // Everything needed to draw one simulation tick, without touching the simulation's own state
+    struct RenderSnapshot
+    {
+        Uint64 tick;                // Simulation ticks run when this was taken
+        Uint64 publishCounter;      // Performance counter when it was published
+        SDL_Point focus;            // World point the camera follows
+        Uint32 cSprites;            // Visible sprites only
+        SnapshotSprite *pSprites;
+        Uint32 cTiles;              // Tile changes not yet acknowledged by the renderer, oldest first
+        SnapshotTile *pTiles;
+        Uint64 profileCounters[static_cast<Uint32>(ProfilePhase::Count)];  // Simulation phase time since the last one (PMC_PROFILING)
+    };
+
+    struct RenderSnapshotStats
+    {
+        Uint32 cPublished;          // Snapshots the simulation published
+        Uint32 cDropped;            // Published but replaced before the renderer ever picked them up
+        Uint32 cPresented;          // Frames the renderer presented
+        Uint32 cDuplicated;         // Presented frames that showed the same snapshot as the frame before
+        double msAgeMean;           // Publish to present, over the presented frames
+        double msAgeMax;
+    };
+
+    // Hands snapshots from the simulation thread to the render thread through a lock-free triple buffer.  The
+    // simulation fills the back buffer and publishes it by swapping it with the middle one, the renderer takes the
+    // middle one whenever a newer snapshot is waiting there.  Neither side ever waits on the other: the simulation
+    // always has a buffer to write and the renderer always has the newest complete snapshot to draw.
+    //
+    // Tile changes are queued by the simulation and carried by every snapshot until the renderer acknowledges them,
+    // so one that lands in a dropped snapshot still gets drawn
+    class RenderSnapshotBuffer
+    {
+    public:
+        RenderSnapshotBuffer(Uint32 cMaxSprites, Uint32 cMaxTiles);
+        ~RenderSnapshotBuffer();
+
+        Uint32 MaxSprites() { return _cMaxSprites; }
+
+        // SIMULATION THREAD
+        // Buffer to fill for the next Publish
+        RenderSnapshot *WriteBuffer() { return &_snapshots[_iBack]; }
+        // Note a SetTile for the renderer, goes out with the next Publish
+        void QueueTileChange(Uint16 row, Uint16 col, Uint16 index);
+        // Add the queued tile changes, stamp the snapshot and make it the newest
+        void Publish();
+
+        // RENDER THREAD
+        // The newest published snapshot, nullptr until there is one.  fNew is false when it's the same one as last
+        // time.  Valid until the next AcquireLatest
+        const RenderSnapshot *AcquireLatest(bool &fNew);
+        // Tile changes with a sequence greater than this have not been applied yet
+        Uint32 AppliedTileSequence() { return _appliedTileSequence; }
+        // The snapshot's tile changes have been applied, the simulation can stop sending them
+        void AcknowledgeTiles(const RenderSnapshot *pSnapshot);
+        // The snapshot made it to the screen, for the age and duplicate metrics
+        void NotePresented(const RenderSnapshot *pSnapshot, bool fNew);
+
+        RenderSnapshotStats Stats();
+
+    private:
+        static const int c_indexMask = 3;
+        static const int c_fresh = 4;   // Set with the middle index when it holds a snapshot the renderer hasn't taken
+
+        RenderSnapshot _snapshots[3];
+        SDL_atomic_t _middle;           // Index of the middle buffer | c_fresh
+        int _iBack;                     // Simulation's
+        int _iFront;                    // Renderer's
+        bool _fHaveFront;               // _iFront holds a snapshot (false until the first one arrives)
+        Uint32 _cMaxSprites;
+        Uint32 _cMaxTiles;
+
+        // Simulation side
+        SnapshotTile *_pPendingTiles;
+        Uint32 _cPendingTiles;
+        Uint32 _nextTileSequence;
+        SDL_atomic_t _acknowledgedTileSequence;
+        SDL_atomic_t _cPublished;
+        SDL_atomic_t _cDropped;
+
+        // Render side
+        Uint32 _appliedTileSequence;
+        Uint32 _cPresented;
+        Uint32 _cDuplicated;
+        Uint64 _ageCountersTotal;
+        Uint64 _ageCountersMax;
+    };
+}
+}
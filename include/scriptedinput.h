@@ -0,0 +1,28 @@
+#pragma once
+#include "SDL.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Stand-in for the input queue when there is no one at the keyboard (headless runs).  Produces the same kind of
+    // per tick buttons (see inputrecording.h), pressing a pseudo-random direction and holding it for a pseudo-random
+    // number of ticks.  The sequence only depends on the seed, so two runs with the same seed see exactly the same input
+    class ScriptedInput
+    {
+    public:
+        ScriptedInput(Uint32 seed);
+
+        // Advance one tick and return the buttons for it
+        Uint8 NextButtons();
+
+    private:
+        // xorshift32, plenty for picking keys and hold times
+        Uint32 NextRandom();
+
+        Uint32 _state;                      // PRNG state
+        Uint32 _cTicksRemaining;            // Ticks left to hold the current direction
+        Uint8 _currentButton;               // Direction button being held
+    };
+}
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include "utils.h"
-#include "spriteanimation.h"
+#include "animationlibrary.h"
+#include "renderbatch.h"
+#include "entitystore.h"
 #include <map>
 
 namespace XplatGameTutorial
@@ -11,15 +13,23 @@ namespace PacManClone
     // be animated, and they have a position and velocity.  Pac-Man and the Ghosts are very obvious examples of sprites, but
     // they can be used for other purposes, such as the "text" output and the bonus fruit in the future.
     // It would also be possible to make the larger pellets (or even the smaller ones) into animated sprites.
+    //
+    // The state itself lives in an EntityStore, a Sprite is just a handle to one entity there with the old per-object
+    // API on top.  Lots of actors should be driven through the store's bulk passes instead
     class Sprite
     {
     public:
+        // pEntityStore - store that will hold the sprite's state (not owned)
         // pTextureWrapper - pointer to loaded texture that holds our sprite frames
         // cxFrame - width of a frame in pixels
         // cyFrame - height of a frame in pixels
         // cFramesTotal - total frames to load
         // cAnimationsTotal - total number of animation sequences needed
-        Sprite(TextureWrapper *pTextureWrapper, Uint16 cxFrame, Uint16 cyFrame, Uint16 cFramesTotal, Uint16 cAnimationsTotal);
+        // Each of these makes a new sheet and the store has a fixed number of them for good, so only the
+        // first actor with a given set of frames should use it, the rest share its sheet through the one below
+        Sprite(EntityStore *pEntityStore, TextureWrapper *pTextureWrapper, Uint16 cxFrame, Uint16 cyFrame, Uint16 cFramesTotal, Uint16 cAnimationsTotal);
+        // Another sprite drawn from an existing sheet, it shares the frames and animations already loaded there
+        Sprite(EntityStore *pEntityStore, Uint16 sheet);
         ~Sprite();
 
         // All frames are the same size once created above (cxFrame * cyFrame)
@@ -30,55 +40,55 @@ namespace PacManClone
         // Load a series of frame assumed to be in horizontal order starting at the given index/coord
         bool LoadFrames(Uint16 indexStart, Uint16 xTextureStart, Uint16 yTextureStart, Uint16 cFramesToLoad);
 
-        //  Saves a series of frames to cycle through in order at a given speed (frame delay per update)
+        //  Saves a series of frames to cycle through in order at a given speed (ticks per frame).  The clip is shared
+        //  through the store's AnimationLibrary, the sprite only remembers which one it plays and since when
         // index - animation index to assign the sequence to
         // animationType - Currently either loop or once
         // pSequence - pointer to list of frames
         // cFramesInSequence - total frames in the sequence passed in
         // animationSpeed - the delay between frame updates
-        void LoadAnimationSequence(Uint16 index, AnimationType animationType, int* pSequence, Uint16 cFramesInSequence, Uint16 animationSpeed);
+        void LoadAnimationSequence(Uint16 index, AnimationType animationType, const int* pSequence, Uint16 cFramesInSequence, Uint16 animationSpeed);
         // Start the current animation over
         void ResetAnimation();
         // Set a new (already loaded) animation sequence as the current
         void SetAnimation(Uint16 index);
         // Set a new velocity
-        void SetVelocity(double dx, double dy);
-        // Set a new position (normally handled via Update but on death, etc)
-        void ResetPosition(double x, double y); 
+        void SetVelocity(Fixed dx, Fixed dy);
+        // Set a new position (normally handled via Update but on death, etc).  This is a jump, so it isn't interpolated
+        void ResetPosition(Fixed x, Fixed y);
         // This is only needed for sprites that have no animation, the frame will not update
         void SetFrame(Uint16 frameIndex);
         // Offset from the pixel (X,Y) location of the sprite for the frame (defaults to 0)
         void SetFrameOffset(int xOffset, int yOffset);
         // If the sprite isn't visible, it won't render
         void SetVisible(SDL_bool visible);
-        // Applies current state to the object (velocity, animation, etc)
+        // Layer used when the whole store is drawn with EntityStore::RenderAll
+        void SetLayer(Uint16 layer);
+        // Stop at the walls of the store's collision map as it moves (see EntityStore::SetCollisionMap)
+        void SetWallCollision(SDL_bool fWallCollision);
+        // Applies the velocity.  Animation needs no update, it follows the store's clock (see EntityStore::UpdateAll)
         void Update();
-        // Draw it to the renderer
-        void Render(SDL_Renderer *pSDLRenderer);
-        // Some quick accessors
-        double X() { return _x; }
-        double Y() { return _y; }
-        double DX() { return _dx; }
-        double DY() { return _dy; }
-        Uint16 CurrentAnimation() { return _currentAnimationIndex; }
+        // Queue it on the frame's batch at the given layer.  alpha [0, 1] blends the position between the state before
+        // and after the last Update, so movement stays smooth when we draw faster than we simulate
+        void Render(RenderBatch *pRenderBatch, Uint16 layer, double alpha);
+        // Some quick accessors, positions and velocities are 16.16 fixed point world pixels
+        Fixed X() { return _pEntityStore->X()[Index()]; }
+        Fixed Y() { return _pEntityStore->Y()[Index()]; }
+        Fixed DX() { return _pEntityStore->DX()[Index()]; }
+        Fixed DY() { return _pEntityStore->DY()[Index()]; }
+        // The whole pixel the sprite is on
+        SDL_Point Pixel() { return { FixedToInt(X()), FixedToInt(Y()) }; }
+        // True if the given animation is the one playing
+        bool IsPlaying(Uint16 animationIndex) { return _pEntityStore->PlayingAnimations()[Index()] == animationIndex; }
+        Uint16 Sheet() { return _sheet; }
+        EntityHandle Handle() { return _handle; }
 
     private:
-        double _x;                              // Position
-        double _y;
-        double _dx;                             // Velocity
-        double _dy;
-        Uint16 _cFramesTotal;                   // Total number of frames to allocate
-        SDL_Rect *_pFrames;                     // Frame rects in the texture
-        Uint16 _cxFrame;                        // Width of a frame
-        Uint16 _cyFrame;                        // Height of a frame
-        int _cxFrameOffset;                     // Offset of left side of frame from position (can be negative)
-        int _cyFrameOffset;                     // Offset of Top side of frame from position
-        Uint16 _currentAnimationIndex;          // Index to the current animation sequence
-        Uint16 _cAnimationsTotal;               // Total number of animation sequences
-        Uint16 _staticFrameIndex;               // Index in non-animated sprite to frame to draw
-        SDL_bool _fVisible;                     // Visibility flag
-        TextureWrapper *_pTextureWrapper;       // Not owned by the sprite class
-        SpriteAnimation** _ppSpriteAnimations;  // Is owned and holds the list of animation sequences
+        Uint32 Index() { return _pEntityStore->IndexOf(_handle); }
+
+        EntityStore *_pEntityStore;             // Not owned by the sprite class
+        Uint16 _sheet;                          // Sheet in the store holding our frames and animations
+        EntityHandle _handle;                   // Our entity in the store
     };
 }
-}
\ No newline at end of file
+}
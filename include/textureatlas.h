@@ -0,0 +1,66 @@
+#pragma once
+#include "SDL.h"
+#include "utils.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Packs several images into as few textures (pages) as possible so everything drawn from them can share a
+    // batch run.  Images are added by file name, color keyed pixels become transparent, then Build either reads
+    // the layout from the cache file or packs them (and writes the cache).  Callers then draw from Page(image)
+    // using Rect(image) as the image's place on it
+    class TextureAtlas
+    {
+    public:
+        // Pages are never bigger than this (or the renderer's limit, whichever is smaller)
+        TextureAtlas(int cxMaxPage, int cyMaxPage);
+        ~TextureAtlas();
+
+        // Load an image to be packed, returns its id or -1 on failure
+        int AddImage(const char *szFileName, SDL_Color *pSdlTransparencyColorKey);
+        // Same, for an image already decoded by LoadSurface (e.g. on the AssetLoader).  The atlas takes ownership
+        // of pSurface, szFileName is what the layout cache knows it by
+        int AddSurface(const char *szFileName, SDL_Surface *pSurface);
+
+        // Pack (or load the cached layout), upload the pages and free the decoded images.  szCacheFileName can be
+        // nullptr to always pack
+        bool Build(SDL_Renderer *pSDLRenderer, const char *szCacheFileName);
+
+        // Valid after a successful Build
+        TextureWrapper* Page(int image) { return _ppPages[_pImages[image].page]; }
+        SDL_Rect Rect(int image) { return _pImages[image].rect; }
+        int ImageCount() { return _cImages; }
+        int PageCount() { return _cPages; }
+        bool FromCache() { return _fFromCache; }
+
+    private:
+        static const int c_maxImages = 16;
+        static const int c_padding = 1;     // Empty pixels between images so filtering never picks up a neighbour
+
+        struct AtlasImage
+        {
+            char *pszFileName;
+            SDL_Surface *pSurface;          // From LoadSurface, freed by Build
+            int page;
+            SDL_Rect rect;                  // Where the image ended up on its page
+        };
+
+        // Shelf packer, tallest images first
+        bool Pack();
+        bool LoadLayout(const char *szCacheFileName);
+        bool SaveLayout(const char *szCacheFileName);
+        bool CreatePages(SDL_Renderer *pSDLRenderer);
+
+        int _cxMaxPage;
+        int _cyMaxPage;
+        AtlasImage *_pImages;
+        int _cImages;
+        int *_pcxPages;                     // Size of each page
+        int *_pcyPages;
+        TextureWrapper **_ppPages;
+        int _cPages;
+        bool _fFromCache;
+    };
+}
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "SDL.h"
+#include "utils.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    struct TextureCacheStats
+    {
+        Uint32 cHits;               // Acquires served from the cache
+        Uint32 cMisses;             // Acquires that had to load the file
+        Uint32 cEvictions;          // Unreferenced textures dropped to stay under budget
+        Uint32 cEntries;            // Textures resident now
+        Uint32 cReferenced;         // ...of which someone holds a reference
+        Uint64 cbResident;          // Estimated texture memory of the resident textures
+    };
+
+    // Shares textures between everything that loads the same file with the same color key.  Acquire hands out a
+    // reference counted TextureWrapper, Release gives it back.  Textures nobody references stay loaded so the next
+    // Acquire is free, until the cache goes over its memory budget, then the least recently used unreferenced ones
+    // are destroyed.  Referenced textures are never evicted, so the budget can be exceeded while they're in use
+    class TextureCache
+    {
+    public:
+        TextureCache(SDL_Renderer *pSDLRenderer, Uint64 cbBudget, Uint32 cMaxEntries);
+        ~TextureCache();
+
+        // Returns the texture with a reference added, or nullptr if it couldn't be loaded (or the cache is full
+        // of referenced textures)
+        TextureWrapper* Acquire(const char *szFileName, SDL_Color *pSdlTransparencyColorKey);
+        // For a texture loaded elsewhere (e.g. by the AssetLoader): the cache takes ownership and returns it with a
+        // reference added.  If the key is already cached, pTextureWrapper is destroyed and the cached one returned
+        TextureWrapper* Adopt(const char *szFileName, SDL_Color *pSdlTransparencyColorKey, TextureWrapper *pTextureWrapper);
+        // Drop a reference from Acquire/Adopt
+        void Release(TextureWrapper *pTextureWrapper);
+
+        // Evicts right away if the new budget is lower than what's resident
+        void SetBudget(Uint64 cbBudget);
+        // Destroy every unreferenced texture
+        void Purge();
+
+        const TextureCacheStats& Stats() { return _stats; }
+        void PrintStats();
+
+    private:
+        struct CacheEntry
+        {
+            char *pszFileName;              // nullptr when the entry is free
+            SDL_bool fColorKey;
+            SDL_Color colorKey;             // Only rgb matters, alpha is ignored by LoadTexture
+            TextureWrapper *pTextureWrapper;
+            Uint32 cRefs;
+            Uint64 lastUsed;                // _useCounter at the last Acquire/Release, for LRU
+            Uint64 cbTexture;
+        };
+
+        TextureWrapper* AddReference(Uint32 index);
+        TextureWrapper* Insert(const char *szFileName, SDL_Color *pSdlTransparencyColorKey, TextureWrapper *pTextureWrapper);
+        Uint32 FindEntry(const char *szFileName, SDL_Color *pSdlTransparencyColorKey);
+        Uint32 FindEntry(TextureWrapper *pTextureWrapper);
+        // Evict unreferenced entries, oldest first, until cbTarget fits (or nothing else can go)
+        void EvictDownTo(Uint64 cbTarget);
+        // Destroy the least recently used unreferenced texture, false if there isn't one
+        bool EvictOldest();
+        void FreeEntry(Uint32 index);
+
+        SDL_Renderer *_pSDLRenderer;    // Not owned
+        Uint64 _cbBudget;
+        Uint32 _cMaxEntries;
+        CacheEntry *_pEntries;
+        Uint64 _useCounter;
+        TextureCacheStats _stats;
+    };
+}
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "SDL.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // A unit of work for the pool, called once for each index of a ParallelFor
+    typedef void (*ThreadPoolTask)(void *pContext, Uint32 index);
+
+    // Counters since the pool was created
+    struct ThreadPoolStats
+    {
+        Uint32 cTasks;              // Tasks run
+        Uint32 cSteals;             // Tasks a thread took from someone else's queue
+    };
+
+    // Worker threads with a queue each.  A ParallelFor deals its tasks out round robin across the workers' queues
+    // (and one for the calling thread), every thread works through its own queue newest first and, once that's empty,
+    // steals the oldest task from another queue, so uneven tasks still end up spread over every core.  The caller
+    // works too and returns when every task is done.  Idle workers sleep.
+    //
+    // One thread calls ParallelFor at a time, and tasks must not call it themselves
+    class ThreadPool
+    {
+    public:
+        // cWorkers can be 0, everything then runs on the calling thread.  cMaxQueuedTasks is per queue, tasks that
+        // don't fit are run by the caller as they're dealt
+        ThreadPool(Uint32 cWorkers, Uint32 cMaxQueuedTasks);
+        ~ThreadPool();
+
+        // Run pfnTask(pContext, i) for every i in [0, cTasks), in any order and on any thread
+        void ParallelFor(Uint32 cTasks, ThreadPoolTask pfnTask, void *pContext);
+
+        Uint32 WorkerCount() { return _cWorkers; }
+        ThreadPoolStats Stats();
+
+    private:
+        struct Task
+        {
+            ThreadPoolTask pfnTask;
+            void *pContext;
+            Uint32 index;
+        };
+
+        // Ring of tasks, the owner takes from the tail and thieves from the head
+        struct TaskQueue
+        {
+            SDL_SpinLock lock;
+            Task *pTasks;
+            Uint32 iHead;
+            Uint32 cTasks;
+        };
+
+        struct WorkerStart
+        {
+            ThreadPool *pThreadPool;
+            Uint32 iQueue;
+        };
+
+        static int WorkerThread(void *pData);
+        void WorkerLoop(Uint32 iQueue);
+        // Take a task from queue iQueue, or failing that from any other queue
+        bool NextTask(Uint32 iQueue, Task &task);
+        void RunTask(const Task &task);
+
+        Uint32 _cWorkers;
+        SDL_Thread **_ppWorkers;
+        WorkerStart *_pWorkerStarts;
+        Uint32 _cQueues;                // One per worker, plus the caller's (the last one)
+        Uint32 _cMaxQueuedTasks;
+        TaskQueue *_pQueues;
+        SDL_atomic_t _cQueued;          // Tasks sitting in any queue, workers sleep while it's 0
+        SDL_atomic_t _cRemaining;       // Tasks of the current ParallelFor not finished yet
+        SDL_atomic_t _cTasksRun;
+        SDL_atomic_t _cSteals;
+        bool _fQuit;
+        SDL_mutex *_pMutex;             // Guards _fQuit and sleeping on _pWorkQueued
+        SDL_cond *_pWorkQueued;
+        SDL_sem *_pDone;                // Posted once when the last task of a ParallelFor finishes
+    };
+}
+}
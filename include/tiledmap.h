@@ -1,69 +1,192 @@
 #pragma once
 #include "SDL_image.h"
+#include "renderbatch.h"
+#include "fixedpoint.h"
+#include "memoryarena.h"
 
 namespace XplatGameTutorial
 {
 namespace PacManClone
 {
+    // Supplies map data a chunk at a time so the whole map never has to be resident.  Copy the cRows x cCols block
+    // of indicies starting at [row][col] into pIndicies (pitch is in elements), return false if it can't be read
+    typedef bool (*TiledMapChunkSource)(void *pContext, Uint16 row, Uint16 col, Uint16 cRows, Uint16 cCols, Uint16 *pIndicies, Uint16 pitch);
+
     // Takes a texture divided evenly into tiles as well as a map size and a list of indices to the tiles
-    // to fill out the map.  When rendered, the map will center itself in the total window and iterate over
-    // the map, drawing the indexed tile
+    // to fill out the map.  The map is split into square chunks of c_chunkSize tiles which are loaded when the
+    // camera first sees them and dropped again (least recently seen first) when too many are resident, so only
+    // what's on screen costs anything to draw.  All of it comes out of the level's arena, chunks from a pool there,
+    // so loading and dropping chunks during play never touches the heap.
+    //
+    // Positions are in world pixels.  A map smaller than the screen is centered in it and the camera never moves,
+    // so world and screen are the same, otherwise the camera scrolls over the map (see CenterCamera)
     class TiledMap
     {
     public:
-        TiledMap(const Uint16 rows, const Uint16 cols, Uint16 cxScreen, Uint16 cyScreen) :
+        static const Uint16 c_chunkSize = 32;           // Tiles per chunk side, keeps the visible chunks well under RenderBatch's texture slots
+        static const Uint16 c_maxResidentChunks = 24;   // Loaded chunks kept before the least recently seen are dropped
+        static const Uint16 c_maxLoadedChunks = 64;     // Chunk data in the pool, room for edited chunks (never dropped) on top
+
+        // pLevelArena holds everything the map allocates, it has to outlive the map
+        TiledMap(const Uint16 rows, const Uint16 cols, Uint16 cxScreen, Uint16 cyScreen, MemoryArena *pLevelArena) :
+            _pLevelArena(pLevelArena),
             _cxScreen(cxScreen),
             _cyScreen(cyScreen),
             _cxWidth(0),
             _cyHeight(0),
             _cxOffset(0),
             _cyOffset(0),
+            _camera({ 0, 0 }),
             _pTileRects(nullptr),
-            _pMapIndicies(nullptr),
             _cCols(cols),
             _cRows(rows),
             _tileSize(0),
+            _tileShift(0),
             _pTileTexture(nullptr),
-            _cTilesOnTexture(0)
+            _cTilesOnTexture(0),
+            _pfnSource(nullptr),
+            _pSourceContext(nullptr),
+            _pMapIndicies(nullptr),
+            _cChunkCols((cols + c_chunkSize - 1) / c_chunkSize),
+            _cChunkRows((rows + c_chunkSize - 1) / c_chunkSize),
+            _pChunks(nullptr),
+            _chunkCells(pLevelArena, SDL_min(_cChunkRows * _cChunkCols, static_cast<int>(c_maxLoadedChunks))),
+            _pResidentChunks(nullptr),
+            _cResidentChunks(0),
+            _frame(0),
+            _cCachesCreated(0),
+            _fTargetsSupported(SDL_TRUE)
         {
             SDL_memset(&_textureRect, 0, sizeof(SDL_Rect));
+            _pChunks = _pLevelArena->AllocateArray<Chunk>(_cChunkRows * _cChunkCols);
         }
 
         ~TiledMap()
         {
-            // Free our allocated memory
-            delete[] _pMapIndicies;
-            delete[] _pTileRects;
+            // The cache textures are ours, the memory goes with the arena
+            for (Uint32 i = 0; i < _cResidentChunks; i++)
+            {
+                UnloadChunk(_pChunks[_pResidentChunks[i]]);
+            }
         }
 
-        // Initialize our map with the texture and map data
-        bool Initialize(SDL_Rect textureRect, SDL_Rect tileRect, SDL_Texture *pTexture, Uint16 *pMapIndices, Uint16 countOfIndicies);
-        
-        // Draw to the renderer at the current offset, etc
-        void Render(SDL_Renderer *pSDLRenderer);
-        
-        // Given an [row][col] location, return the (X,Y) coordinates on the screen
+        // Initialize our map with the texture and map data.  textureRect is the area of pTexture holding the tiles.
+        // pMapIndices is read a chunk at a time as the map is drawn, so it must stay valid for the life of the map
+        bool Initialize(SDL_Rect textureRect, SDL_Rect tileRect, SDL_Texture *pTexture, const Uint16 *pMapIndices, Uint32 countOfIndicies);
+        // Same, but the map data comes from pfnSource (e.g. a grid in an AssetPack, or generated) as it's needed
+        bool Initialize(SDL_Rect textureRect, SDL_Rect tileRect, SDL_Texture *pTexture, TiledMapChunkSource pfnSource, void *pContext);
+
+        // Queue the chunks the camera can see.  Each chunk is baked into its own cached target texture the first
+        // time it is seen and only changed cells are redrawn into it after that, so normally this adds one quad per
+        // visible chunk.  Quads are in world pixels, the caller points the batch at the camera (see Camera)
+        void Render(SDL_Renderer *pSDLRenderer, RenderBatch *pRenderBatch, Uint16 layer);
+
+        // Change the tile drawn at [row][col], only this cell is re-baked into its chunk on the next Render.  The
+        // chunk is loaded if needed and kept from then on so the edit isn't lost
+        bool SetTile(Uint16 row, Uint16 col, Uint16 index);
+        // Call when the renderer reports SDL_RENDER_TARGETS_RESET (contents lost) or SDL_RENDER_DEVICE_RESET
+        // (texture lost) so the chunk caches are rebuilt on the next Render
+        void ResetCache(SDL_bool fTextureLost);
+
+        // Move the camera so its top left corner is at (x,y) in world pixels, clamped so it stays over the map
+        void SetCamera(int x, int y);
+        // Move the camera so the given world point is in the middle of the screen (as far as the map allows)
+        void CenterCamera(SDL_Point point);
+        // World position of the screen's top left corner
+        SDL_Point Camera() { return _camera; }
+        SDL_Point WorldToScreen(SDL_Point point) { return { point.x - _camera.x, point.y - _camera.y }; }
+        SDL_Point ScreenToWorld(SDL_Point point) { return { point.x + _camera.x, point.y + _camera.y }; }
+
+        // Given an [row][col] location, return the (X,Y) coordinates of its center in the world
         SDL_Point GetTileCoordinates(Uint16 row, Uint16 col);
-        // Given a (X,Y) location, return the [row][col] if it exists
+        // Same, but where it currently is on the screen
+        SDL_Point GetTileScreenCoordinates(Uint16 row, Uint16 col) { return WorldToScreen(GetTileCoordinates(row, col)); }
+        // Given a (X,Y) location in the world, return the [row][col] if it exists
         bool GetTileRowCol(SDL_Point &point, Uint16 &row, Uint16 &col);
-        // Return the outer bounds of the map
+        // Same for a 16.16 fixed point world position (a Sprite's), it's a subtract and a shift per axis
+        bool GetTileRowCol(Fixed x, Fixed y, Uint16 &row, Uint16 &col);
+        // Same, but for a point on the screen (e.g. the mouse)
+        bool GetScreenTileRowCol(SDL_Point point, Uint16 &row, Uint16 &col);
+        // Return the outer bounds of the map in the world
         SDL_Rect GetMapBounds();
+        // Size in pixels of a (square) tile
+        Uint16 TileSize() { return _tileSize; }
+        // log2 of the above, tiles are a power of 2 in size
+        Uint16 TileShift() { return _tileShift; }
+        // Chunks with their data loaded right now
+        Uint32 ResidentChunks() { return _cResidentChunks; }
+        // Chunk cache textures created so far, each one allocates in SDL and the driver
+        Uint32 CachesCreated() { return _cCachesCreated; }
 
     private:
-        Uint16 _cxScreen;           // Total screen (window) width in pixels
-        Uint16 _cyScreen;           // Total screen height
-        Uint16 _cxWidth;            // Total width of map
-        Uint16 _cyHeight;           // Total height of map
-        Uint16 _cxOffset;           // Offset from upper left corner of window (screen)
-        Uint16 _cyOffset;           // ...
+        // A loaded chunk's data, from the pool
+        struct ChunkCells
+        {
+            Uint16 indicies[c_chunkSize * c_chunkSize];     // Tile indicies (pitch c_chunkSize)
+            Uint16 dirtyCells[c_chunkSize * c_chunkSize];   // Cells (chunk relative) changed by SetTile since the last bake
+        };
+
+        struct Chunk
+        {
+            ChunkCells *pCells;         // nullptr when not loaded
+            Uint16 cDirtyCells;         // Count of pCells->dirtyCells
+            SDL_bool fCacheDirty;       // Whole cache needs to be (re)baked
+            SDL_bool fModified;         // Edited since it was loaded, the source doesn't have the changes so keep it
+            SDL_Texture *pCacheTexture; // Render target holding the chunk, drawn with a single copy
+            Uint32 lastSeenFrame;       // Last Render the chunk was visible in, picks what to unload
+        };
+
+        MemoryArena *_pLevelArena;  // Everything below is allocated from here
+        int _cxScreen;              // Total screen (window) width in pixels
+        int _cyScreen;              // Total screen height
+        int _cxWidth;               // Total width of map
+        int _cyHeight;              // Total height of map
+        int _cxOffset;              // World position of the map's upper left corner (non-zero when it's centered)
+        int _cyOffset;              // ...
+        SDL_Point _camera;          // World position of the screen's upper left corner
         SDL_Rect* _pTileRects;      // Will hold the list of tile source rects from the texture loaded
-        Uint16 *_pMapIndicies;      // Will hold the indices to the map
         Uint16 _cCols;              // Cols in the map
         Uint16 _cRows;              // Rows in the map
         Uint16 _tileSize;           // Cached size of the tile (w == h in our implementation e.g. square tiles only)
-        SDL_Rect _textureRect;      // Size of the texture
+        Uint16 _tileShift;          // log2 of _tileSize, so world positions go to tiles with a shift
+        SDL_Rect _textureRect;      // Area of the texture holding the tiles
         SDL_Texture *_pTileTexture; // Texture that holds the tiles (must be evenly divisible by tile size)
         Uint16 _cTilesOnTexture;    // Total number of tiles on the texture
+        TiledMapChunkSource _pfnSource; // Where chunk data is loaded from
+        void *_pSourceContext;      // Passed back to the above
+        const Uint16 *_pMapIndicies;// Caller's indicies when initialized from an array (read by ArraySource)
+        Uint16 _cChunkCols;         // Chunks across the map, the last column/row may be partial
+        Uint16 _cChunkRows;         // ...
+        Chunk *_pChunks;            // [_cChunkRows][_cChunkCols], only the resident ones hold any data
+        ObjectPool<ChunkCells> _chunkCells; // Data of the loaded chunks
+        Uint32 *_pResidentChunks;   // Indicies into _pChunks of the loaded chunks
+        Uint32 _cResidentChunks;    // Count of the above
+        Uint32 _frame;              // Render count, for lastSeenFrame
+        Uint32 _cCachesCreated;     // See CachesCreated
+        SDL_bool _fTargetsSupported;// False once the renderer turns down a target texture, tiles are queued directly then
+
+        // Shared setup for both Initialize()s
+        bool InitializeTiles(SDL_Rect textureRect, SDL_Rect tileRect, SDL_Texture *pTexture);
+        // Reads chunks out of _pMapIndicies
+        static bool ArraySource(void *pContext, Uint16 row, Uint16 col, Uint16 cRows, Uint16 cCols, Uint16 *pIndicies, Uint16 pitch);
+
+        // Size in tiles of a chunk, only the last column/row of chunks can be smaller than c_chunkSize
+        Uint16 ChunkCols(Uint16 chunkCol) { return SDL_min(c_chunkSize, _cCols - (chunkCol * c_chunkSize)); }
+        Uint16 ChunkRows(Uint16 chunkRow) { return SDL_min(c_chunkSize, _cRows - (chunkRow * c_chunkSize)); }
+        // Make sure the chunk's data is loaded (see TrimChunks for unloading)
+        bool LoadChunk(Uint16 chunkRow, Uint16 chunkCol);
+        void UnloadChunk(Chunk &chunk);
+        // Drop unmodified chunks not seen this frame until we're back under c_maxResidentChunks
+        void TrimChunks();
+
+        // Create the chunk's cache texture if the renderer supports render targets
+        bool CreateCache(SDL_Renderer *pSDLRenderer, Chunk &chunk, Uint16 chunkRow, Uint16 chunkCol);
+        // Draw a single cell into the chunk's cache (must be the current render target)
+        void RenderTile(SDL_Renderer *pSDLRenderer, const Chunk &chunk, Uint16 row, Uint16 col);
+        // Redraw either the whole chunk or just its dirty cells into its cache
+        void BakeCache(SDL_Renderer *pSDLRenderer, Chunk &chunk, Uint16 chunkRow, Uint16 chunkCol);
+        // Queue the chunk's visible tiles straight to the batch, for when there's no cache
+        void RenderTiles(RenderBatch *pRenderBatch, const Chunk &chunk, Uint16 chunkRow, Uint16 chunkCol, const SDL_Rect &viewRect, Uint16 layer);
     };
 }
-}
\ No newline at end of file
+}
@@ -8,24 +8,34 @@ namespace PacManClone
 {
     // Load a texture from disk with optional transparency
     SDL_Texture* LoadTexture(const char *szFileName, SDL_Renderer *pSDLRenderer, SDL_Color *pSdlTransparencyColorKey);
+    // Decode an image into an ARGB8888 surface, pixels matching the color key (if any) are made fully transparent.
+    // This needs no renderer so it's safe to call off the main thread
+    SDL_Surface* LoadSurface(const char *szFileName, SDL_Color *pSdlTransparencyColorKey);
     
-    // Sets up our SDL environment and Window
-    bool InitializeSDL(SDL_Window **ppSDLWindow, SDL_Renderer **ppSDLRenderer);
+    // Sets up our SDL environment and Window.  When headless, SDL's dummy video driver is used with a hidden window
+    // and a software renderer, so textures can still be loaded on machines without a display.  Without fVsync
+    // presents don't wait for the display (replays run as fast as they can draw)
+    bool InitializeSDL(SDL_Window **ppSDLWindow, SDL_Renderer **ppSDLRenderer, bool fHeadless, bool fVsync);
 
     // Small wrapper for the SDL_Texture object.  It will cache some basic info (like size)
     // and free it upon destruction
     class TextureWrapper
     {
     public:
+        // Longest name kept (for logging), longer ones are cut short
+        static const size_t c_cchMaxName = 64;
+
         TextureWrapper() :
             _pTexture(nullptr),
             _cxTexture(0),
-            _cyTexture(0),
-            _pszFilename(nullptr)
+            _cyTexture(0)
         {
+            _szName[0] = '\0';
         }
 
         TextureWrapper(const char *szFileName, size_t cchFileName, SDL_Renderer *pSDLRenderer, SDL_Color *pSdlTransparencyColorKey);
+        // Take ownership of a texture created elsewhere (e.g. an atlas page), szName is only used for logging
+        TextureWrapper(SDL_Texture *pTexture, const char *szName);
         
         ~TextureWrapper();
 
@@ -39,7 +49,7 @@ namespace PacManClone
         SDL_Texture *_pTexture;
         int _cxTexture;
         int _cyTexture;
-        char *_pszFilename;
+        char _szName[c_cchMaxName];     // Kept inline, so a wrapper is never more than the one allocation
     };
 }
 }
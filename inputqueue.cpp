@@ -0,0 +1,126 @@
+#include "include/inputqueue.h"
+#include "include/inputrecording.h"
+#include <stdio.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+InputQueue::InputQueue(Uint32 cMaxEvents) :
+    _pEvents(nullptr),
+    _cMaxEvents(cMaxEvents),
+    _heldButtons(0),
+    _cTurns(0),
+    _msLatencyTotal(0),
+    _msLatencyMax(0)
+{
+    // Slots are picked by masking the ever increasing head and tail
+    SDL_assert((cMaxEvents > 0) && ((cMaxEvents & (cMaxEvents - 1)) == 0));
+    _pEvents = new InputEvent[_cMaxEvents];
+    SDL_memset(_msPressed, 0, sizeof(_msPressed));
+    SDL_AtomicSet(&_head, 0);
+    SDL_AtomicSet(&_tail, 0);
+    SDL_AtomicSet(&_cDropped, 0);
+}
+
+InputQueue::~InputQueue()
+{
+    delete[] _pEvents;
+}
+
+bool InputQueue::PushKeyEvent(const SDL_KeyboardEvent &keyEvent)
+{
+    int button = InputButtonFromScancode(keyEvent.keysym.scancode);
+    if ((button < 0) || (keyEvent.repeat != 0))
+    {
+        return true;
+    }
+
+    Uint32 head = static_cast<Uint32>(SDL_AtomicGet(&_head));
+    Uint32 tail = static_cast<Uint32>(SDL_AtomicGet(&_tail));
+    if (head - tail == _cMaxEvents)
+    {
+        // The simulation hasn't taken anything in a long time, a lost key up leaves the button held until it's
+        // pressed again
+        SDL_AtomicAdd(&_cDropped, 1);
+        return false;
+    }
+
+    InputEvent &event = _pEvents[head & (_cMaxEvents - 1)];
+    event.msTimestamp = keyEvent.timestamp;
+    event.button = static_cast<Uint8>(button);
+    event.fDown = (keyEvent.type == SDL_KEYDOWN) ? 1 : 0;
+
+    // The event has to be written before the simulation can see the slot
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&_head, static_cast<int>(head + 1));
+    return true;
+}
+
+Uint8 InputQueue::NextTickButtons()
+{
+    Uint32 tail = static_cast<Uint32>(SDL_AtomicGet(&_tail));
+    Uint32 head = static_cast<Uint32>(SDL_AtomicGet(&_head));
+    SDL_MemoryBarrierAcquire();
+
+    Uint8 pressedButtons = 0;
+    int freshDirection = -1;
+    for (; tail != head; tail++)
+    {
+        const InputEvent &event = _pEvents[tail & (_cMaxEvents - 1)];
+        Uint8 bit = static_cast<Uint8>(1 << event.button);
+        if (event.fDown)
+        {
+            if ((_heldButtons & bit) == 0)
+            {
+                pressedButtons |= bit;
+                // 0 means no press waiting, SDL's clock starts at 0 so nudge one that early
+                _msPressed[event.button] = SDL_max(event.msTimestamp, 1u);
+                if ((bit & InputDirectionButtons) != 0)
+                {
+                    freshDirection = event.button;
+                }
+            }
+            _heldButtons |= bit;
+        }
+        else
+        {
+            _heldButtons &= ~bit;
+        }
+    }
+
+    // Done reading the slots, the event thread can have them back
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&_tail, static_cast<int>(tail));
+
+    Uint8 buttons = _heldButtons | pressedButtons;
+    if (freshDirection >= 0)
+    {
+        // The other directions are still held (or were tapped earlier), only this one is new as far as the tick goes
+        buttons = (buttons & ~InputDirectionButtons) | static_cast<Uint8>((1 << freshDirection) | (1 << InputButtonFreshDirection));
+    }
+    return buttons;
+}
+
+void InputQueue::NoteTurnTaken(Uint8 button)
+{
+    SDL_assert(button < c_cButtons);
+    // Only the first turn after a press is its latency, a held key taking more turns later isn't waiting on anything
+    if (_msPressed[button] == 0)
+    {
+        return;
+    }
+    Uint32 msLatency = SDL_GetTicks() - _msPressed[button];
+    _msPressed[button] = 0;
+    _cTurns++;
+    _msLatencyTotal += msLatency;
+    _msLatencyMax = SDL_max(_msLatencyMax, msLatency);
+}
+
+InputLatencyStats InputQueue::LatencyStats()
+{
+    InputLatencyStats stats = {};
+    stats.cTurns = _cTurns;
+    stats.msMean = (_cTurns > 0) ? static_cast<double>(_msLatencyTotal) / _cTurns : 0.0;
+    stats.msMax = _msLatencyMax;
+    stats.cDropped = static_cast<Uint32>(SDL_AtomicGet(&_cDropped));
+    return stats;
+}
@@ -0,0 +1,287 @@
+#include "include/inputrecording.h"
+#include <stdio.h>
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    static const Uint32 c_inputRecordingMagic = 0x52434D50;    // "PMCR"
+    static const Uint32 c_inputRecordingVersion = 5;    // Bumped whenever the same input plays out differently (5: fresh direction bit)
+    static const Uint32 c_cbHeader = 16;
+
+    // The key on each button bit, in bit order.  WASD ends up on the arrow bits, they do the same thing
+    static const SDL_Scancode c_recordedKeys[] = { SDL_SCANCODE_UP, SDL_SCANCODE_DOWN, SDL_SCANCODE_LEFT, SDL_SCANCODE_RIGHT, SDL_SCANCODE_X, SDL_SCANCODE_ESCAPE };
+    static const SDL_Scancode c_alternateKeys[] = { SDL_SCANCODE_W, SDL_SCANCODE_S, SDL_SCANCODE_A, SDL_SCANCODE_D, SDL_SCANCODE_UNKNOWN, SDL_SCANCODE_UNKNOWN };
+    static const Uint32 c_cRecordedKeys = sizeof(c_recordedKeys) / sizeof(c_recordedKeys[0]);
+
+    int InputButtonFromScancode(SDL_Scancode scancode)
+    {
+        for (Uint32 i = 0; i < c_cRecordedKeys; i++)
+        {
+            if ((scancode == c_recordedKeys[i]) || ((c_alternateKeys[i] != SDL_SCANCODE_UNKNOWN) && (scancode == c_alternateKeys[i])))
+            {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    static void WriteLE32(Uint8 *pDest, Uint32 value)
+    {
+        pDest[0] = static_cast<Uint8>(value);
+        pDest[1] = static_cast<Uint8>(value >> 8);
+        pDest[2] = static_cast<Uint8>(value >> 16);
+        pDest[3] = static_cast<Uint8>(value >> 24);
+    }
+
+    static Uint32 ReadLE32(const Uint8 *pSource)
+    {
+        return pSource[0] | (pSource[1] << 8) | (pSource[2] << 16) | (static_cast<Uint32>(pSource[3]) << 24);
+    }
+
+    // FNV-1a
+    static Uint32 HashBytes(Uint32 hash, const void *pData, size_t cbData)
+    {
+        const Uint8 *pBytes = static_cast<const Uint8*>(pData);
+        for (size_t i = 0; i < cbData; i++)
+        {
+            hash = (hash ^ pBytes[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    Uint32 SimulationChecksum(EntityStore *pEntityStore)
+    {
+        // Positions are hashed bit for bit, any drift at all shows up
+        Uint32 cEntities = pEntityStore->Count();
+        Uint32 hash = HashBytes(2166136261u, &cEntities, sizeof(cEntities));
+        hash = HashBytes(hash, pEntityStore->X(), cEntities * sizeof(Fixed));
+        hash = HashBytes(hash, pEntityStore->Y(), cEntities * sizeof(Fixed));
+        hash = HashBytes(hash, pEntityStore->Clips(), cEntities * sizeof(Uint16));
+        hash = HashBytes(hash, pEntityStore->AnimationStarts(), cEntities * sizeof(Uint32));
+        Uint32 clock = pEntityStore->Clock();
+        hash = HashBytes(hash, &clock, sizeof(clock));
+        return hash;
+    }
+
+    InputRecorder::InputRecorder() :
+        _pRuns(nullptr),
+        _cbRuns(0),
+        _cbMaxRuns(0),
+        _pChecksums(nullptr),
+        _cTicks(0),
+        _cMaxTicks(0),
+        _currentButtons(0),
+        _cCurrentRun(0)
+    {
+    }
+
+    InputRecorder::~InputRecorder()
+    {
+        delete[] _pRuns;
+        delete[] _pChecksums;
+    }
+
+    void InputRecorder::Record(Uint8 buttons, Uint32 checksum)
+    {
+        if ((_cCurrentRun > 0) && (buttons != _currentButtons))
+        {
+            AppendRun();
+        }
+        _currentButtons = buttons;
+        _cCurrentRun++;
+
+        if (_cTicks == _cMaxTicks)
+        {
+            _cMaxTicks = SDL_max(_cMaxTicks * 2, 4096u);
+            Uint32 *pChecksums = new Uint32[_cMaxTicks];
+            if (_cTicks > 0)
+            {
+                SDL_memcpy(pChecksums, _pChecksums, _cTicks * sizeof(Uint32));
+            }
+            delete[] _pChecksums;
+            _pChecksums = pChecksums;
+        }
+        _pChecksums[_cTicks++] = checksum;
+    }
+
+    // Close off the current run, the buttons then the tick count 7 bits at a time
+    void InputRecorder::AppendRun()
+    {
+        if (_cbRuns + 6 > _cbMaxRuns)
+        {
+            _cbMaxRuns = SDL_max(_cbMaxRuns * 2, 1024u);
+            Uint8 *pRuns = new Uint8[_cbMaxRuns];
+            if (_cbRuns > 0)
+            {
+                SDL_memcpy(pRuns, _pRuns, _cbRuns);
+            }
+            delete[] _pRuns;
+            _pRuns = pRuns;
+        }
+
+        _pRuns[_cbRuns++] = _currentButtons;
+        Uint32 cRun = _cCurrentRun;
+        while (cRun >= 0x80)
+        {
+            _pRuns[_cbRuns++] = static_cast<Uint8>(cRun | 0x80);
+            cRun >>= 7;
+        }
+        _pRuns[_cbRuns++] = static_cast<Uint8>(cRun);
+        _cCurrentRun = 0;
+    }
+
+    bool InputRecorder::Save(const char *szFileName)
+    {
+        if (_cCurrentRun > 0)
+        {
+            AppendRun();
+        }
+
+        SDL_RWops *pFile = SDL_RWFromFile(szFileName, "wb");
+        if (pFile == nullptr)
+        {
+            printf("InputRecorder::Save() : unable to open %s\n", szFileName);
+            return false;
+        }
+
+        Uint8 header[c_cbHeader];
+        WriteLE32(&header[0], c_inputRecordingMagic);
+        WriteLE32(&header[4], c_inputRecordingVersion);
+        WriteLE32(&header[8], _cTicks);
+        WriteLE32(&header[12], _cbRuns);
+        Uint8 *pChecksums = new Uint8[_cTicks * sizeof(Uint32)];
+        for (Uint32 i = 0; i < _cTicks; i++)
+        {
+            WriteLE32(&pChecksums[i * sizeof(Uint32)], _pChecksums[i]);
+        }
+
+        bool fResult = (SDL_RWwrite(pFile, header, sizeof(header), 1) == 1) &&
+            ((_cbRuns == 0) || (SDL_RWwrite(pFile, _pRuns, _cbRuns, 1) == 1)) &&
+            ((_cTicks == 0) || (SDL_RWwrite(pFile, pChecksums, _cTicks * sizeof(Uint32), 1) == 1));
+        delete[] pChecksums;
+        if (SDL_RWclose(pFile) != 0)
+        {
+            fResult = false;
+        }
+        if (!fResult)
+        {
+            printf("InputRecorder::Save() : failed writing %s\n", szFileName);
+        }
+        return fResult;
+    }
+
+    InputReplay::InputReplay() :
+        _pFile(nullptr),
+        _pRuns(nullptr),
+        _pRunsEnd(nullptr),
+        _pNextRun(nullptr),
+        _pChecksums(nullptr),
+        _cTicks(0),
+        _iTick(0),
+        _cRunRemaining(0),
+        _cMismatches(0),
+        _firstMismatchTick(0),
+        _buttons(0)
+    {
+    }
+
+    InputReplay::~InputReplay()
+    {
+        delete[] _pFile;
+    }
+
+    bool InputReplay::Load(const char *szFileName)
+    {
+        SDL_RWops *pFile = SDL_RWFromFile(szFileName, "rb");
+        if (pFile == nullptr)
+        {
+            printf("InputReplay::Load() : unable to open %s\n", szFileName);
+            return false;
+        }
+        Sint64 cbFile = SDL_RWsize(pFile);
+        delete[] _pFile;
+        _pFile = (cbFile >= c_cbHeader) ? new Uint8[static_cast<size_t>(cbFile)] : nullptr;
+        bool fRead = (_pFile != nullptr) && (SDL_RWread(pFile, _pFile, static_cast<size_t>(cbFile), 1) == 1);
+        SDL_RWclose(pFile);
+
+        // Every tick needs a checksum and the runs have to fit in what's left
+        Uint64 cTicks = fRead ? ReadLE32(&_pFile[8]) : 0;
+        Uint64 cbRuns = fRead ? ReadLE32(&_pFile[12]) : 0;
+        if (!fRead || (ReadLE32(&_pFile[0]) != c_inputRecordingMagic) || (ReadLE32(&_pFile[4]) != c_inputRecordingVersion) ||
+            (static_cast<Uint64>(cbFile) != c_cbHeader + cbRuns + (cTicks * sizeof(Uint32))))
+        {
+            printf("InputReplay::Load() : %s is not a valid input recording (version %u)\n", szFileName, c_inputRecordingVersion);
+            delete[] _pFile;
+            _pFile = nullptr;
+            _cTicks = 0;
+            return false;
+        }
+
+        _pRuns = &_pFile[c_cbHeader];
+        _pRunsEnd = _pRuns + cbRuns;
+        _pNextRun = _pRuns;
+        _pChecksums = _pRunsEnd;
+        _cTicks = static_cast<Uint32>(cTicks);
+        _iTick = 0;
+        _cRunRemaining = 0;
+        _cMismatches = 0;
+        _firstMismatchTick = 0;
+        _buttons = 0;
+        return true;
+    }
+
+    bool InputReplay::NextButtons(Uint8 *pButtons)
+    {
+        if (_iTick >= _cTicks)
+        {
+            return false;
+        }
+
+        // Start the next run, a truncated run list just plays out as no keys held
+        while ((_cRunRemaining == 0) && (_pNextRun < _pRunsEnd))
+        {
+            Uint8 buttons = *_pNextRun++;
+            Uint32 cRun = 0;
+            for (int shift = 0; (_pNextRun < _pRunsEnd) && (shift < 32); shift += 7)
+            {
+                Uint8 byte = *_pNextRun++;
+                cRun |= static_cast<Uint32>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    break;
+                }
+            }
+            _buttons = buttons;
+            _cRunRemaining = cRun;
+        }
+        if (_cRunRemaining == 0)
+        {
+            _buttons = 0;
+        }
+        else
+        {
+            _cRunRemaining--;
+        }
+
+        _iTick++;
+        *pButtons = _buttons;
+        return true;
+    }
+
+    bool InputReplay::VerifyTick(Uint32 checksum)
+    {
+        SDL_assert((_iTick > 0) && (_iTick <= _cTicks));
+        if (checksum == ReadLE32(&_pChecksums[(_iTick - 1) * sizeof(Uint32)]))
+        {
+            return true;
+        }
+
+        if (_cMismatches++ == 0)
+        {
+            _firstMismatchTick = _iTick;
+        }
+        return false;
+    }
+}
+}
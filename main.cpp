@@ -6,9 +6,41 @@
 #include "include/constants.h"
 #include "include/utils.h"
 #include "include/sprite.h"
+#include "include/entitystore.h"
+#include "include/gamelogic.h"
+#include "include/navigationtable.h"
+#include "include/flowfield.h"
+#include "include/threadpool.h"
+#include "include/renderbatch.h"
+#include "include/scriptedinput.h"
+#include "include/inputrecording.h"
+#include "include/inputqueue.h"
+#include "include/rendersnapshot.h"
+#include "include/framescheduler.h"
+#include "include/profiler.h"
+#include "include/textureatlas.h"
+#include "include/texturecache.h"
+#include "include/assetloader.h"
+#include "include/assetpack.h"
+#include "include/memoryarena.h"
+#include "include/pelletboard.h"
+#include "include/actorbroadphase.h"
 
 using namespace XplatGameTutorial::PacManClone;
 
+// The map grids and animation tables the level is built from, straight out of the asset pack when it has them (see
+// LoadLevelTables), otherwise the ones compiled into Constants
+struct LevelTables
+{
+    const Uint16 *pMapIndicies;
+    const Uint16 *pCollisionMap;
+    const Sint32 *pPlayerAnimationUp;
+    const Sint32 *pPlayerAnimationDown;
+    const Sint32 *pPlayerAnimationLeft;
+    const Sint32 *pPlayerAnimationRight;
+    const Sint32 *pPlayerAnimationDeath;
+};
+
 // Cleanup objects create in Initialize and shutdown SDL and related subsystems
 void Cleanup(SDL_Window **ppSDLWindow, SDL_Renderer **ppSDLRenderer)
 {
@@ -22,290 +54,866 @@ void Cleanup(SDL_Window **ppSDLWindow, SDL_Renderer **ppSDLRenderer)
     SDL_Quit();
 }
 
-// Simple enum to denote the 4 possible directions
-// The sprites can move
-enum class Direction
+// Handle any keyboard input.  The basic logic here is
+// 1)  If a directional key is pressed, buffer a turn that way
+// 2)  While a turn is buffered check the cell adjacent based on its direction
+// 3)  If the new direction is open, place the sprite along the centerline and
+//     set its new velocity
+// 4)  If ESC is hit, signal quit
+//
+// buttons are the tick's input (see inputrecording.h), from the input queue, a replay or scripted
+// pTurn holds the turn until it can be taken, pInputQueue (if the buttons came from it) is told when one is
+// pInputSprite is the temporary graphical helper which will go away - it shows the direction buffered
+bool ProcessInput(Uint8 buttons, Sprite *pSprite, Sprite* pInputSprite, TiledMap *pTiledMap, const CollisionGrid *pCollisionGrid,
+    BufferedTurn *pTurn, InputQueue *pInputQueue)
 {
-    Up = 0,
-    Down,
-    Left,
-    Right
-};
+    bool fResult = false;
+    Uint8 directions = buttons & InputDirectionButtons;
 
-// Given a player's current state (location, direction, animation) check if the player can move in a given direction, and if
-// so position the player on the new track at the new velocity
-void DoPlayerInputCheck(Sprite *pSprite, TiledMap *pTiledMap, Direction direction, Uint16 row, Uint16 col, Uint16 animationIndex, double dx, double dy)
-{
-    // Helper lambda to check the map in a given direction.  I put it here instead of another helper
-    // because it's only useful here now.  Plus I wanted to check the c++11 feature on both compilers :)
-    auto CanMove = [](Direction direction, Uint16 row, Uint16 col) -> SDL_bool
+    // LOGIC
+    // A direction pressed this tick (the one pressed last, if several were) replaces any turn still waiting.  Keys
+    // that are only being held ask again once nothing is waiting, the latest pressed if it's still down, otherwise
+    // Up, Down, Left, Right in that order
+    if ((buttons & (1 << InputButtonFreshDirection)) != 0)
     {
-        SDL_bool fResult = SDL_FALSE;
-        // Adjust the [row][col] to look at based on direction
-        if (direction == Direction::Up)
-        {
-            row--;
-        }
-        else if (direction == Direction::Down)
+        for (Uint8 button = 0; button < 4; button++)
         {
-            row++;
+            if ((directions & (1 << button)) != 0)
+            {
+                pTurn->lastPressed = static_cast<Direction>(button);
+            }
         }
-        else if (direction == Direction::Left)
+        pTurn->direction = pTurn->lastPressed;
+        pTurn->fPending = SDL_TRUE;
+    }
+    else if ((directions != 0) && (pTurn->fPending == SDL_FALSE))
+    {
+        Uint8 button = static_cast<Uint8>(pTurn->lastPressed);
+        if ((directions & (1 << button)) == 0)
         {
-            col--;
+            button = 0;
+            while ((directions & (1 << button)) == 0)
+            {
+                button++;
+            }
         }
-        else if (direction == Direction::Right)
+        pTurn->direction = static_cast<Direction>(button);
+        pTurn->fPending = SDL_TRUE;
+    }
+    else if (directions == 0)
+    {
+        if ((buttons & (1 << InputButtonDeath)) != 0)
         {
-            col++;
+            pSprite->SetAnimation(Constants::AnimationIndexDeath);
         }
-
-        // Check the map, 0s are legal free space
-        if (Constants::CollisionMap[row * Constants::MapCols + col] == 0)
+        else if ((buttons & (1 << InputButtonQuit)) != 0)
         {
-            fResult = SDL_TRUE;
+            printf("ESC hit - exiting main loop...");
+            fResult = true;
         }
-        return fResult;
-    };
+    }
 
-    // If we can move and we're not already moving in the direction
-    if ((CanMove(direction, row, col) == SDL_TRUE) &&
-        (pSprite->CurrentAnimation() != animationIndex))
+    // The helper handles collision, etc and only takes the turn once the player is on a tile it can be taken from
+    if ((directions != 0) || (pTurn->fPending == SDL_TRUE))
     {
-        // Set a new animation and position the player with a new velocity
-        pSprite->SetAnimation(animationIndex);
-        SDL_Point tilePoint = pTiledMap->GetTileCoordinates(row, col);
-        pSprite->ResetPosition(tilePoint.x, tilePoint.y);
-        pSprite->SetVelocity(dx, dy);
+        pInputSprite->SetFrame(static_cast<Uint16>(pTurn->direction));
+        pInputSprite->SetVisible(SDL_TRUE);
     }
+    else
+    {
+        pInputSprite->SetVisible(SDL_FALSE);
+    }
+    if (DoBufferedTurn(pSprite, pTiledMap, pCollisionGrid, pTurn) && (pInputQueue != nullptr))
+    {
+        pInputQueue->NoteTurnTaken(static_cast<Uint8>(pTurn->direction));
+    }
+    return fResult;
 }
 
-// Even if no input is pressed, the player may run into a wall, so we need to handle collisions
-// after the player is moved
-void DoPlayerBoundsCheck(Sprite *pSprite, TiledMap *pTiledMap)
+// Helper to break out the sprite init code from main()
+// spriteRect is where the sprite sheet is on pSpriteTexture (its place in the atlas), the sprites come from pSprites
+void InitializeSprites(ObjectPool<Sprite> *pSprites, EntityStore* pEntityStore, TiledMap* pTiledMap, const LevelTables &levelTables, TextureWrapper* pSpriteTexture, const SDL_Rect &spriteRect, Sprite **ppPlayerSprite, Sprite **ppInputSprite)
 {
-    SDL_Point playerPoint = { static_cast<int>(pSprite->X()), static_cast<int>(pSprite->Y()) };
+    *ppPlayerSprite = nullptr;
+    *ppInputSprite = nullptr;
+
+    // Declare and initialize sprite object(s)
+    Sprite* pSprite = pSprites->Create(pEntityStore, pSpriteTexture, Constants::PlayerSpriteWidth, Constants::PlayerSpriteHeight,
+        Constants::PlayerTotalFrameCount, Constants::PlayerTotalAnimationCount);
+    pEntityStore->RemapSheet(pSprite->Sheet(), pSpriteTexture, spriteRect);
+
+    pSprite->LoadFrames(0, 0, 0, 10);
+    pSprite->LoadFrames(10, 0, Constants::PlayerSpriteHeight, 10);
+    pSprite->LoadAnimationSequence(Constants::AnimationIndexLeft, AnimationType::Loop, levelTables.pPlayerAnimationLeft, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
+    pSprite->LoadAnimationSequence(Constants::AnimationIndexRight, AnimationType::Loop, levelTables.pPlayerAnimationRight, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
+    pSprite->LoadAnimationSequence(Constants::AnimationIndexUp, AnimationType::Loop, levelTables.pPlayerAnimationUp, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
+    pSprite->LoadAnimationSequence(Constants::AnimationIndexDown, AnimationType::Loop, levelTables.pPlayerAnimationDown, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
+    pSprite->LoadAnimationSequence(Constants::AnimationIndexDeath, AnimationType::Once, levelTables.pPlayerAnimationDeath, Constants::PlayerAnimationDeathFrameCount, Constants::PlayerAnimationSpeed);
+    pSprite->SetVelocity(Constants::PlayerSpeed, 0);
+    pSprite->SetAnimation(Constants::AnimationIndexRight);
+    pSprite->SetFrameOffset(1 - (Constants::PlayerSpriteWidth / 2), 1 - (Constants::PlayerSpriteHeight / 2));
+    pSprite->SetLayer(Constants::RenderLayerSprites);
+    pSprite->SetWallCollision(SDL_TRUE);
+
+    SDL_Point playerStartCoord = pTiledMap->GetTileCoordinates(Constants::PlayerStartRow, Constants::PlayerStartCol);
+    pSprite->ResetPosition(FixedFromInt(playerStartCoord.x), FixedFromInt(playerStartCoord.y));
+
+    // Visual for detected input
+    Sprite *pInputSprite = pSprites->Create(pEntityStore, pSpriteTexture, Constants::PlayerSpriteWidth, Constants::PlayerSpriteHeight, 4, 4);
+    pEntityStore->RemapSheet(pInputSprite->Sheet(), pSpriteTexture, spriteRect);
+    pInputSprite->LoadFrames(0, 0, 64, 4);
+    pInputSprite->SetVisible(SDL_FALSE);
+    pInputSprite->SetLayer(Constants::RenderLayerSprites);
+
+    *ppPlayerSprite = pSprite;
+    *ppInputSprite = pInputSprite;
+}
 
-    // Need to check bounds in direction moving (account for width of half the sprite)
-    // This is because the sprite is double the size of the tiles and placed along the centerline
-    // in the direction of movement.  So 1/2 of its size in a given direction is the "edge" of the
-    // sprite on the screen (minus a pixel or 2 of transparency)
-    if (pSprite->DX() != 0) // If we're not moving in this axis, then don't bother
+// Upload a surface on this (the renderer's) thread, the surface is freed
+TextureWrapper* UploadSurface(SDL_Renderer *pSDLRenderer, SDL_Surface *pSurface, const char *szName)
+{
+    TextureWrapper *pTextureWrapper = nullptr;
+    if (pSurface != nullptr)
     {
-        if (pSprite->DX() < 0)
+        SDL_Texture *pTexture = SDL_CreateTextureFromSurface(pSDLRenderer, pSurface);
+        SDL_FreeSurface(pSurface);
+        if (pTexture == nullptr)
         {
-            playerPoint.x -= (Constants::PlayerSpriteWidth / 2) - Constants::TileWidth / 2;
+            printf("SDL_CreateTextureFromSurface() failed, error = %s\n", SDL_GetError());
         }
         else
         {
-            playerPoint.x += (Constants::PlayerSpriteWidth / 2) - Constants::TileWidth / 2;
+            pTextureWrapper = new TextureWrapper(pTexture, szName);
         }
     }
-    else  // We cann't be moving in both directions at once
+    return pTextureWrapper;
+}
+
+// Load the tile and sprite textures.  Normally they are packed onto an atlas, with --no-atlas each file is its own
+// texture, shared through the cache.  The rects are where each image ended up on its texture.  The pixels come
+// straight from the asset pack if it's open (pAssetLoader can be nullptr then), otherwise the files are decoded in
+// parallel on the loader's workers.  Either way only the uploads happen here
+bool LoadTextures(bool fAtlas, SDL_Renderer *pSDLRenderer, AssetPack *pAssetPack, AssetLoader *pAssetLoader, TextureAtlas *pTextureAtlas,
+    TextureCache *pTextureCache, TextureWrapper **ppTilesTexture, SDL_Rect *pTilesRect, TextureWrapper **ppSpriteTexture, SDL_Rect *pSpriteRect)
+{
+    static const char * const szTilesFileName = "./grfx/tiles.png";
+    static const char * const szSpriteFileName = "./grfx/spritesheet.png";
+    SDL_Color colorKey = Constants::SDLColorMagenta;
+    SDL_Surface *pTilesSurface = nullptr;
+    SDL_Surface *pSpriteSurface = nullptr;
+    TextureWrapper *pTilesLoaded = nullptr;
+    TextureWrapper *pSpriteLoaded = nullptr;
+    *ppTilesTexture = nullptr;
+    *ppSpriteTexture = nullptr;
+
+    if (pAssetPack->IsOpen())
     {
-        if (pSprite->DY() < 0)  // Same logic for y axis if moving
+        // Already decoded and color keyed, the surfaces point into the mapped file
+        pTilesSurface = pAssetPack->CreateSurface(szTilesFileName);
+        pSpriteSurface = pAssetPack->CreateSurface(szSpriteFileName);
+        if (!fAtlas)
         {
-            playerPoint.y -= (Constants::PlayerSpriteHeight / 2) - Constants::TileHeight / 2;
+            pTilesLoaded = UploadSurface(pSDLRenderer, pTilesSurface, szTilesFileName);
+            pSpriteLoaded = UploadSurface(pSDLRenderer, pSpriteSurface, szSpriteFileName);
+        }
+    }
+    else
+    {
+        // The atlas wants the pixels, otherwise the loader uploads them
+        AssetHandle tilesHandle = pAssetLoader->Load(szTilesFileName, nullptr, !fAtlas);
+        AssetHandle spriteHandle = pAssetLoader->Load(szSpriteFileName, &colorKey, !fAtlas);
+        pAssetLoader->Wait(tilesHandle, pSDLRenderer);
+        pAssetLoader->Wait(spriteHandle, pSDLRenderer);
+        if (fAtlas)
+        {
+            pTilesSurface = pAssetLoader->TakeSurface(tilesHandle);
+            pSpriteSurface = pAssetLoader->TakeSurface(spriteHandle);
         }
         else
         {
-            playerPoint.y += (Constants::PlayerSpriteHeight / 2) - Constants::TileHeight / 2;
+            pTilesLoaded = pAssetLoader->TakeTexture(tilesHandle);
+            pSpriteLoaded = pAssetLoader->TakeTexture(spriteHandle);
+        }
+    }
+
+    if (fAtlas)
+    {
+        int tilesImage = (pTilesSurface != nullptr) ? pTextureAtlas->AddSurface(szTilesFileName, pTilesSurface) : -1;
+        int spriteImage = (pSpriteSurface != nullptr) ? pTextureAtlas->AddSurface(szSpriteFileName, pSpriteSurface) : -1;
+        if ((tilesImage >= 0) && (spriteImage >= 0) && pTextureAtlas->Build(pSDLRenderer, Constants::AtlasCacheFileName))
+        {
+            *ppTilesTexture = pTextureAtlas->Page(tilesImage);
+            *pTilesRect = pTextureAtlas->Rect(tilesImage);
+            *ppSpriteTexture = pTextureAtlas->Page(spriteImage);
+            *pSpriteRect = pTextureAtlas->Rect(spriteImage);
+        }
+    }
+    else
+    {
+        if (pTilesLoaded != nullptr)
+        {
+            *ppTilesTexture = pTextureCache->Adopt(szTilesFileName, nullptr, pTilesLoaded);
+        }
+        if (pSpriteLoaded != nullptr)
+        {
+            *ppSpriteTexture = pTextureCache->Adopt(szSpriteFileName, &colorKey, pSpriteLoaded);
+        }
+        if (*ppTilesTexture != nullptr)
+        {
+            *pTilesRect = { 0, 0, (*ppTilesTexture)->Width(), (*ppTilesTexture)->Height() };
+        }
+        if (*ppSpriteTexture != nullptr)
+        {
+            *pSpriteRect = { 0, 0, (*ppSpriteTexture)->Width(), (*ppSpriteTexture)->Height() };
         }
     }
+    return (*ppTilesTexture != nullptr) && (*ppSpriteTexture != nullptr);
+}
 
-    // Now get the row, col we're in
-    Uint16 row = 0;
-    Uint16 col = 0;
-    pTiledMap->GetTileRowCol(playerPoint, row, col);
+// With the pack open its grids and tables are the level's, used in place (they're mapped, nothing is copied) so the
+// pack has to stay open as long as the level does.  Otherwise they're the ones compiled into Constants, which is
+// also what the packer writes.  Returns false if the pack's tables are missing or laid out for another
+// Constants::TablesVersion, it's no use to this build then (and pLevelTables has the compiled in ones)
+bool LoadLevelTables(AssetPack *pAssetPack, LevelTables *pLevelTables)
+{
+    *pLevelTables = { Constants::MapIndicies, Constants::CollisionMap, Constants::PlayerAnimation_UP, Constants::PlayerAnimation_DOWN,
+        Constants::PlayerAnimation_LEFT, Constants::PlayerAnimation_RIGHT, Constants::PlayerAnimation_DEATH };
+    if (!pAssetPack->IsOpen())
+    {
+        return true;
+    }
+    if (pAssetPack->TablesVersion() != Constants::TablesVersion)
+    {
+        printf("Asset pack tables are version %u, this build reads version %u (run make pack)\n", pAssetPack->TablesVersion(), Constants::TablesVersion);
+        return false;
+    }
 
-    // If we wandered into a bad cell, stop
-    if (Constants::CollisionMap[row * Constants::MapCols + col] == 1)
+    LevelTables packTables =
+    {
+        pAssetPack->Grid("MapIndicies", Constants::MapRows, Constants::MapCols),
+        pAssetPack->Grid("CollisionMap", Constants::MapRows, Constants::MapCols),
+        pAssetPack->Table("PlayerAnimation_UP", Constants::PlayerAnimationFrameCount),
+        pAssetPack->Table("PlayerAnimation_DOWN", Constants::PlayerAnimationFrameCount),
+        pAssetPack->Table("PlayerAnimation_LEFT", Constants::PlayerAnimationFrameCount),
+        pAssetPack->Table("PlayerAnimation_RIGHT", Constants::PlayerAnimationFrameCount),
+        pAssetPack->Table("PlayerAnimation_DEATH", Constants::PlayerAnimationDeathFrameCount)
+    };
+    if ((packTables.pMapIndicies == nullptr) || (packTables.pCollisionMap == nullptr) || (packTables.pPlayerAnimationUp == nullptr) ||
+        (packTables.pPlayerAnimationDown == nullptr) || (packTables.pPlayerAnimationLeft == nullptr) ||
+        (packTables.pPlayerAnimationRight == nullptr) || (packTables.pPlayerAnimationDeath == nullptr))
     {
-        pSprite->SetVelocity(0, 0);
+        return false;
     }
+    *pLevelTables = packTables;
+    return true;
 }
 
-// Handle any keyboard input.  The basic logic here is
-// 1)  If a directional key is pressed
-// 2)  Check the cell adjacent based on direction
-// 3)  If the new direction is open, place the sprite along the centerline and
-//     set its new velocity
-// 4)  If ESC is hit, signal quit
-//
-// pInputSprite is the temporary graphical helper which will go away - it shows directions pressed
-bool ProcessInput(Sprite *pSprite, Sprite* pInputSprite, TiledMap *pTiledMap)
+// Point the player's flow field (slot 0) at the tile the player is on now, it's only rebuilt when that's a new tile
+void UpdatePlayerFlowField(Sprite *pSprite, TiledMap *pTiledMap, FlowFieldService *pFlowFields)
 {
-    bool fResult = false;
+    Uint16 playerRow = 0;
+    Uint16 playerCol = 0;
+    pTiledMap->GetTileRowCol(pSprite->X(), pSprite->Y(), playerRow, playerCol);
+    pFlowFields->SetTarget(0, playerRow, playerCol);
+    pFlowFields->Update();
+}
 
-    // All it takes to get the key states.  The array is valid within SDL while running
-    const Uint8 *pCurrentKeyState = SDL_GetKeyboardState(nullptr);
+// Pellet tiles the simulation changed go to the renderer with the next snapshot, pContext is the RenderSnapshotBuffer
+void QueueSnapshotTileChange(void *pContext, Uint16 row, Uint16 col, Uint16 tileIndex)
+{
+    static_cast<RenderSnapshotBuffer*>(pContext)->QueueTileChange(row, col, tileIndex);
+}
 
-    // Get the player's info before any input is taken
-    SDL_Point playerPreInputPoint = { static_cast<int>(pSprite->X()), static_cast<int>(pSprite->Y()) };
-    Uint16 playerPreInputRow = 0;
-    Uint16 playerPreInputCol = 0;
-    pTiledMap->GetTileRowCol(playerPreInputPoint, playerPreInputRow, playerPreInputCol);
+// After every tick: log it when recording, check it against the recording when replaying
+void CheckpointTick(EntityStore *pEntityStore, Uint8 buttons, InputRecorder *pRecorder, InputReplay *pReplay)
+{
+    if ((pRecorder == nullptr) && (pReplay == nullptr))
+    {
+        return;
+    }
 
-    // LOGIC
-    // Check if a direction key is down (or WASD) and then process it with our helper
-    // which will handle collision, etc
-    if (pCurrentKeyState[SDL_SCANCODE_UP] || pCurrentKeyState[SDL_SCANCODE_W])
+    Uint32 checksum = SimulationChecksum(pEntityStore);
+    if (pRecorder != nullptr)
     {
-        pInputSprite->SetFrame(0);
-        pInputSprite->SetVisible(SDL_TRUE);
-        DoPlayerInputCheck(pSprite, pTiledMap, Direction::Up, playerPreInputRow, playerPreInputCol, Constants::AnimationIndexUp, 0, -1.5);
+        pRecorder->Record(buttons, checksum);
     }
-    else if (pCurrentKeyState[SDL_SCANCODE_DOWN] || pCurrentKeyState[SDL_SCANCODE_S])
+    if ((pReplay != nullptr) && !pReplay->VerifyTick(checksum) && (pReplay->MismatchCount() == 1))
     {
-        pInputSprite->SetFrame(1);
-        pInputSprite->SetVisible(SDL_TRUE);
-        DoPlayerInputCheck(pSprite, pTiledMap, Direction::Down, playerPreInputRow, playerPreInputCol, Constants::AnimationIndexDown, 0, 1.5);
+        printf("Replay diverged from the recording at tick %u\n", pReplay->CurrentTick());
     }
-    else if (pCurrentKeyState[SDL_SCANCODE_LEFT] || pCurrentKeyState[SDL_SCANCODE_A])
+}
+
+void ReportReplay(InputReplay *pReplay, double elapsedSeconds)
+{
+    printf("Replayed %u of %u ticks in %.3f s", pReplay->CurrentTick(), pReplay->TickCount(), elapsedSeconds);
+    if (pReplay->MismatchCount() == 0)
     {
-        pInputSprite->SetFrame(2);
-        pInputSprite->SetVisible(SDL_TRUE);
-        DoPlayerInputCheck(pSprite, pTiledMap, Direction::Left, playerPreInputRow, playerPreInputCol, Constants::AnimationIndexLeft, -1.5, 0);
+        printf(", every checksum matched\n");
     }
-    else if (pCurrentKeyState[SDL_SCANCODE_RIGHT] || pCurrentKeyState[SDL_SCANCODE_D])
+    else
     {
-        pInputSprite->SetFrame(3);
-        pInputSprite->SetVisible(SDL_TRUE);
-        DoPlayerInputCheck(pSprite, pTiledMap, Direction::Right, playerPreInputRow, playerPreInputCol, Constants::AnimationIndexRight, 1.5, 0);
+        printf(", %u checksum mismatch(es), first at tick %u\n", pReplay->MismatchCount(), pReplay->FirstMismatchTick());
     }
-    else if (pCurrentKeyState[SDL_SCANCODE_X])
+}
+
+// Runs input -> update -> contacts and pick ups as fast as possible with no rendering or frame cap, then reports the
+// throughput.  This is what we use to see how many simulation ticks the engine can actually sustain.  Input is
+// scripted, or played back from pReplay (every recorded tick, checking each one) when there is one
+void RunHeadless(EntityStore *pEntityStore, Sprite *pSprite, Sprite *pInputSprite, TiledMap *pTiledMap, const CollisionGrid *pCollisionGrid,
+    PelletBoard *pPellets, ActorBroadphase *pBroadphase, ThreadPool *pThreadPool, FlowFieldService *pFlowFields, InputRecorder *pRecorder, InputReplay *pReplay, Uint32 cTicks)
+{
+    ScriptedInput scriptedInput(Constants::HeadlessInputSeed);
+    BufferedTurn turn = { Direction::Right, SDL_FALSE, Direction::Right };
+    if (pReplay != nullptr)
     {
-        pSprite->SetAnimation(Constants::AnimationIndexDeath);
+        cTicks = pReplay->TickCount();
+    }
+
+    printf("Running %u headless ticks...\n", cTicks);
+    Uint64 startCounter = SDL_GetPerformanceCounter();
+    Uint32 cTicksRun = 0;
+    while (cTicksRun < cTicks)
+    {
+        Uint8 buttons = 0;
+        if (pReplay != nullptr)
+        {
+            pReplay->NextButtons(&buttons);
+        }
+        else
+        {
+            buttons = scriptedInput.NextButtons();
+        }
+        cTicksRun++;
+        // Only a recording can hit ESC, the run ends there like the one that was recorded
+        bool fQuit = false;
+        {
+            ASSERT_NO_ALLOCATIONS("Headless tick");
+            fQuit = ProcessInput(buttons, pSprite, pInputSprite, pTiledMap, pCollisionGrid, &turn, nullptr);
+            if (!fQuit)
+            {
+                pEntityStore->UpdateAll(pThreadPool);
+                pBroadphase->Build(pEntityStore, pTiledMap);
+                pBroadphase->FindContacts();
+                // Nothing is drawn, so only the board changes
+                DoPlayerPelletCheck(pSprite, pTiledMap, pPellets, nullptr, nullptr);
+                UpdatePlayerFlowField(pSprite, pTiledMap, pFlowFields);
+            }
+        }
+        // A recording grows as it goes, so this is left out of the check
+        CheckpointTick(pEntityStore, buttons, pRecorder, pReplay);
+        if (fQuit)
+        {
+            break;
+        }
     }
-    else if (pCurrentKeyState[SDL_SCANCODE_ESCAPE])
+    Uint64 elapsedCounter = SDL_GetPerformanceCounter() - startCounter;
+
+    double elapsedSeconds = static_cast<double>(elapsedCounter) / static_cast<double>(SDL_GetPerformanceFrequency());
+    if (elapsedSeconds > 0.0)
     {
-        printf("ESC hit - exiting main loop...");
-        fResult = true;
+        printf("%u ticks in %.3f s: %.0f ticks/sec, %.1f ns/tick\n", cTicksRun, elapsedSeconds,
+            cTicksRun / elapsedSeconds, (elapsedSeconds * 1e9) / cTicksRun);
     }
-    else
+    if (pReplay != nullptr)
     {
-        pInputSprite->SetVisible(SDL_FALSE);
+        ReportReplay(pReplay, elapsedSeconds);
     }
-    return fResult;
+    // Final state, makes it easy to see two runs did the same work
+    printf("Final player position (%.1f, %.1f), %u of %u pellets left\n", FixedToDouble(pSprite->X()), FixedToDouble(pSprite->Y()),
+        pPellets->Remaining(), pPellets->Total());
 }
 
-// Helper to break out the sprite init code from main()
-void InitializeSprites(TiledMap* pTiledMap, TextureWrapper* pSpriteTexture, Sprite **ppPlayerSprite, Sprite **ppInputSprite)
+// What the simulation thread works on.  Once it's started everything here belongs to it, except the atomics, and
+// the render thread only sees the simulation through the snapshots it publishes
+struct SimulationThreadContext
 {
-    *ppPlayerSprite = nullptr;
-    *ppInputSprite = nullptr;
+    EntityStore *pEntityStore;
+    Sprite *pSprite;
+    Sprite *pInputSprite;
+    TiledMap *pTiledMap;                // Geometry only, the tiles and camera are the render thread's
+    const CollisionGrid *pCollisionGrid;
+    PelletBoard *pPellets;
+    ActorBroadphase *pBroadphase;
+    ThreadPool *pThreadPool;
+    FlowFieldService *pFlowFields;
+    InputRecorder *pRecorder;
+    InputReplay *pReplay;
+    RenderSnapshotBuffer *pSnapshots;
+    InputQueue *pInputQueue;            // Live key events, pushed by the render thread
+    BufferedTurn turn;
+    SDL_atomic_t fQuit;                 // Set by the render thread to stop the simulation
+    SDL_atomic_t fDone;                 // Set by the simulation when it stops on its own (ESC, end of the replay)
+};
 
-    // Declare and initialize sprite object(s)
-    Sprite* pSprite = new Sprite(pSpriteTexture, Constants::PlayerSpriteWidth, Constants::PlayerSpriteHeight,
-        Constants::PlayerTotalFrameCount, Constants::PlayerTotalAnimationCount);
+// Runs the fixed rate simulation and publishes a snapshot after every batch of steps, never waiting on the
+// renderer.  A replay isn't paced by the clock, it runs one step per snapshot as fast as it can
+int SimulationThread(void *pData)
+{
+    SimulationThreadContext *pContext = static_cast<SimulationThreadContext*>(pData);
+    InputReplay *pReplay = pContext->pReplay;
+    FrameScheduler frameScheduler(Constants::SimulationStepsPerSecond, Constants::MaxCatchUpSteps);
+    Uint64 profileCounters[static_cast<Uint32>(ProfilePhase::Count)] = {};
+    Uint64 cTicks = 0;
+    bool fDone = false;
+
+    while (!fDone && (SDL_AtomicGet(&pContext->fQuit) == 0))
+    {
+        frameScheduler.BeginFrame();
+        Uint32 cSteps = 0;
+        while (!fDone && ((pReplay == nullptr) ? frameScheduler.StepDue() : (cSteps == 0)))
+        {
+            cSteps++;
+            Uint8 buttons = 0;
+            bool fHaveInput = true;
+            {
+                // Everything up to the checkpoint runs out of memory set up before the loop
+                ASSERT_NO_ALLOCATIONS("Simulation step");
 
-    pSprite->LoadFrames(0, 0, 0, 10);
-    pSprite->LoadFrames(10, 0, Constants::PlayerSpriteHeight, 10);
-    pSprite->LoadAnimationSequence(Constants::AnimationIndexLeft, AnimationType::Loop, Constants::PlayerAnimation_LEFT, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
-    pSprite->LoadAnimationSequence(Constants::AnimationIndexRight, AnimationType::Loop, Constants::PlayerAnimation_RIGHT, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
-    pSprite->LoadAnimationSequence(Constants::AnimationIndexUp, AnimationType::Loop, Constants::PlayerAnimation_UP, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
-    pSprite->LoadAnimationSequence(Constants::AnimationIndexDown, AnimationType::Loop, Constants::PlayerAnimation_DOWN, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
-    pSprite->LoadAnimationSequence(Constants::AnimationIndexDeath, AnimationType::Once, Constants::PlayerAnimation_DEATH, Constants::PlayerAnimationDeathFrameCount, Constants::PlayerAnimationSpeed);
-    pSprite->SetVelocity(1.5, 0);
-    pSprite->SetAnimation(Constants::AnimationIndexRight);
-    pSprite->SetFrameOffset(1 - (Constants::PlayerSpriteWidth / 2), 1 - (Constants::PlayerSpriteHeight / 2));
+                // INPUT
+                {
+                    PROFILE_SCOPE_INTO(ProfilePhase::Input, profileCounters);
+                    if (pReplay != nullptr)
+                    {
+                        fHaveInput = pReplay->NextButtons(&buttons);
+                    }
+                    else
+                    {
+                        // Every event since the last step lands on this one, a tap between two steps isn't missed
+                        buttons = pContext->pInputQueue->NextTickButtons();
+                    }
+                    fDone = !fHaveInput ||
+                        ProcessInput(buttons, pContext->pSprite, pContext->pInputSprite, pContext->pTiledMap, pContext->pCollisionGrid,
+                            &pContext->turn, (pReplay == nullptr) ? pContext->pInputQueue : nullptr);
+                }
+                if (!fDone)
+                {
+                    // UPDATE
+                    // Every entity at once across the pool, moved, stopped at the walls (the player wandering into
+                    // one included) and animated.  Each one only sees the state from the start of the tick
+                    {
+                        PROFILE_SCOPE_INTO(ProfilePhase::Update, profileCounters);
+                        pContext->pEntityStore->UpdateAll(pContext->pThreadPool);
+                    }
 
-    SDL_Point playerStartCoord = pTiledMap->GetTileCoordinates(Constants::PlayerStartRow, Constants::PlayerStartCol);
-    pSprite->ResetPosition(playerStartCoord.x, playerStartCoord.y);
+                    // Everything below looks at more than one entity or at shared state, the merge of the tick.  It runs
+                    // here on this thread, always in the same order
 
-    // Visual for detected input
-    Sprite *pInputSprite = new Sprite(pSpriteTexture, Constants::PlayerSpriteWidth, Constants::PlayerSpriteHeight, 4, 4);
-    pInputSprite->LoadFrames(0, 0, 64, 4);
-    pInputSprite->SetVisible(SDL_FALSE);
+                    // CONTACTS
+                    // Actors touching each other once everyone has moved, only nearby ones are ever compared
+                    {
+                        PROFILE_SCOPE_INTO(ProfilePhase::Contacts, profileCounters);
+                        pContext->pBroadphase->Build(pContext->pEntityStore, pContext->pTiledMap);
+                        pContext->pBroadphase->FindContacts();
+                    }
 
-    *ppPlayerSprite = pSprite;
-    *ppInputSprite = pInputSprite;
+                    // PELLETS
+                    // Only the cells that change are sent, the renderer redraws just those into the map
+                    {
+                        PROFILE_SCOPE_INTO(ProfilePhase::Pellets, profileCounters);
+                        DoPlayerPelletCheck(pContext->pSprite, pContext->pTiledMap, pContext->pPellets, QueueSnapshotTileChange, pContext->pSnapshots);
+                    }
+
+                    // FLOW FIELDS
+                    // Settled positions only, so the fields match what the next step starts from
+                    {
+                        PROFILE_SCOPE_INTO(ProfilePhase::FlowFields, profileCounters);
+                        UpdatePlayerFlowField(pContext->pSprite, pContext->pTiledMap, pContext->pFlowFields);
+                    }
+                    cTicks++;
+                }
+            }
+            if (fHaveInput)
+            {
+                CheckpointTick(pContext->pEntityStore, buttons, pContext->pRecorder, pReplay);
+            }
+        }
+
+        // SNAPSHOT
+        // Only when something changed, the renderer keeps drawing the last one in the meantime
+        if (cSteps > 0)
+        {
+            ASSERT_NO_ALLOCATIONS("Snapshot");
+            RenderSnapshot *pSnapshot = pContext->pSnapshots->WriteBuffer();
+            pSnapshot->tick = cTicks;
+            pSnapshot->focus = pContext->pSprite->Pixel();
+            pSnapshot->cSprites = pContext->pEntityStore->CaptureSprites(pSnapshot->pSprites, pContext->pSnapshots->MaxSprites());
+            SDL_memcpy(pSnapshot->profileCounters, profileCounters, sizeof(profileCounters));
+            SDL_memset(profileCounters, 0, sizeof(profileCounters));
+            pContext->pSnapshots->Publish();
+        }
+
+        // TIMING
+        if (!fDone && (pReplay == nullptr))
+        {
+            SDL_Delay(frameScheduler.MsUntilNextStep());
+        }
+    }
+
+    SDL_AtomicSet(&pContext->fDone, 1);
+    return 0;
 }
 
-int main(int argc, char* /*argv*/[])
+// Usage: xplat-pmc-tutorial-03.exe [--headless [ticks]] [--no-atlas] [--record file] [--replay file]
+int main(int argc, char* argv[])
 {
+    TRACK_SDL_ALLOCATIONS();
+
+    // Startup latency is measured from here to the first present
+    Uint64 startCounter = SDL_GetPerformanceCounter();
     SDL_Renderer *pSDLRenderer = nullptr;
     SDL_Window *pSDLWindow     = nullptr;
+
+    bool fHeadless = false;
+    bool fAtlas = true;
+    Uint32 cHeadlessTicks = Constants::HeadlessDefaultTicks;
+    const char *szRecordFileName = nullptr;
+    const char *szReplayFileName = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        if (SDL_strcmp(argv[i], "--headless") == 0)
+        {
+            fHeadless = true;
+            if ((i + 1 < argc) && (SDL_atoi(argv[i + 1]) > 0))
+            {
+                cHeadlessTicks = SDL_atoi(argv[++i]);
+            }
+        }
+        else if (SDL_strcmp(argv[i], "--no-atlas") == 0)
+        {
+            // Draw from the original textures, handy to compare texture switches against the atlas
+            fAtlas = false;
+        }
+        else if ((SDL_strcmp(argv[i], "--record") == 0) && (i + 1 < argc))
+        {
+            // Log every tick's input and state, to be played back with --replay
+            szRecordFileName = argv[++i];
+        }
+        else if ((SDL_strcmp(argv[i], "--replay") == 0) && (i + 1 < argc))
+        {
+            // Play a recording back, as fast as possible, checking every tick lands where the recording did
+            szReplayFileName = argv[++i];
+        }
+        else
+        {
+            printf("Unknown argument %s\nUsage: %s [--headless [ticks]] [--no-atlas] [--record file] [--replay file]\n", argv[i], argv[0]);
+            return 1;
+        }
+    }
     
+    InputRecorder inputRecorder;
+    InputReplay inputReplay;
+    InputRecorder *pRecorder = (szRecordFileName != nullptr) ? &inputRecorder : nullptr;
+    InputReplay *pReplay = (szReplayFileName != nullptr) ? &inputReplay : nullptr;
+    if ((pReplay != nullptr) && !pReplay->Load(szReplayFileName))
+    {
+        return 1;
+    }
+
     // Lots of things are controlled by XplatGameTutorial::PacManClone::Constants, 
     // e.g. screen dimensions, title, etc
-    if (InitializeSDL(&pSDLWindow, &pSDLRenderer))
+    if (InitializeSDL(&pSDLWindow, &pSDLRenderer, fHeadless, pReplay == nullptr))
     { 
         {   // We'd like the enclosed objects to go out of scope before Cleanup is called
 
-            // Load our textures
-            SDL_Color colorKey = Constants::SDLColorMagenta;
-            TextureWrapper tilesTexture("./grfx/tiles.png", SDL_strlen("./grfx/tiles.png"), pSDLRenderer, nullptr);
-            TextureWrapper spriteTexture("./grfx/spritesheet.png", SDL_strlen("./grfx/spritesheet.png"), pSDLRenderer, &colorKey);
-            
-            if (tilesTexture.IsNull() || spriteTexture.IsNull())
+            // Load our textures.  Unless --no-atlas is given they are packed together so the map and sprites can
+            // be drawn without switching textures
+            TextureCache textureCache(pSDLRenderer, Constants::TextureCacheBudgetBytes, Constants::TextureCacheMaxEntries);
+            // Use the asset pack (make pack) when there is one, the PNGs otherwise
+            AssetPack assetPack;
+            assetPack.Open(Constants::AssetPackFileName);
+            LevelTables levelTables;
+            if (!LoadLevelTables(&assetPack, &levelTables))
+            {
+                printf("Asset pack doesn't match this build, loading the original assets\n");
+                assetPack.Close();
+            }
+            // The loader's workers only decode PNGs, with the pack open there's nothing for them to do so they aren't started
+            AssetLoader *pAssetLoader = assetPack.IsOpen() ? nullptr :
+                new AssetLoader(SDL_min(SDL_max(SDL_GetCPUCount() - 1, 1), Constants::AssetLoaderMaxWorkers), Constants::AssetLoaderMaxRequests);
+            TextureAtlas textureAtlas(Constants::AtlasMaxPageSize, Constants::AtlasMaxPageSize);
+            TextureWrapper *pTilesTexture = nullptr;
+            TextureWrapper *pSpriteTexture = nullptr;
+            SDL_Rect textureRect = { 0, 0, 0, 0 };
+            SDL_Rect spriteRect = { 0, 0, 0, 0 };
+
+            Uint64 loadStartCounter = SDL_GetPerformanceCounter();
+            bool fTexturesLoaded = LoadTextures(fAtlas, pSDLRenderer, &assetPack, pAssetLoader, &textureAtlas, &textureCache, &pTilesTexture, &textureRect, &pSpriteTexture, &spriteRect);
+            double msTextureLoad = ((SDL_GetPerformanceCounter() - loadStartCounter) * 1000.0) / SDL_GetPerformanceFrequency();
+            if (assetPack.IsOpen())
+            {
+                printf("Textures loaded in %.2f ms (from asset pack)\n", msTextureLoad);
+            }
+            else
+            {
+                printf("Textures loaded in %.2f ms (%u decode worker(s))\n", msTextureLoad, pAssetLoader->WorkerCount());
+            }
+            // Everything it loaded has been taken, nothing else is loaded later
+            delete pAssetLoader;
+            pAssetLoader = nullptr;
+
+            if (!fTexturesLoaded)
             {
                 printf("Failed to load one or more textures\n");
             }
             else
             {
-                // This should be know, but it should also match what we just queried
-                SDL_assert(tilesTexture.Width() == Constants::TileTextureWidth);
-                SDL_assert(tilesTexture.Height() == Constants::TileTextureHeight);
-                SDL_Rect textureRect{ 0, 0, Constants::TileTextureWidth, Constants::TileTextureHeight };
+                // This should be know, but it should also match what we just loaded
+                SDL_assert(textureRect.w == Constants::TileTextureWidth);
+                SDL_assert(textureRect.h == Constants::TileTextureHeight);
+
+                // Everything the level allocates (map chunks, sprite sheets, sprites) comes out of this arena and
+                // pools in it, so nothing in the frame loop touches the heap.  It all goes at once when the level does
+                MemoryArena levelArena(Constants::LevelArenaBytes);
 
                 // Initialize our tiled map object
-                TiledMap tiledMap(Constants::MapRows, Constants::MapCols, Constants::ScreenWidth, Constants::ScreenHeight);
+                TiledMap tiledMap(Constants::MapRows, Constants::MapCols, Constants::ScreenWidth, Constants::ScreenHeight, &levelArena);
+
+                tiledMap.Initialize(textureRect, { 0, 0,  Constants::TileWidth,  Constants::TileHeight }, pTilesTexture->Ptr(),
+                    levelTables.pMapIndicies, Constants::MapRows *  Constants::MapCols);
+
+                // Pellets left in the maze, taken from the same tiles the map draws
+                PelletBoard pellets(Constants::MapRows, Constants::MapCols, &levelArena);
+                pellets.Build(levelTables.pMapIndicies, Constants::TileIndexPellet, Constants::TileIndexPowerPellet, Constants::TileIndexEmpty);
 
-                tiledMap.Initialize(textureRect, { 0, 0,  Constants::TileWidth,  Constants::TileHeight }, tilesTexture.Ptr(),
-                    Constants::MapIndicies, Constants::MapRows *  Constants::MapCols);
+                // Buckets actors by tile every step to find the ones touching
+                ActorBroadphase broadphase(Constants::MapRows, Constants::MapCols, Constants::MaxEntities, Constants::MaxContactPairs);
+
+                // Walls and the exits from every cell, built from the level's tables
+                CollisionGrid collisionGrid(Constants::MapRows, Constants::MapCols);
+                collisionGrid.Build(levelTables.pCollisionMap);
+
+                // Distances and first steps between every pair of open cells, for the ghosts to look up
+                Uint64 navigationCounter = SDL_GetPerformanceCounter();
+                NavigationTable navigationTable;
+                if (navigationTable.Build(&collisionGrid))
+                {
+                    printf("Navigation table built in %.2f ms (%u cells, %u KB)\n",
+                        ((SDL_GetPerformanceCounter() - navigationCounter) * 1000.0) / SDL_GetPerformanceFrequency(),
+                        navigationTable.NodeCount(), navigationTable.SizeInBytes() / 1024);
+                }
+
+                // Entity updates and flow fields toward moving targets (the player for now) run in parallel on the
+                // thread pool
+                ThreadPool threadPool(SDL_max(SDL_GetCPUCount() - 1, 0), Constants::ThreadPoolMaxQueuedTasks);
+                FlowFieldService flowFields(&collisionGrid, &threadPool, Constants::FlowFieldMaxTargets);
 
                 // Initialize our sprites
+                // All actor state lives in the store, the sprites are views into it
+                EntityStore entityStore(Constants::MaxEntities, &levelArena);
+                entityStore.SetCollisionMap(&tiledMap, &collisionGrid);
+                ObjectPool<Sprite> sprites(&levelArena, Constants::MaxSprites);
                 Sprite* pSprite = nullptr;
                 Sprite* pInputSprite = nullptr;
-                InitializeSprites(&tiledMap, &spriteTexture, &pSprite, &pInputSprite);
+                InitializeSprites(&sprites, &entityStore, &tiledMap, levelTables, pSpriteTexture, spriteRect, &pSprite, &pInputSprite);
+
+                if (fHeadless)
+                {
+                    // Nothing is ever presented, so this is as close as headless runs get to time to first frame
+                    printf("Time to ready: %.2f ms\n", ((SDL_GetPerformanceCounter() - startCounter) * 1000.0) / SDL_GetPerformanceFrequency());
+                    RunHeadless(&entityStore, pSprite, pInputSprite, &tiledMap, &collisionGrid, &pellets, &broadphase, &threadPool, &flowFields, pRecorder, pReplay, cHeadlessTicks);
+                }
+
+                // Everything drawn in the frame is collected here and submitted per texture
+                RenderBatch renderBatch(pSDLRenderer, Constants::MaxBatchQuads);
+
+                // The simulation runs on its own thread at a fixed rate and hands each state it reaches to this one
+                // as a snapshot.  SDL wants the window, events and renderer on the main thread, so this is the render
+                // thread: it forwards key events, draws the newest snapshot and never waits for the simulation
+                RenderSnapshotBuffer snapshots(Constants::MaxEntities, Constants::RenderSnapshotMaxTiles);
+                InputQueue inputQueue(Constants::InputQueueMaxEvents);
+                SimulationThreadContext simulation = { &entityStore, pSprite, pInputSprite, &tiledMap, &collisionGrid, &pellets,
+                    &broadphase, &threadPool, &flowFields, pRecorder, pReplay, &snapshots, &inputQueue, { Direction::Right, SDL_FALSE, Direction::Right }, {}, {} };
+                SDL_AtomicSet(&simulation.fQuit, 0);
+                SDL_AtomicSet(&simulation.fDone, 0);
 
                 // GAME LOOP -----
-                bool fQuit = false;
+                bool fQuit = fHeadless;
+                bool fFirstFrame = true;
                 SDL_Event eventSDL;
+                Uint64 loopStartCounter = SDL_GetPerformanceCounter();
+                SDL_Thread *pSimulationThread = nullptr;
+                if (!fHeadless)
+                {
+                    pSimulationThread = SDL_CreateThread(SimulationThread, "Simulation", &simulation);
+                    if (pSimulationThread == nullptr)
+                    {
+                        printf("SDL_CreateThread() failed, error = %s\n", SDL_GetError());
+                        fQuit = true;
+                    }
+                }
+
+                // Rendering blends between the last two states of the snapshot by how long ago it was published.
+                // With vsync the present paces the loop, otherwise we nap whenever there's nothing new to draw
+                double counterPerStep = static_cast<double>(SDL_GetPerformanceFrequency()) / Constants::SimulationStepsPerSecond;
+                SDL_RendererInfo rendererInfo;
+                bool fVsync = (SDL_GetRendererInfo(pSDLRenderer, &rendererInfo) == 0) &&
+                    ((rendererInfo.flags & SDL_RENDERER_PRESENTVSYNC) != 0);
+
+                // The first frames build the map's caches and grow SDL's buffers, any frame that creates caches again
+                // starts the warm up over
+                AllocationWarmup renderWarmup(Constants::RenderWarmupFrames);
+                Uint32 cCachesCreated = tiledMap.CachesCreated();
 
-                Uint32 startTicks;
                 while (!fQuit)
                 {
-                    startTicks = SDL_GetTicks();
-                    while (SDL_PollEvent(&eventSDL) != 0)
+                    ASSERT_NO_ALLOCATIONS_ONCE_WARM("Render frame", &renderWarmup);
+                    PROFILE_BEGIN_FRAME();
+
+                    // INPUT
+                    // Key events go to the simulation as they come, with SDL's timestamp, instead of a sample of the
+                    // keyboard once a frame.  It folds everything queued since its last step into the next one
                     {
-                        if (eventSDL.type == SDL_QUIT)
+                        PROFILE_SCOPE(ProfilePhase::Input);
+                        while (SDL_PollEvent(&eventSDL) != 0)
                         {
-                            fQuit = true;
+                            if (eventSDL.type == SDL_QUIT)
+                            {
+                                fQuit = true;
+                            }
+                            else if ((eventSDL.type == SDL_KEYDOWN) && (eventSDL.key.keysym.scancode == SDL_SCANCODE_F1))
+                            {
+                                // Frame phase overlay (only in PMC_PROFILING builds)
+                                PROFILE_TOGGLE_OVERLAY();
+                            }
+                            else if ((eventSDL.type == SDL_KEYDOWN) || (eventSDL.type == SDL_KEYUP))
+                            {
+                                inputQueue.PushKeyEvent(eventSDL.key);
+                            }
+                            else if (eventSDL.type == SDL_RENDER_TARGETS_RESET)
+                            {
+                                // Target texture contents are gone, the map cache needs to be redrawn
+                                tiledMap.ResetCache(SDL_FALSE);
+                                renderWarmup.Restart();
+                            }
+                            else if (eventSDL.type == SDL_RENDER_DEVICE_RESET)
+                            {
+                                tiledMap.ResetCache(SDL_TRUE);
+                                renderWarmup.Restart();
+                            }
                         }
                     }
+                    fQuit = fQuit || (SDL_AtomicGet(&simulation.fDone) != 0);
 
-                    if (!fQuit)
+                    bool fNew = false;
+                    const RenderSnapshot *pSnapshot = snapshots.AcquireLatest(fNew);
+                    if (!fQuit && (pSnapshot != nullptr))
                     {
-                        // INPUT
-                        fQuit = ProcessInput(pSprite, pInputSprite, &tiledMap);
-                        if (!fQuit)
+                        // The simulation's time is only counted once, with the snapshot that carried it
+                        if (fNew)
                         {
-                            // UPDATE
-                            pSprite->Update();
-
-                            // BOUNDS CHECK
-                            // We still need to check if the player has wandered into a wall
-                            DoPlayerBoundsCheck(pSprite, &tiledMap);
-
-                            // RENDERING
-                            SDL_RenderClear(pSDLRenderer);
-                            tiledMap.Render(pSDLRenderer);
-                            pSprite->Render(pSDLRenderer);
-                            pInputSprite->Render(pSDLRenderer);
-                            SDL_RenderPresent(pSDLRenderer);
+                            PROFILE_ADD_SAMPLES(pSnapshot->profileCounters);
+                        }
 
-                            // TIMING
-                            // Fix this at ~c_framesPerSecond
-                            Uint32 endTicks = SDL_GetTicks();
-                            Uint32 elapsedTicks = endTicks - startTicks;
-                            if (elapsedTicks < Constants::TicksPerFrame)
+                        // Map changes the simulation made since the last snapshot we applied
+                        for (Uint32 i = 0; i < pSnapshot->cTiles; i++)
+                        {
+                            const SnapshotTile &tile = pSnapshot->pTiles[i];
+                            if (static_cast<Sint32>(tile.sequence - snapshots.AppliedTileSequence()) > 0)
+                            {
+                                tiledMap.SetTile(tile.row, tile.col, tile.index);
+                            }
+                        }
+                        snapshots.AcknowledgeTiles(pSnapshot);
+
+                        // RENDERING
+                        // A replay steps as fast as it can, there's nothing to blend toward
+                        double alpha = (pReplay == nullptr) ?
+                            SDL_min((SDL_GetPerformanceCounter() - pSnapshot->publishCounter) / counterPerStep, 1.0) : 1.0;
+                        renderWarmup.BeginFrame();
+                        SDL_RenderClear(pSDLRenderer);
+                        renderBatch.Begin();
+
+                        // Follow the player when the map is bigger than the screen, everything is queued in world
+                        // pixels and the batch moves it to the screen
+                        tiledMap.CenterCamera(pSnapshot->focus);
+                        renderBatch.SetViewOrigin(tiledMap.Camera());
+                        {
+                            PROFILE_SCOPE(ProfilePhase::MapRender);
+                            tiledMap.Render(pSDLRenderer, &renderBatch, Constants::RenderLayerMap);
+                            if (tiledMap.CachesCreated() != cCachesCreated)
                             {
-                                SDL_Delay(Constants::TicksPerFrame - elapsedTicks);
+                                // A chunk came into view (or back after a device reset)
+                                cCachesCreated = tiledMap.CachesCreated();
+                                renderWarmup.Restart();
                             }
                         }
+                        {
+                            PROFILE_SCOPE(ProfilePhase::SpriteRender);
+                            entityStore.RenderSnapshotSprites(pSnapshot, &renderBatch, alpha);
+                        }
+                        {
+                            PROFILE_SCOPE(ProfilePhase::BatchFlush);
+                            renderBatch.Flush();
+                        }
+                        PROFILE_RENDER_OVERLAY(pSDLRenderer);
+                        {
+                            PROFILE_SCOPE(ProfilePhase::Present);
+                            SDL_RenderPresent(pSDLRenderer);
+                        }
+                        snapshots.NotePresented(pSnapshot, fNew);
+                        if (fFirstFrame)
+                        {
+                            fFirstFrame = false;
+                            printf("Time to first frame: %.2f ms\n", ((SDL_GetPerformanceCounter() - startCounter) * 1000.0) / SDL_GetPerformanceFrequency());
+                        }
+                    }
+
+                    // TIMING
+                    if (!fQuit && !fVsync && !fNew)
+                    {
+                        PROFILE_SCOPE(ProfilePhase::Sleep);
+                        SDL_Delay(1);
+                    }
+                }
+
+                if (pSimulationThread != nullptr)
+                {
+                    SDL_AtomicSet(&simulation.fQuit, 1);
+                    SDL_WaitThread(pSimulationThread, nullptr);
+                }
+
+                if (!fHeadless)
+                {
+                    const RenderBatchStats &renderStats = renderBatch.Stats();
+                    printf("Last frame: %d quads, %d batches, %d texture switches (%d texture(s)%s)\n",
+                        renderStats.cQuads, renderStats.cBatches, renderStats.cTextureSwitches,
+                        fAtlas ? textureAtlas.PageCount() : textureCache.Stats().cEntries, fAtlas ? ", atlas" : "");
+                    RenderSnapshotStats snapshotStats = snapshots.Stats();
+                    printf("Snapshots: %u published, %u dropped, %u frames presented (%u repeats), age %.2f ms mean %.2f ms max\n",
+                        snapshotStats.cPublished, snapshotStats.cDropped, snapshotStats.cPresented, snapshotStats.cDuplicated,
+                        snapshotStats.msAgeMean, snapshotStats.msAgeMax);
+                    InputLatencyStats inputStats = inputQueue.LatencyStats();
+                    printf("Input: %u turns, key to turn %.1f ms mean %u ms max, %u events dropped\n",
+                        inputStats.cTurns, inputStats.msMean, inputStats.msMax, inputStats.cDropped);
+                    printf("Pellets: %u of %u left\n", pellets.Remaining(), pellets.Total());
+                    PROFILE_REPORT(Constants::ProfileCsvFileName);
+                    if (pReplay != nullptr)
+                    {
+                        ReportReplay(pReplay, static_cast<double>(SDL_GetPerformanceCounter() - loopStartCounter) / SDL_GetPerformanceFrequency());
                     }
                 }
+
+                printf("Level arena: %u of %u KB used, %u of %u sprites\n", static_cast<Uint32>(levelArena.HighWater() / 1024),
+                    static_cast<Uint32>(levelArena.Capacity() / 1024), sprites.Count(), sprites.Capacity());
+
+                if ((pRecorder != nullptr) && pRecorder->Save(szRecordFileName))
+                {
+                    printf("Recorded %u ticks to %s\n", pRecorder->TickCount(), szRecordFileName);
+                }
+            }
+
+            // Hand back what came from the cache (atlas pages belong to the atlas)
+            if (!fAtlas)
+            {
+                if (pTilesTexture != nullptr)
+                {
+                    textureCache.Release(pTilesTexture);
+                }
+                if (pSpriteTexture != nullptr)
+                {
+                    textureCache.Release(pSpriteTexture);
+                }
+                textureCache.PrintStats();
             }
         }
 
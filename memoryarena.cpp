@@ -0,0 +1,115 @@
+#include "include/memoryarena.h"
+#include <stdlib.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+MemoryArena::MemoryArena(size_t cbCapacity) :
+    _pBase(nullptr),
+    _cbCapacity(cbCapacity),
+    _cbUsed(0),
+    _cbHighWater(0)
+{
+    _pBase = new Uint8[_cbCapacity];
+}
+
+MemoryArena::~MemoryArena()
+{
+    delete[] _pBase;
+}
+
+void *MemoryArena::Allocate(size_t cb, size_t alignment)
+{
+    SDL_assert((alignment > 0) && ((alignment & (alignment - 1)) == 0));
+
+    // Align the address, not just the offset, new[] only promises the fundamental alignment
+    size_t address = reinterpret_cast<size_t>(_pBase) + _cbUsed;
+    size_t cbPadding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+    if ((cbPadding > _cbCapacity - _cbUsed) || (cb > _cbCapacity - _cbUsed - cbPadding))
+    {
+        printf("MemoryArena::Allocate() : arena is full (%u of %u bytes used, %u wanted)\n",
+            static_cast<Uint32>(_cbUsed), static_cast<Uint32>(_cbCapacity), static_cast<Uint32>(cb));
+        SDL_assert(false);
+        return nullptr;
+    }
+
+    void *pAllocation = _pBase + _cbUsed + cbPadding;
+    _cbUsed += cbPadding + cb;
+    _cbHighWater = SDL_max(_cbHighWater, _cbUsed);
+    return pAllocation;
+}
+
+void MemoryArena::Reset()
+{
+    _cbUsed = 0;
+}
+
+#ifdef PMC_ALLOCATION_TRACKING
+// Per thread so one thread's loading (or a recording growing) doesn't trip another thread's frame check
+static thread_local Uint64 t_cAllocations = 0;
+
+Uint64 XplatGameTutorial::PacManClone::ThreadAllocationCount()
+{
+    return t_cAllocations;
+}
+
+// Replacing these four covers every form of new, the nothrow and sized forms go through them
+void *operator new(size_t cb)
+{
+    t_cAllocations++;
+    void *pAllocation = malloc((cb > 0) ? cb : 1);
+    if (pAllocation == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pAllocation;
+}
+
+void *operator new[](size_t cb)
+{
+    return operator new(cb);
+}
+
+void operator delete(void *pAllocation) noexcept
+{
+    free(pAllocation);
+}
+
+void operator delete[](void *pAllocation) noexcept
+{
+    operator delete(pAllocation);
+}
+
+// SDL's own allocations (and SDL_image's, which go through SDL_malloc too), counted against the same thread.  A
+// realloc counts, it may well move the block
+static void * SDLCALL TrackedSDLMalloc(size_t cb)
+{
+    t_cAllocations++;
+    return malloc(cb);
+}
+
+static void * SDLCALL TrackedSDLCalloc(size_t cElements, size_t cbElement)
+{
+    t_cAllocations++;
+    return calloc(cElements, cbElement);
+}
+
+static void * SDLCALL TrackedSDLRealloc(void *pAllocation, size_t cb)
+{
+    t_cAllocations++;
+    return realloc(pAllocation, cb);
+}
+
+static void SDLCALL TrackedSDLFree(void *pAllocation)
+{
+    free(pAllocation);
+}
+
+void XplatGameTutorial::PacManClone::TrackSDLAllocations()
+{
+    // Still the C runtime underneath, so anything SDL allocated before the swap is freed the same way after it
+    if (SDL_SetMemoryFunctions(TrackedSDLMalloc, TrackedSDLCalloc, TrackedSDLRealloc, TrackedSDLFree) != 0)
+    {
+        printf("SDL_SetMemoryFunctions() failed, error = %s\n", SDL_GetError());
+    }
+}
+#endif
@@ -0,0 +1,275 @@
+#include "include/movementkernel.h"
+#include <stdio.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PMC_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+// GCC/Clang only emit AVX2 instructions in functions marked for it, MSVC doesn't need (or have) the attribute
+#if defined(PMC_KERNEL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define PMC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define PMC_TARGET_AVX2
+#endif
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    bool InitializeMovementKernelMap(MovementKernelMap &kernelMap, TiledMap *pTiledMap, const Uint16 *pCollisionMap, Sint32 xProbe, Sint32 yProbe)
+    {
+        SDL_Rect bounds = pTiledMap->GetMapBounds();
+        Uint16 tileSize = pTiledMap->TileSize();
+        if ((tileSize == 0) || ((tileSize & (tileSize - 1)) != 0))
+        {
+            printf("InitializeMovementKernelMap() : tile size %d is not a power of 2\n", tileSize);
+            return false;
+        }
+
+        kernelMap.xMap = bounds.x;
+        kernelMap.yMap = bounds.y;
+        kernelMap.cxMap = bounds.w;
+        kernelMap.cyMap = bounds.h;
+        kernelMap.tileShift = 0;
+        while ((1 << kernelMap.tileShift) < tileSize)
+        {
+            kernelMap.tileShift++;
+        }
+        kernelMap.cCols = bounds.w / tileSize;
+        kernelMap.xProbe = xProbe;
+        kernelMap.yProbe = yProbe;
+
+        int cCells = (bounds.w / tileSize) * (bounds.h / tileSize);
+        kernelMap.pCollision = new Sint32[cCells];
+        for (int i = 0; i < cCells; i++)
+        {
+            kernelMap.pCollision[i] = pCollisionMap[i];
+        }
+        return true;
+    }
+
+    void FreeMovementKernelMap(MovementKernelMap &kernelMap)
+    {
+        delete[] kernelMap.pCollision;
+        kernelMap.pCollision = nullptr;
+    }
+
+    // The reference implementation, the same steps as Sprite::Update + DoPlayerBoundsCheck without the tunnel wrap
+    // (off map probes land on cell [0][0], a wall)
+    static void MoveAndCollideScalar(MovementBatch &batch, const MovementKernelMap &kernelMap, Uint32 iFirst)
+    {
+        for (Uint32 i = iFirst; i < batch.cActors; i++)
+        {
+            batch.pXPrevious[i] = batch.pX[i];
+            batch.pYPrevious[i] = batch.pY[i];
+            batch.pX[i] += batch.pDX[i];
+            batch.pY[i] += batch.pDY[i];
+
+            int x = FixedToInt(batch.pX[i]);
+            int y = FixedToInt(batch.pY[i]);
+            if (batch.pDX[i] != 0)
+            {
+                x += (batch.pDX[i] < 0) ? -kernelMap.xProbe : kernelMap.xProbe;
+            }
+            else
+            {
+                y += (batch.pDY[i] < 0) ? -kernelMap.yProbe : kernelMap.yProbe;
+            }
+
+            int row = 0;
+            int col = 0;
+            if ((x >= kernelMap.xMap) && (x < kernelMap.xMap + kernelMap.cxMap) &&
+                (y >= kernelMap.yMap) && (y < kernelMap.yMap + kernelMap.cyMap))
+            {
+                row = (y - kernelMap.yMap) >> kernelMap.tileShift;
+                col = (x - kernelMap.xMap) >> kernelMap.tileShift;
+            }
+
+            if (kernelMap.pCollision[row * kernelMap.cCols + col] == 1)
+            {
+                batch.pDX[i] = 0;
+                batch.pDY[i] = 0;
+            }
+        }
+    }
+
+#ifdef PMC_KERNEL_X86
+    // Four actors per iteration, positions and velocities are 32 bit fixed point so they fill a register.  SSE2 has
+    // no gather (or 32 bit multiply) so the four collision lookups are scalar loads
+    static Uint32 MoveAndCollideSSE2(MovementBatch &batch, const MovementKernelMap &kernelMap)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128i xProbe = _mm_set1_epi32(kernelMap.xProbe);
+        const __m128i yProbe = _mm_set1_epi32(kernelMap.yProbe);
+        const __m128i xMapMinus1 = _mm_set1_epi32(kernelMap.xMap - 1);
+        const __m128i yMapMinus1 = _mm_set1_epi32(kernelMap.yMap - 1);
+        const __m128i xMapEnd = _mm_set1_epi32(kernelMap.xMap + kernelMap.cxMap);
+        const __m128i yMapEnd = _mm_set1_epi32(kernelMap.yMap + kernelMap.cyMap);
+        const __m128i xMap = _mm_set1_epi32(kernelMap.xMap);
+        const __m128i yMap = _mm_set1_epi32(kernelMap.yMap);
+        const __m128i tileShift = _mm_cvtsi32_si128(kernelMap.tileShift);
+
+        Uint32 i = 0;
+        for (; i + 4 <= batch.cActors; i += 4)
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&batch.pX[i]));
+            __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&batch.pY[i]));
+            __m128i dx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&batch.pDX[i]));
+            __m128i dy = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&batch.pDY[i]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&batch.pXPrevious[i]), x);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&batch.pYPrevious[i]), y);
+            x = _mm_add_epi32(x, dx);
+            y = _mm_add_epi32(y, dy);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&batch.pX[i]), x);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&batch.pY[i]), y);
+
+            // Whole pixels, the arithmetic shift rounds down like FixedToInt
+            __m128i ix = _mm_srai_epi32(x, FixedShift);
+            __m128i iy = _mm_srai_epi32(y, FixedShift);
+
+            // Sign bit smeared across the lane is the "negative" mask
+            __m128i dxZero = _mm_cmpeq_epi32(dx, zero);
+            __m128i dxNegative = _mm_srai_epi32(dx, 31);
+            __m128i dyNegative = _mm_srai_epi32(dy, 31);
+
+            // probe = negative ? -probe : probe, as (probe ^ mask) - mask
+            __m128i xOffset = _mm_sub_epi32(_mm_xor_si128(xProbe, dxNegative), dxNegative);
+            __m128i yOffset = _mm_sub_epi32(_mm_xor_si128(yProbe, dyNegative), dyNegative);
+            ix = _mm_add_epi32(ix, _mm_andnot_si128(dxZero, xOffset));
+            iy = _mm_add_epi32(iy, _mm_and_si128(dxZero, yOffset));
+
+            __m128i inBounds = _mm_and_si128(
+                _mm_and_si128(_mm_cmpgt_epi32(ix, xMapMinus1), _mm_cmplt_epi32(ix, xMapEnd)),
+                _mm_and_si128(_mm_cmpgt_epi32(iy, yMapMinus1), _mm_cmplt_epi32(iy, yMapEnd)));
+            __m128i row = _mm_and_si128(_mm_sra_epi32(_mm_sub_epi32(iy, yMap), tileShift), inBounds);
+            __m128i col = _mm_and_si128(_mm_sra_epi32(_mm_sub_epi32(ix, xMap), tileShift), inBounds);
+
+            Sint32 rows[4];
+            Sint32 cols[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(rows), row);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(cols), col);
+            __m128i blocked = _mm_cmpeq_epi32(_mm_setr_epi32(
+                kernelMap.pCollision[rows[0] * kernelMap.cCols + cols[0]], kernelMap.pCollision[rows[1] * kernelMap.cCols + cols[1]],
+                kernelMap.pCollision[rows[2] * kernelMap.cCols + cols[2]], kernelMap.pCollision[rows[3] * kernelMap.cCols + cols[3]]),
+                one);
+
+            // Clear the velocity of anything that hit a wall
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&batch.pDX[i]), _mm_andnot_si128(blocked, dx));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&batch.pDY[i]), _mm_andnot_si128(blocked, dy));
+        }
+        return i;
+    }
+
+    // Eight actors per iteration with a real gather for the collision lookups
+    PMC_TARGET_AVX2 static Uint32 MoveAndCollideAVX2(MovementBatch &batch, const MovementKernelMap &kernelMap)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i xProbe = _mm256_set1_epi32(kernelMap.xProbe);
+        const __m256i yProbe = _mm256_set1_epi32(kernelMap.yProbe);
+        const __m256i xMapMinus1 = _mm256_set1_epi32(kernelMap.xMap - 1);
+        const __m256i yMapMinus1 = _mm256_set1_epi32(kernelMap.yMap - 1);
+        const __m256i xMapEnd = _mm256_set1_epi32(kernelMap.xMap + kernelMap.cxMap);
+        const __m256i yMapEnd = _mm256_set1_epi32(kernelMap.yMap + kernelMap.cyMap);
+        const __m256i xMap = _mm256_set1_epi32(kernelMap.xMap);
+        const __m256i yMap = _mm256_set1_epi32(kernelMap.yMap);
+        const __m256i cCols = _mm256_set1_epi32(kernelMap.cCols);
+        const __m128i tileShift = _mm_cvtsi32_si128(kernelMap.tileShift);
+
+        Uint32 i = 0;
+        for (; i + 8 <= batch.cActors; i += 8)
+        {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&batch.pX[i]));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&batch.pY[i]));
+            __m256i dx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&batch.pDX[i]));
+            __m256i dy = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&batch.pDY[i]));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&batch.pXPrevious[i]), x);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&batch.pYPrevious[i]), y);
+            x = _mm256_add_epi32(x, dx);
+            y = _mm256_add_epi32(y, dy);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&batch.pX[i]), x);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&batch.pY[i]), y);
+
+            __m256i ix = _mm256_srai_epi32(x, FixedShift);
+            __m256i iy = _mm256_srai_epi32(y, FixedShift);
+
+            __m256i dxZero = _mm256_cmpeq_epi32(dx, zero);
+            __m256i dxNegative = _mm256_srai_epi32(dx, 31);
+            __m256i dyNegative = _mm256_srai_epi32(dy, 31);
+
+            __m256i xOffset = _mm256_sub_epi32(_mm256_xor_si256(xProbe, dxNegative), dxNegative);
+            __m256i yOffset = _mm256_sub_epi32(_mm256_xor_si256(yProbe, dyNegative), dyNegative);
+            ix = _mm256_add_epi32(ix, _mm256_andnot_si256(dxZero, xOffset));
+            iy = _mm256_add_epi32(iy, _mm256_and_si256(dxZero, yOffset));
+
+            // AVX2 only has a greater than compare, so a < b is written b > a
+            __m256i inBounds = _mm256_and_si256(
+                _mm256_and_si256(_mm256_cmpgt_epi32(ix, xMapMinus1), _mm256_cmpgt_epi32(xMapEnd, ix)),
+                _mm256_and_si256(_mm256_cmpgt_epi32(iy, yMapMinus1), _mm256_cmpgt_epi32(yMapEnd, iy)));
+            __m256i row = _mm256_and_si256(_mm256_sra_epi32(_mm256_sub_epi32(iy, yMap), tileShift), inBounds);
+            __m256i col = _mm256_and_si256(_mm256_sra_epi32(_mm256_sub_epi32(ix, xMap), tileShift), inBounds);
+            __m256i cell = _mm256_add_epi32(_mm256_mullo_epi32(row, cCols), col);
+
+            __m256i blocked = _mm256_cmpeq_epi32(_mm256_i32gather_epi32(kernelMap.pCollision, cell, 4), one);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&batch.pDX[i]), _mm256_andnot_si256(blocked, dx));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&batch.pDY[i]), _mm256_andnot_si256(blocked, dy));
+        }
+        return i;
+    }
+#endif
+
+    KernelPath BestKernelPath()
+    {
+#ifdef PMC_KERNEL_X86
+        if (SDL_HasAVX2() == SDL_TRUE)
+        {
+            return KernelPath::AVX2;
+        }
+        if (SDL_HasSSE2() == SDL_TRUE)
+        {
+            return KernelPath::SSE2;
+        }
+#endif
+        return KernelPath::Scalar;
+    }
+
+    const char* KernelPathName(KernelPath path)
+    {
+        switch (path)
+        {
+        case KernelPath::Auto:
+            return "auto";
+        case KernelPath::SSE2:
+            return "sse2";
+        case KernelPath::AVX2:
+            return "avx2";
+        default:
+            return "scalar";
+        }
+    }
+
+    // The vector paths do as many whole groups as they can, the scalar path finishes the rest
+    void MoveAndCollide(MovementBatch &batch, const MovementKernelMap &kernelMap, KernelPath path)
+    {
+        if (path == KernelPath::Auto)
+        {
+            path = BestKernelPath();
+        }
+
+        Uint32 iFirst = 0;
+#ifdef PMC_KERNEL_X86
+        if (path == KernelPath::AVX2)
+        {
+            iFirst = MoveAndCollideAVX2(batch, kernelMap);
+        }
+        else if (path == KernelPath::SSE2)
+        {
+            iFirst = MoveAndCollideSSE2(batch, kernelMap);
+        }
+#endif
+        MoveAndCollideScalar(batch, kernelMap, iFirst);
+    }
+}
+}
@@ -0,0 +1,224 @@
+#include "include/navigationtable.h"
+#include <stdio.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+// The order ties are broken in, the arcade game prefers up, then left, then down
+static const Direction c_directionPriority[4] = { Direction::Up, Direction::Left, Direction::Down, Direction::Right };
+
+NavigationTable::NavigationTable() :
+    _pCollisionGrid(nullptr),
+    _cRows(0),
+    _cCols(0),
+    _pNodeOfCell(nullptr),
+    _pNeighbors(nullptr),
+    _cNodes(0),
+    _pDistances(nullptr),
+    _pNextHops(nullptr),
+    _pStale(nullptr),
+    _cStale(0),
+    _pQueue(nullptr)
+{
+}
+
+NavigationTable::~NavigationTable()
+{
+    FreeTables();
+    delete[] _pNodeOfCell;
+}
+
+void NavigationTable::FreeTables()
+{
+    delete[] _pNeighbors;
+    delete[] _pDistances;
+    delete[] _pNextHops;
+    delete[] _pStale;
+    delete[] _pQueue;
+    _pNeighbors = nullptr;
+    _pDistances = nullptr;
+    _pNextHops = nullptr;
+    _pStale = nullptr;
+    _pQueue = nullptr;
+    _cNodes = 0;
+    _cStale = 0;
+}
+
+bool NavigationTable::Build(const CollisionGrid *pCollisionGrid)
+{
+    _pCollisionGrid = pCollisionGrid;
+    _cRows = pCollisionGrid->Rows();
+    _cCols = pCollisionGrid->Cols();
+    delete[] _pNodeOfCell;
+    _pNodeOfCell = new Uint16[_cRows * _cCols];
+
+    if (!IndexNodes())
+    {
+        return false;
+    }
+    Refresh(_cNodes);
+    return true;
+}
+
+bool NavigationTable::GridChanged()
+{
+    SDL_assert(_pCollisionGrid != nullptr);
+    return IndexNodes();
+}
+
+// Number the open cells row by row, link each to the cells its exits lead to and size the tables to match.  Every
+// target starts out stale
+bool NavigationTable::IndexNodes()
+{
+    FreeTables();
+
+    Uint32 cNodes = 0;
+    for (Uint16 r = 0; r < _cRows; r++)
+    {
+        for (Uint16 c = 0; c < _cCols; c++)
+        {
+            bool fOpen = _pCollisionGrid->IsWalkable(r, c);
+            _pNodeOfCell[(r * _cCols) + c] = fOpen ? static_cast<Uint16>(cNodes) : c_noNode;
+            cNodes += fOpen ? 1 : 0;
+            if (cNodes > c_maxNodes)
+            {
+                printf("NavigationTable::IndexNodes() : more than %u open cells\n", c_maxNodes);
+                SDL_memset(_pNodeOfCell, 0xFF, _cRows * _cCols * sizeof(Uint16));
+                return false;
+            }
+        }
+    }
+
+    _cNodes = cNodes;
+    _pNeighbors = new Uint16[_cNodes * 4];
+    _pDistances = new Uint16[_cNodes * _cNodes];
+    _pNextHops = new Uint8[(_cNodes * _cNodes + 3) / 4];
+    _pStale = new Uint8[_cNodes];
+    _pQueue = new Uint16[_cNodes];
+    SDL_memset(_pStale, 1, _cNodes);
+    _cStale = _cNodes;
+
+    for (Uint16 r = 0; r < _cRows; r++)
+    {
+        for (Uint16 c = 0; c < _cCols; c++)
+        {
+            Uint16 node = _pNodeOfCell[(r * _cCols) + c];
+            if (node == c_noNode)
+            {
+                continue;
+            }
+
+            // Stepping off one edge of the map comes back in on the other, like the grid's exits
+            Uint8 exits = _pCollisionGrid->ExitsAt(r, c);
+            Uint16 up = (r == 0) ? (_cRows - 1) : (r - 1);
+            Uint16 down = (r == (_cRows - 1)) ? 0 : (r + 1);
+            Uint16 left = (c == 0) ? (_cCols - 1) : (c - 1);
+            Uint16 right = (c == (_cCols - 1)) ? 0 : (c + 1);
+            Uint16 *pNeighbors = &_pNeighbors[node * 4];
+            pNeighbors[static_cast<int>(Direction::Up)] = (exits & CollisionGrid::ExitBit(Direction::Up)) ? NodeAt(up, c) : c_noNode;
+            pNeighbors[static_cast<int>(Direction::Down)] = (exits & CollisionGrid::ExitBit(Direction::Down)) ? NodeAt(down, c) : c_noNode;
+            pNeighbors[static_cast<int>(Direction::Left)] = (exits & CollisionGrid::ExitBit(Direction::Left)) ? NodeAt(r, left) : c_noNode;
+            pNeighbors[static_cast<int>(Direction::Right)] = (exits & CollisionGrid::ExitBit(Direction::Right)) ? NodeAt(r, right) : c_noNode;
+        }
+    }
+    return true;
+}
+
+Uint32 NavigationTable::Refresh(Uint32 cTargets)
+{
+    for (Uint32 target = 0; (target < _cNodes) && (cTargets > 0) && (_cStale > 0); target++)
+    {
+        if (_pStale[target])
+        {
+            SearchFrom(static_cast<Uint16>(target));
+            cTargets--;
+        }
+    }
+    return _cStale;
+}
+
+// Breadth first out of the target gives every node's distance to it (moves are reversible, the exits are
+// symmetric).  Then each node's first step is the neighbor one move closer, in priority order
+void NavigationTable::SearchFrom(Uint16 target)
+{
+    Uint16 *pDistances = &_pDistances[target * _cNodes];
+    SDL_memset(pDistances, 0xFF, _cNodes * sizeof(Uint16));
+
+    Uint32 iHead = 0;
+    Uint32 iTail = 0;
+    pDistances[target] = 0;
+    _pQueue[iTail++] = target;
+    while (iHead < iTail)
+    {
+        Uint16 node = _pQueue[iHead++];
+        const Uint16 *pNeighbors = &_pNeighbors[node * 4];
+        for (int d = 0; d < 4; d++)
+        {
+            Uint16 neighbor = pNeighbors[d];
+            if ((neighbor != c_noNode) && (pDistances[neighbor] == c_unreachable))
+            {
+                pDistances[neighbor] = pDistances[node] + 1;
+                _pQueue[iTail++] = neighbor;
+            }
+        }
+    }
+
+    Uint32 iFirstHop = target * _cNodes;
+    for (Uint32 node = 0; node < _cNodes; node++)
+    {
+        Uint8 hop = 0;
+        if ((pDistances[node] != c_unreachable) && (pDistances[node] != 0))
+        {
+            const Uint16 *pNeighbors = &_pNeighbors[node * 4];
+            for (int i = 0; i < 4; i++)
+            {
+                Uint16 neighbor = pNeighbors[static_cast<int>(c_directionPriority[i])];
+                if ((neighbor != c_noNode) && (pDistances[neighbor] == (pDistances[node] - 1)))
+                {
+                    hop = static_cast<Uint8>(c_directionPriority[i]);
+                    break;
+                }
+            }
+        }
+
+        Uint32 iHop = iFirstHop + node;
+        int shift = (iHop & 3) << 1;
+        _pNextHops[iHop >> 2] = static_cast<Uint8>((_pNextHops[iHop >> 2] & ~(3 << shift)) | (hop << shift));
+    }
+
+    _pStale[target] = 0;
+    _cStale--;
+}
+
+Uint16 NavigationTable::Distance(Uint16 fromRow, Uint16 fromCol, Uint16 toRow, Uint16 toCol)
+{
+    Uint16 from = NodeAt(fromRow, fromCol);
+    Uint16 to = NodeAt(toRow, toCol);
+    if ((from == c_noNode) || (to == c_noNode))
+    {
+        return c_unreachable;
+    }
+    if (_pStale[to])
+    {
+        SearchFrom(to);
+    }
+    return _pDistances[(to * _cNodes) + from];
+}
+
+bool NavigationTable::NextDirection(Uint16 fromRow, Uint16 fromCol, Uint16 toRow, Uint16 toCol, Direction &direction)
+{
+    Uint16 distance = Distance(fromRow, fromCol, toRow, toCol);
+    if ((distance == c_unreachable) || (distance == 0))
+    {
+        return false;
+    }
+
+    Uint32 iHop = (NodeAt(toRow, toCol) * _cNodes) + NodeAt(fromRow, fromCol);
+    direction = static_cast<Direction>((_pNextHops[iHop >> 2] >> ((iHop & 3) << 1)) & 3);
+    return true;
+}
+
+Uint32 NavigationTable::SizeInBytes()
+{
+    return (_cRows * _cCols * sizeof(Uint16)) + (_cNodes * 4 * sizeof(Uint16)) + (_cNodes * _cNodes * sizeof(Uint16)) +
+        ((_cNodes * _cNodes + 3) / 4) + _cNodes;
+}
@@ -0,0 +1,94 @@
+#include "include/pelletboard.h"
+#include "include/bitscan.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+PelletBoard::PelletBoard(Uint16 rows, Uint16 cols, MemoryArena *pLevelArena) :
+    _cRows(rows),
+    _cCols(cols),
+    _cWordsPerRow((cols + 63) / 64),
+    _pBoards(nullptr),
+    _pPellets(nullptr),
+    _pPower(nullptr),
+    _pInitialBoards(nullptr),
+    _cRemaining(0),
+    _cTotal(0),
+    _pelletTile(0),
+    _powerTile(0),
+    _emptyTile(0)
+{
+    Uint32 cWords = _cRows * _cWordsPerRow;
+    _pBoards = pLevelArena->AllocateArray<Uint64>(2 * cWords);
+    _pInitialBoards = pLevelArena->AllocateArray<Uint64>(2 * cWords);
+    SDL_assert((_pBoards != nullptr) && (_pInitialBoards != nullptr));
+    _pPellets = _pBoards;
+    _pPower = _pBoards + cWords;
+}
+
+void PelletBoard::Build(const Uint16 *pMapIndicies, Uint16 pelletTile, Uint16 powerTile, Uint16 emptyTile)
+{
+    _pelletTile = pelletTile;
+    _powerTile = powerTile;
+    _emptyTile = emptyTile;
+    _cTotal = 0;
+
+    SDL_memset(_pBoards, 0, 2 * _cRows * _cWordsPerRow * sizeof(Uint64));
+    for (Uint16 r = 0; r < _cRows; r++)
+    {
+        Uint64 *pPelletRow = &_pPellets[r * _cWordsPerRow];
+        Uint64 *pPowerRow = &_pPower[r * _cWordsPerRow];
+        for (Uint16 c = 0; c < _cCols; c++)
+        {
+            Uint16 index = pMapIndicies[(r * _cCols) + c];
+            bool fPower = (index == powerTile);
+            bool fPellet = fPower || (index == pelletTile);
+            pPelletRow[c >> 6] |= static_cast<Uint64>(fPellet) << (c & 63);
+            pPowerRow[c >> 6] |= static_cast<Uint64>(fPower) << (c & 63);
+            _cTotal += fPellet ? 1 : 0;
+        }
+    }
+
+    SDL_memcpy(_pInitialBoards, _pBoards, 2 * _cRows * _cWordsPerRow * sizeof(Uint64));
+    _cRemaining = _cTotal;
+}
+
+PelletType PelletBoard::Eat(Uint16 row, Uint16 col)
+{
+    PelletType pellet = PelletAt(row, col);
+    if (pellet != PelletType::None)
+    {
+        Uint32 word = (row * _cWordsPerRow) + (col >> 6);
+        Uint64 mask = ~(1ULL << (col & 63));
+        _pPellets[word] &= mask;
+        _pPower[word] &= mask;
+        _cRemaining--;
+    }
+    return pellet;
+}
+
+void PelletBoard::Reset(PelletTileCallback pfnTileChanged, void *pContext)
+{
+    if (pfnTileChanged != nullptr)
+    {
+        // Only the eaten cells, a set bit in the initial board that's clear in the live one
+        const Uint64 *pInitialPower = _pInitialBoards + (_cRows * _cWordsPerRow);
+        for (Uint16 r = 0; r < _cRows; r++)
+        {
+            for (Uint32 w = 0; w < _cWordsPerRow; w++)
+            {
+                Uint32 word = (r * _cWordsPerRow) + w;
+                Uint64 eaten = _pInitialBoards[word] & ~_pPellets[word];
+                while (eaten != 0)
+                {
+                    int bit = LowestBit(eaten);
+                    eaten &= eaten - 1;
+                    Uint16 tile = ((pInitialPower[word] >> bit) & 1) ? _powerTile : _pelletTile;
+                    pfnTileChanged(pContext, r, static_cast<Uint16>((w * 64) + bit), tile);
+                }
+            }
+        }
+    }
+
+    SDL_memcpy(_pBoards, _pInitialBoards, 2 * _cRows * _cWordsPerRow * sizeof(Uint64));
+    _cRemaining = _cTotal;
+}
@@ -0,0 +1,187 @@
+#include "include/profiler.h"
+
+#ifdef PMC_PROFILING
+#include <algorithm>
+#include <stdio.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+static const char * const ProfilePhaseNames[Profiler::c_cPhases] =
+{
+    "input", "update", "contacts", "pellets", "flowfields", "maprender", "spriterender", "batchflush", "present", "sleep"
+};
+
+// Overlay colors, one per phase
+static const SDL_Color ProfilePhaseColors[Profiler::c_cPhases] =
+{
+    { 0xFF, 0x40, 0x40, 0xFF }, { 0xFF, 0xA0, 0x00, 0xFF }, { 0xFF, 0xFF, 0x00, 0xFF }, { 0xFF, 0xFF, 0xA0, 0xFF },
+    { 0xC0, 0xFF, 0x00, 0xFF }, { 0x40, 0xFF, 0x40, 0xFF }, { 0x00, 0xFF, 0xFF, 0xFF }, { 0x40, 0x80, 0xFF, 0xFF },
+    { 0xC0, 0x40, 0xFF, 0xFF }, { 0xA0, 0xA0, 0xA0, 0xFF }
+};
+
+static const double c_msOverlayBudget = 1000.0 / 60.0;  // Full bar width is one 60Hz frame
+static const int c_cxOverlayBar = 200;
+static const int c_cyOverlayBar = 8;
+
+Profiler& Profiler::Instance()
+{
+    static Profiler s_profiler;
+    return s_profiler;
+}
+
+Profiler::Profiler() :
+    _frequency(SDL_GetPerformanceFrequency()),
+    _iFrame(0),
+    _cFrames(0),
+    _fRecording(SDL_FALSE),
+    _fOverlay(SDL_FALSE)
+{
+    SDL_memset(_samples, 0, sizeof(_samples));
+    SDL_memset(_totals, 0, sizeof(_totals));
+}
+
+void Profiler::BeginFrame()
+{
+    // Nothing was being recorded before the first frame (anything timed during startup landed in slot 0), so start
+    // it clean instead of counting it as a frame
+    if (_fRecording == SDL_FALSE)
+    {
+        for (Uint32 phase = 0; phase < c_cPhases; phase++)
+        {
+            _samples[phase][_iFrame] = 0;
+        }
+        _fRecording = SDL_TRUE;
+        return;
+    }
+
+    // One slot is always the frame in progress, so once c_cFrames - 1 frames are complete the slot we move into
+    // next holds the oldest one and it has to come out of the totals
+    bool fFull = (_cFrames == c_cFrames - 1);
+
+    // The frame we were recording is now complete, count it
+    for (Uint32 phase = 0; phase < c_cPhases; phase++)
+    {
+        _totals[phase] += _samples[phase][_iFrame];
+    }
+    if (!fFull)
+    {
+        _cFrames++;
+    }
+
+    _iFrame = (_iFrame + 1) % c_cFrames;
+    for (Uint32 phase = 0; phase < c_cPhases; phase++)
+    {
+        if (fFull)
+        {
+            _totals[phase] -= _samples[phase][_iFrame];
+        }
+        _samples[phase][_iFrame] = 0;
+    }
+}
+
+ProfilePhaseStats Profiler::GetStats(ProfilePhase phase)
+{
+    ProfilePhaseStats stats;
+    SDL_memset(&stats, 0, sizeof(ProfilePhaseStats));
+    stats.cSamples = _cFrames;
+
+    if (_cFrames > 0)
+    {
+        // Copy out the completed frames (newest first, order doesn't matter) and sort for the percentiles
+        Uint64 sorted[c_cFrames];
+        const Uint64 *pSamples = _samples[static_cast<Uint32>(phase)];
+        for (Uint32 i = 0; i < _cFrames; i++)
+        {
+            sorted[i] = pSamples[(_iFrame + c_cFrames - 1 - i) % c_cFrames];
+        }
+        std::sort(sorted, sorted + _cFrames);
+
+        // Nearest rank percentile
+        auto ToMs = [this](Uint64 counterTicks) -> double { return (counterTicks * 1000.0) / _frequency; };
+        auto Percentile = [&](Uint32 percent) -> double { return ToMs(sorted[((_cFrames - 1) * percent) / 100]); };
+
+        stats.msMin = ToMs(sorted[0]);
+        stats.msMax = ToMs(sorted[_cFrames - 1]);
+        stats.msMean = ToMs(_totals[static_cast<Uint32>(phase)]) / _cFrames;
+        stats.msP50 = Percentile(50);
+        stats.msP95 = Percentile(95);
+        stats.msP99 = Percentile(99);
+    }
+    return stats;
+}
+
+void Profiler::Report(const char *szCsvFileName)
+{
+    printf("Frame phase times over the last %u frames (ms)\n", _cFrames);
+    printf("%-14s %9s %9s %9s %9s %9s %9s\n", "phase", "min", "mean", "p50", "p95", "p99", "max");
+    for (Uint32 phase = 0; phase < c_cPhases; phase++)
+    {
+        ProfilePhaseStats stats = GetStats(static_cast<ProfilePhase>(phase));
+        printf("%-14s %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f\n", ProfilePhaseNames[phase],
+            stats.msMin, stats.msMean, stats.msP50, stats.msP95, stats.msP99, stats.msMax);
+    }
+
+    // Raw samples, oldest frame first, one column per phase
+    FILE *pFile = fopen(szCsvFileName, "w");
+    if (pFile == nullptr)
+    {
+        printf("Profiler::Report() : failed to open %s\n", szCsvFileName);
+        return;
+    }
+
+    fprintf(pFile, "frame");
+    for (Uint32 phase = 0; phase < c_cPhases; phase++)
+    {
+        fprintf(pFile, ",%s_ms", ProfilePhaseNames[phase]);
+    }
+    fprintf(pFile, "\n");
+
+    for (Uint32 i = 0; i < _cFrames; i++)
+    {
+        Uint32 iSlot = (_iFrame + c_cFrames - _cFrames + i) % c_cFrames;
+        fprintf(pFile, "%u", i);
+        for (Uint32 phase = 0; phase < c_cPhases; phase++)
+        {
+            fprintf(pFile, ",%.4f", (_samples[phase][iSlot] * 1000.0) / _frequency);
+        }
+        fprintf(pFile, "\n");
+    }
+    fclose(pFile);
+    printf("Wrote %u frames to %s\n", _cFrames, szCsvFileName);
+}
+
+void Profiler::RenderOverlay(SDL_Renderer *pSDLRenderer)
+{
+    if ((_fOverlay == SDL_FALSE) || (_cFrames == 0))
+    {
+        return;
+    }
+
+    // Don't disturb the clear color
+    Uint8 r, g, b, a;
+    SDL_GetRenderDrawColor(pSDLRenderer, &r, &g, &b, &a);
+
+    SDL_Rect backgroundRect = { 4, 4, c_cxOverlayBar + 8, static_cast<int>(c_cPhases) * (c_cyOverlayBar + 4) + 4 };
+    SDL_SetRenderDrawColor(pSDLRenderer, 0, 0, 0, 0xFF);
+    SDL_RenderFillRect(pSDLRenderer, &backgroundRect);
+
+    Uint32 iLastFrame = (_iFrame + c_cFrames - 1) % c_cFrames;
+    for (Uint32 phase = 0; phase < c_cPhases; phase++)
+    {
+        double msLast = (_samples[phase][iLastFrame] * 1000.0) / _frequency;
+        double msMean = ((_totals[phase] * 1000.0) / _frequency) / _cFrames;
+        int y = 8 + phase * (c_cyOverlayBar + 4);
+
+        SDL_Rect barRect = { 8, y, static_cast<int>(SDL_min(msLast / c_msOverlayBudget, 1.0) * c_cxOverlayBar), c_cyOverlayBar };
+        SDL_Rect meanRect = { 8 + static_cast<int>(SDL_min(msMean / c_msOverlayBudget, 1.0) * c_cxOverlayBar), y - 1, 2, c_cyOverlayBar + 2 };
+
+        const SDL_Color &color = ProfilePhaseColors[phase];
+        SDL_SetRenderDrawColor(pSDLRenderer, color.r, color.g, color.b, color.a);
+        SDL_RenderFillRect(pSDLRenderer, &barRect);
+        SDL_SetRenderDrawColor(pSDLRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
+        SDL_RenderFillRect(pSDLRenderer, &meanRect);
+    }
+
+    SDL_SetRenderDrawColor(pSDLRenderer, r, g, b, a);
+}
+#endif
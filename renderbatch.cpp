@@ -0,0 +1,165 @@
+#include "include/renderbatch.h"
+#include <algorithm>
+#include <stdio.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+RenderBatch::RenderBatch(SDL_Renderer *pSDLRenderer, Uint32 cMaxQuads) :
+    _pSDLRenderer(pSDLRenderer),
+    _cMaxQuads(cMaxQuads),
+    _cQuads(0),
+    _pQuads(nullptr),
+    _pVertices(nullptr),
+    _pIndices(nullptr),
+    _cTextureSlots(0),
+    _pLastTexture(nullptr),
+    _viewOrigin({ 0, 0 })
+{
+    SDL_memset(&_stats, 0, sizeof(RenderBatchStats));
+    SDL_memset(_textureSlots, 0, sizeof(_textureSlots));
+
+    _pQuads = new Quad[_cMaxQuads];
+    _pVertices = new SDL_Vertex[_cMaxQuads * 4];
+    _pIndices = new int[_cMaxQuads * 6];
+
+    // Every quad is two triangles over its 4 vertices, and since each run is drawn starting from its first
+    // vertex the index pattern is the same for every run
+    for (Uint32 i = 0; i < _cMaxQuads; i++)
+    {
+        int v = i * 4;
+        _pIndices[i * 6 + 0] = v + 0;
+        _pIndices[i * 6 + 1] = v + 1;
+        _pIndices[i * 6 + 2] = v + 2;
+        _pIndices[i * 6 + 3] = v + 2;
+        _pIndices[i * 6 + 4] = v + 3;
+        _pIndices[i * 6 + 5] = v + 0;
+    }
+}
+
+RenderBatch::~RenderBatch()
+{
+    delete[] _pIndices;
+    delete[] _pVertices;
+    delete[] _pQuads;
+}
+
+void RenderBatch::Begin()
+{
+    SDL_memset(&_stats, 0, sizeof(RenderBatchStats));
+    _pLastTexture = nullptr;
+}
+
+void RenderBatch::AddQuad(SDL_Texture *pTexture, const SDL_Rect &srcRect, const SDL_Rect &dstRect, Uint16 layer)
+{
+    // Out of room (quads or textures), draw what we have so far and start over
+    if ((_cQuads == _cMaxQuads) || ((_cTextureSlots == c_maxTextureSlots) && (FindTextureSlot(pTexture) == c_maxTextureSlots)))
+    {
+        Flush();
+    }
+
+    Uint16 slot = FindTextureSlot(pTexture);
+    if (slot == c_maxTextureSlots)
+    {
+        slot = _cTextureSlots++;
+        int cxTexture = 0;
+        int cyTexture = 0;
+        SDL_QueryTexture(pTexture, nullptr, nullptr, &cxTexture, &cyTexture);
+        _textureSlots[slot].pTexture = pTexture;
+        _textureSlots[slot].cxTexture = static_cast<float>(cxTexture);
+        _textureSlots[slot].cyTexture = static_cast<float>(cyTexture);
+    }
+
+    Quad &quad = _pQuads[_cQuads];
+    quad.sortKey = (static_cast<Uint64>(layer) << 48) | (static_cast<Uint64>(slot) << 32) | _cQuads;
+    quad.srcRect = srcRect;
+    quad.dstRect = dstRect;
+    quad.dstRect.x -= _viewOrigin.x;
+    quad.dstRect.y -= _viewOrigin.y;
+    _cQuads++;
+    _stats.cQuads++;
+}
+
+void RenderBatch::Flush()
+{
+    if (_cQuads > 0)
+    {
+        std::sort(_pQuads, _pQuads + _cQuads, [](const Quad &a, const Quad &b) { return a.sortKey < b.sortKey; });
+
+        // Walk the sorted list and draw each run of quads that share a texture.  A run can carry on into the next
+        // layer (e.g. map tiles and sprites on the same atlas page), the sort already put them in layer order
+        Uint32 iFirst = 0;
+        for (Uint32 i = 1; i <= _cQuads; i++)
+        {
+            if ((i == _cQuads) || (((_pQuads[i].sortKey >> 32) & 0xFFFF) != ((_pQuads[iFirst].sortKey >> 32) & 0xFFFF)))
+            {
+                DrawRun(iFirst, i);
+                iFirst = i;
+            }
+        }
+    }
+
+    _cQuads = 0;
+    _cTextureSlots = 0;
+}
+
+Uint16 RenderBatch::FindTextureSlot(SDL_Texture *pTexture)
+{
+    for (Uint16 i = 0; i < _cTextureSlots; i++)
+    {
+        if (_textureSlots[i].pTexture == pTexture)
+        {
+            return i;
+        }
+    }
+    return c_maxTextureSlots;
+}
+
+// Draw the quads in [iFirst, iEnd), all of which use the same texture
+void RenderBatch::DrawRun(Uint32 iFirst, Uint32 iEnd)
+{
+    const TextureSlot &slot = _textureSlots[(_pQuads[iFirst].sortKey >> 32) & 0xFFFF];
+    if (slot.pTexture != _pLastTexture)
+    {
+        _stats.cTextureSwitches++;
+        _pLastTexture = slot.pTexture;
+    }
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    const SDL_Color white = { 255, 255, 255, 255 };
+    SDL_Vertex *pVertex = &_pVertices[iFirst * 4];
+    for (Uint32 i = iFirst; i < iEnd; i++)
+    {
+        const Quad &quad = _pQuads[i];
+        float x0 = static_cast<float>(quad.dstRect.x);
+        float y0 = static_cast<float>(quad.dstRect.y);
+        float x1 = static_cast<float>(quad.dstRect.x + quad.dstRect.w);
+        float y1 = static_cast<float>(quad.dstRect.y + quad.dstRect.h);
+        float u0 = quad.srcRect.x / slot.cxTexture;
+        float v0 = quad.srcRect.y / slot.cyTexture;
+        float u1 = (quad.srcRect.x + quad.srcRect.w) / slot.cxTexture;
+        float v1 = (quad.srcRect.y + quad.srcRect.h) / slot.cyTexture;
+
+        // Clockwise from the top left
+        pVertex[0] = { { x0, y0 }, white, { u0, v0 } };
+        pVertex[1] = { { x1, y0 }, white, { u1, v0 } };
+        pVertex[2] = { { x1, y1 }, white, { u1, v1 } };
+        pVertex[3] = { { x0, y1 }, white, { u0, v1 } };
+        pVertex += 4;
+    }
+
+    Uint32 cQuadsInRun = iEnd - iFirst;
+    if (SDL_RenderGeometry(_pSDLRenderer, slot.pTexture, &_pVertices[iFirst * 4], cQuadsInRun * 4, _pIndices, cQuadsInRun * 6) != 0)
+    {
+        printf("SDL_RenderGeometry() failed, error = %s\n", SDL_GetError());
+    }
+    _stats.cBatches++;
+#else
+    // No geometry API before SDL 2.0.18, the sorting still groups textures together so we at least avoid
+    // switching back and forth
+    for (Uint32 i = iFirst; i < iEnd; i++)
+    {
+        SDL_RenderCopy(_pSDLRenderer, slot.pTexture, &_pQuads[i].srcRect, &_pQuads[i].dstRect);
+        _stats.cBatches++;
+    }
+#endif
+}
@@ -0,0 +1,133 @@
+#include "include/rendersnapshot.h"
+#include <stdio.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+RenderSnapshotBuffer::RenderSnapshotBuffer(Uint32 cMaxSprites, Uint32 cMaxTiles) :
+    _iBack(0),
+    _iFront(2),
+    _fHaveFront(false),
+    _cMaxSprites(cMaxSprites),
+    _cMaxTiles(cMaxTiles),
+    _pPendingTiles(nullptr),
+    _cPendingTiles(0),
+    _nextTileSequence(1),
+    _appliedTileSequence(0),
+    _cPresented(0),
+    _cDuplicated(0),
+    _ageCountersTotal(0),
+    _ageCountersMax(0)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        SDL_memset(&_snapshots[i], 0, sizeof(RenderSnapshot));
+        _snapshots[i].pSprites = new SnapshotSprite[_cMaxSprites];
+        _snapshots[i].pTiles = new SnapshotTile[_cMaxTiles];
+    }
+    _pPendingTiles = new SnapshotTile[_cMaxTiles];
+    SDL_AtomicSet(&_middle, 1);
+    SDL_AtomicSet(&_acknowledgedTileSequence, 0);
+    SDL_AtomicSet(&_cPublished, 0);
+    SDL_AtomicSet(&_cDropped, 0);
+}
+
+RenderSnapshotBuffer::~RenderSnapshotBuffer()
+{
+    for (int i = 0; i < 3; i++)
+    {
+        delete[] _snapshots[i].pSprites;
+        delete[] _snapshots[i].pTiles;
+    }
+    delete[] _pPendingTiles;
+}
+
+void RenderSnapshotBuffer::QueueTileChange(Uint16 row, Uint16 col, Uint16 index)
+{
+    if (_cPendingTiles == _cMaxTiles)
+    {
+        // The renderer hasn't acknowledged anything in a long time, the map will be out of date
+        printf("RenderSnapshotBuffer::QueueTileChange() : more than %u tile changes pending, [%u][%u] dropped\n", _cMaxTiles, row, col);
+        return;
+    }
+    _pPendingTiles[_cPendingTiles++] = { _nextTileSequence++, row, col, index };
+}
+
+void RenderSnapshotBuffer::Publish()
+{
+    RenderSnapshot &snapshot = _snapshots[_iBack];
+
+    // Stop sending what the renderer has applied, everything else goes (again)
+    Uint32 acknowledged = static_cast<Uint32>(SDL_AtomicGet(&_acknowledgedTileSequence));
+    Uint32 cApplied = 0;
+    while ((cApplied < _cPendingTiles) && (static_cast<Sint32>(_pPendingTiles[cApplied].sequence - acknowledged) <= 0))
+    {
+        cApplied++;
+    }
+    _cPendingTiles -= cApplied;
+    if ((cApplied > 0) && (_cPendingTiles > 0))
+    {
+        SDL_memmove(_pPendingTiles, &_pPendingTiles[cApplied], _cPendingTiles * sizeof(SnapshotTile));
+    }
+    SDL_memcpy(snapshot.pTiles, _pPendingTiles, _cPendingTiles * sizeof(SnapshotTile));
+    snapshot.cTiles = _cPendingTiles;
+    snapshot.publishCounter = SDL_GetPerformanceCounter();
+
+    // Everything written above has to be visible before the renderer can see the index
+    SDL_MemoryBarrierRelease();
+    int previous = SDL_AtomicSet(&_middle, _iBack | c_fresh);
+    SDL_MemoryBarrierAcquire();
+    if (previous & c_fresh)
+    {
+        SDL_AtomicIncRef(&_cDropped);
+    }
+    _iBack = previous & c_indexMask;
+    SDL_AtomicIncRef(&_cPublished);
+}
+
+const RenderSnapshot *RenderSnapshotBuffer::AcquireLatest(bool &fNew)
+{
+    fNew = false;
+    if (SDL_AtomicGet(&_middle) & c_fresh)
+    {
+        // Only the simulation sets c_fresh, so it's still there (maybe with an even newer index) and swapping our
+        // front buffer in clears it
+        SDL_MemoryBarrierRelease();
+        int previous = SDL_AtomicSet(&_middle, _iFront);
+        SDL_MemoryBarrierAcquire();
+        _iFront = previous & c_indexMask;
+        _fHaveFront = true;
+        fNew = true;
+    }
+    return _fHaveFront ? &_snapshots[_iFront] : nullptr;
+}
+
+void RenderSnapshotBuffer::AcknowledgeTiles(const RenderSnapshot *pSnapshot)
+{
+    if (pSnapshot->cTiles > 0)
+    {
+        _appliedTileSequence = pSnapshot->pTiles[pSnapshot->cTiles - 1].sequence;
+        SDL_AtomicSet(&_acknowledgedTileSequence, static_cast<int>(_appliedTileSequence));
+    }
+}
+
+void RenderSnapshotBuffer::NotePresented(const RenderSnapshot *pSnapshot, bool fNew)
+{
+    Uint64 ageCounters = SDL_GetPerformanceCounter() - pSnapshot->publishCounter;
+    _cPresented++;
+    _cDuplicated += fNew ? 0 : 1;
+    _ageCountersTotal += ageCounters;
+    _ageCountersMax = SDL_max(_ageCountersMax, ageCounters);
+}
+
+RenderSnapshotStats RenderSnapshotBuffer::Stats()
+{
+    double msPerCounter = 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+    RenderSnapshotStats stats;
+    stats.cPublished = static_cast<Uint32>(SDL_AtomicGet(&_cPublished));
+    stats.cDropped = static_cast<Uint32>(SDL_AtomicGet(&_cDropped));
+    stats.cPresented = _cPresented;
+    stats.cDuplicated = _cDuplicated;
+    stats.msAgeMean = (_cPresented > 0) ? (_ageCountersTotal * msPerCounter) / _cPresented : 0.0;
+    stats.msAgeMax = _ageCountersMax * msPerCounter;
+    return stats;
+}
@@ -0,0 +1,37 @@
+#include "include/scriptedinput.h"
+#include "include/inputrecording.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+// Only directions are scripted, never ESC (quit) or X (death)
+static const Uint32 c_cScriptedButtons = 4;
+static const Uint32 c_maxHoldTicks = 90;
+
+ScriptedInput::ScriptedInput(Uint32 seed) :
+    _state((seed == 0) ? 1 : seed), // xorshift gets stuck on 0
+    _cTicksRemaining(0),
+    _currentButton(0)
+{
+}
+
+Uint8 ScriptedInput::NextButtons()
+{
+    Uint8 buttons = 0;
+    if (_cTicksRemaining == 0)
+    {
+        // Let go of the old direction, press a new one and pick how long to hold it
+        _currentButton = static_cast<Uint8>(NextRandom() % c_cScriptedButtons);
+        _cTicksRemaining = 1 + (NextRandom() % c_maxHoldTicks);
+        buttons = 1 << InputButtonFreshDirection;
+    }
+    _cTicksRemaining--;
+    return buttons | static_cast<Uint8>(1 << _currentButton);
+}
+
+Uint32 ScriptedInput::NextRandom()
+{
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return _state;
+}
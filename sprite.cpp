@@ -3,155 +3,97 @@
 
 using namespace XplatGameTutorial::PacManClone;
 
-Sprite::Sprite(TextureWrapper *pTextureWrapper, Uint16 cxFrame, Uint16 cyFrame, Uint16 cFramesTotal, Uint16 cAnimationsTotal) :
-    _x(0.0),
-    _y(0.0),
-    _dx(0.0),
-    _dy(0.0),
-    _cFramesTotal(cFramesTotal),
-    _pFrames(nullptr),
-    _cxFrame(cxFrame),
-    _cyFrame(cyFrame),
-    _cxFrameOffset(0),
-    _cyFrameOffset(0),
-    _currentAnimationIndex(0),
-    _cAnimationsTotal(cAnimationsTotal),
-    _staticFrameIndex(0),
-    _fVisible(SDL_TRUE),
-    _pTextureWrapper(pTextureWrapper),
-    _ppSpriteAnimations(nullptr)
+Sprite::Sprite(EntityStore *pEntityStore, TextureWrapper *pTextureWrapper, Uint16 cxFrame, Uint16 cyFrame, Uint16 cFramesTotal, Uint16 cAnimationsTotal) :
+    _pEntityStore(pEntityStore),
+    _sheet(pEntityStore->CreateSheet(pTextureWrapper, cxFrame, cyFrame, cFramesTotal, cAnimationsTotal)),
+    _handle(pEntityStore->Create(_sheet))
 {
+    // Create turns down InvalidSheet, which is what a store out of sheets hands back
+    SDL_assert(_handle != InvalidEntityHandle);
 }
 
-Sprite::~Sprite()
+Sprite::Sprite(EntityStore *pEntityStore, Uint16 sheet) :
+    _pEntityStore(pEntityStore),
+    _sheet(sheet),
+    _handle(pEntityStore->Create(sheet))
 {
-    // Delete all loaded animations
-    for (int i = 0; i < _cAnimationsTotal; i++)
-    {
-        delete _ppSpriteAnimations[i];
-        _ppSpriteAnimations[i] = nullptr;
-    }
-    // Delete the array holding those animations
-    delete[] _ppSpriteAnimations;
+    SDL_assert(_handle != InvalidEntityHandle);
+}
 
-    // Delete allocated frame rects
-    delete[] _pFrames;
+Sprite::~Sprite()
+{
+    // The sheet (frames and animations) stays with the store, other sprites may be using it
+    _pEntityStore->Destroy(_handle);
 }
 
 // Loads a single frame at the given coordinates on the texture to the specifed index
 bool Sprite::LoadFrame(Uint16 frameIndex, Uint16 xTexture, Uint16 yTexture)
 {
-    // We've made several assumption in the implementation, so validate them
-    SDL_assert((_pTextureWrapper != nullptr) && (!_pTextureWrapper->IsNull()));
-    SDL_assert(_cxFrame > 0);
-    SDL_assert(_cyFrame > 0);
-    SDL_assert(_cFramesTotal > 0);
-
-    bool fResult = true;
-
-    // Index bounds check
-    if (frameIndex >= _cFramesTotal)
-    {
-        printf("Sprite::LoadFrame() : frame index out of range\n");
-        fResult = false;
-    }
-
-    // Texture bounds check
-    if ((xTexture + _cxFrame > _pTextureWrapper->Width()) ||
-        (yTexture + _cyFrame > _pTextureWrapper->Height()))
-    {
-        printf("Sprite::LoadFrame() : frame bounds out of range {x:%d y:%d w:%d h:%d}\n", 
-            xTexture, yTexture, _pTextureWrapper->Width(), _pTextureWrapper->Height());
-        fResult = false;
-    }
-
-    if (fResult)
-    {
-        // On first frame load, allocate the frames
-        if (_pFrames == nullptr)
-        {
-            // If this fails we're OOM and in for crashes anyway....
-            _pFrames = new SDL_Rect[_cFramesTotal]{ {0,0,0,0} };
-        }
-
-        _pFrames[frameIndex].x = xTexture;
-        _pFrames[frameIndex].y = yTexture;
-        _pFrames[frameIndex].w = _cxFrame; // Every frame in the sprite is the same size
-        _pFrames[frameIndex].h = _cyFrame;
-    }
-    return fResult;
+    return _pEntityStore->LoadFrame(_sheet, frameIndex, xTexture, yTexture);
 }
 
 // Load a series of frames assumed to be in horizontal order starting at the given index/coord
 // This takes advantage of how I know the sprite textures are laid out (which is not uncommon)
 bool Sprite::LoadFrames(Uint16 frameIndexStart, Uint16 xTextureStart, Uint16 yTextureStart, Uint16 framesToLoad)
 {
+    if (_sheet == InvalidSheet)
+    {
+        return false;
+    }
+
     bool fResult = true;
     Uint16 x = xTextureStart;
     Uint16 y = yTextureStart;
+    Uint16 cxFrame = _pEntityStore->Sheet(_sheet).cxFrame;
 
     for (Uint16 index = frameIndexStart; (index < (frameIndexStart + framesToLoad)) && fResult; index++)
     {
         fResult |= LoadFrame(index, x, y);
-        x += _cxFrame;
+        x += cxFrame;
     }
     return fResult;
 }
 
-//  Store the given animation sequence at the specified index.  This is mostly delegated to the SpriteAnimation helper class
-void Sprite::LoadAnimationSequence(Uint16 index, AnimationType animationType, int* pSequence, Uint16 cFramesInSequence, Uint16 animationSpeed)
+//  Store the given animation sequence at the specified index.  The clip itself lives in the store's AnimationLibrary
+void Sprite::LoadAnimationSequence(Uint16 index, AnimationType animationType, const int* pSequence, Uint16 cFramesInSequence, Uint16 animationSpeed)
 {
-    // First time allocate the space for the animation helpers
-    if (_ppSpriteAnimations == nullptr)
-    {
-        _ppSpriteAnimations = new SpriteAnimation*[_cAnimationsTotal];
-        SDL_memset(_ppSpriteAnimations, 0, sizeof(SpriteAnimation*) * _cAnimationsTotal);
-    }
-
-    // Creates a new helper for the animation and stores it
-    SpriteAnimation* pAnimation = new SpriteAnimation(cFramesInSequence, pSequence, animationType, animationSpeed);
-    _ppSpriteAnimations[index] = pAnimation;
+    _pEntityStore->LoadAnimationSequence(_sheet, index, animationType, pSequence, cFramesInSequence, animationSpeed);
 }
 
 void Sprite::ResetAnimation()
 {
     // Delegate to helper
-    _ppSpriteAnimations[_currentAnimationIndex]->Reset();
+    _pEntityStore->ResetAnimation(Index());
 }
 
 void Sprite::SetAnimation(Uint16 index)
 {
-    // If this isn't already the current animation
-    // Because if it is, you wanted ResetAnimation()
-    if (_currentAnimationIndex != index)
-    {
-        // Store it and reset the sequence
-        _currentAnimationIndex = index;
-        _ppSpriteAnimations[_currentAnimationIndex]->Reset();
-    }
+    _pEntityStore->SetAnimation(Index(), index);
 }
 
 // Store a new velocity
-void Sprite::SetVelocity(double dx, double dy)
+void Sprite::SetVelocity(Fixed dx, Fixed dy)
 {
-    _dx = dx;
-    _dy = dy;
+    Uint32 index = Index();
+    _pEntityStore->DX()[index] = dx;
+    _pEntityStore->DY()[index] = dy;
 }
 
 // Manually set a position, normal play position is Update()d but we also
 // need the ability to place it directly
-void Sprite::ResetPosition(double x, double y)
+void Sprite::ResetPosition(Fixed x, Fixed y)
 {
-    _x = x;
-    _y = y;
+    Uint32 index = Index();
+    _pEntityStore->X()[index] = x;
+    _pEntityStore->Y()[index] = y;
+    _pEntityStore->XPrevious()[index] = x;
+    _pEntityStore->YPrevious()[index] = y;
 }
 
 // Manually set frame index for non-animated sprites
 void Sprite::SetFrame(Uint16 frameIndex)
 {
-    // We're assuming this sprite has no animations, so assert it
-    SDL_assert(_ppSpriteAnimations == nullptr);
-    _staticFrameIndex = frameIndex;
+    _pEntityStore->SetStaticFrame(Index(), frameIndex);
 }
 
 // Set the offset of the 2D image rect from the X,Y location 
@@ -165,41 +107,38 @@ void Sprite::SetFrame(Uint16 frameIndex)
 //
 void Sprite::SetFrameOffset(int xOffset, int yOffset)
 {
-    _cxFrameOffset = xOffset;
-    _cyFrameOffset = yOffset;
+    Uint32 index = Index();
+    _pEntityStore->FrameOffsetsX()[index] = static_cast<Sint16>(xOffset);
+    _pEntityStore->FrameOffsetsY()[index] = static_cast<Sint16>(yOffset);
 }
 
 // Turn on/off sprite
 void Sprite::SetVisible(SDL_bool visible)
 {
-    _fVisible = visible;
+    _pEntityStore->Visible()[Index()] = visible;
 }
 
-// set new positio based on velocity and update the current animation
-void Sprite::Update()
+void Sprite::SetLayer(Uint16 layer)
 {
-    _x += _dx;
-    _y += _dy;
+    _pEntityStore->Layers()[Index()] = layer;
+}
+
+void Sprite::SetWallCollision(SDL_bool fWallCollision)
+{
+    _pEntityStore->WallCollision()[Index()] = fWallCollision;
+}
 
-    // Advance animation counters and if needed the frame
-    _ppSpriteAnimations[_currentAnimationIndex]->Update();
+// set new positio based on velocity
+void Sprite::Update()
+{
+    _pEntityStore->Update(Index());
 }
 
 // Very similar to the tilemap, only in this case, we're index the frame
 // to draw based on the current animation state (or static frame) instead
-// on a static indexed map of tiles
-void Sprite::Render(SDL_Renderer *pSDLRenderer)
+// on a static indexed map of tiles.  Sprites sharing a sheet and layer end
+// up in the same batch
+void Sprite::Render(RenderBatch *pRenderBatch, Uint16 layer, double alpha)
 {
-    if (_fVisible == SDL_TRUE)
-    {
-        // Find the index to the current frame in the current animation and draw it to the renderer
-        // at the correct x,y delta offset
-        Uint16 frameIndex = (_ppSpriteAnimations == nullptr) ? _staticFrameIndex : _ppSpriteAnimations[_currentAnimationIndex]->CurrentFrame();
-        SDL_Rect targetRect{ static_cast<int>(_x) + _cxFrameOffset, static_cast<int>(_y) + _cyFrameOffset, _cxFrame, _cyFrame };
-        SDL_RenderCopy(
-            pSDLRenderer,
-            _pTextureWrapper->Ptr(),
-            &_pFrames[frameIndex],
-            &targetRect);
-    }
+    _pEntityStore->Render(Index(), pRenderBatch, layer, alpha);
 }
@@ -0,0 +1,302 @@
+#include "include/textureatlas.h"
+#include <algorithm>
+#include <stdio.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+// Bump when the cache file layout changes
+static const int c_atlasCacheVersion = 1;
+
+TextureAtlas::TextureAtlas(int cxMaxPage, int cyMaxPage) :
+    _cxMaxPage(cxMaxPage),
+    _cyMaxPage(cyMaxPage),
+    _pImages(nullptr),
+    _cImages(0),
+    _pcxPages(nullptr),
+    _pcyPages(nullptr),
+    _ppPages(nullptr),
+    _cPages(0),
+    _fFromCache(false)
+{
+    _pImages = new AtlasImage[c_maxImages]{};
+    // Worst case every image is on a page of its own
+    _pcxPages = new int[c_maxImages]{};
+    _pcyPages = new int[c_maxImages]{};
+    _ppPages = new TextureWrapper*[c_maxImages]{};
+}
+
+TextureAtlas::~TextureAtlas()
+{
+    for (int i = 0; i < _cImages; i++)
+    {
+        delete[] _pImages[i].pszFileName;
+        if (_pImages[i].pSurface != nullptr)
+        {
+            SDL_FreeSurface(_pImages[i].pSurface);
+        }
+    }
+    for (int i = 0; i < _cPages; i++)
+    {
+        delete _ppPages[i];
+    }
+    delete[] _ppPages;
+    delete[] _pcyPages;
+    delete[] _pcxPages;
+    delete[] _pImages;
+}
+
+int TextureAtlas::AddImage(const char *szFileName, SDL_Color *pSdlTransparencyColorKey)
+{
+    if (_cImages == c_maxImages)
+    {
+        printf("TextureAtlas::AddImage() : too many images, max is %d\n", c_maxImages);
+        return -1;
+    }
+
+    printf("Attempting to load image %s...\n", szFileName);
+    SDL_Surface *pSurface = LoadSurface(szFileName, pSdlTransparencyColorKey);
+    if (pSurface == nullptr)
+    {
+        return -1;
+    }
+    printf("loaded %s { w:%d, h:%d }\n", szFileName, pSurface->w, pSurface->h);
+    return AddSurface(szFileName, pSurface);
+}
+
+int TextureAtlas::AddSurface(const char *szFileName, SDL_Surface *pSurface)
+{
+    if (_cImages == c_maxImages)
+    {
+        printf("TextureAtlas::AddSurface() : too many images, max is %d\n", c_maxImages);
+        SDL_FreeSurface(pSurface);
+        return -1;
+    }
+    SDL_assert(pSurface->format->format == SDL_PIXELFORMAT_ARGB8888);
+
+    AtlasImage &image = _pImages[_cImages];
+    size_t cchFileName = SDL_strlen(szFileName) + 1;
+    image.pszFileName = new char[cchFileName];
+    SDL_memcpy(image.pszFileName, szFileName, cchFileName);
+    image.pSurface = pSurface;
+    image.page = 0;
+    image.rect = { 0, 0, pSurface->w, pSurface->h };
+    return _cImages++;
+}
+
+bool TextureAtlas::Build(SDL_Renderer *pSDLRenderer, const char *szCacheFileName)
+{
+    // Respect the renderer's texture size limit (0 means it didn't tell us)
+    SDL_RendererInfo rendererInfo;
+    if (SDL_GetRendererInfo(pSDLRenderer, &rendererInfo) == 0)
+    {
+        if (rendererInfo.max_texture_width > 0)
+        {
+            _cxMaxPage = SDL_min(_cxMaxPage, rendererInfo.max_texture_width);
+        }
+        if (rendererInfo.max_texture_height > 0)
+        {
+            _cyMaxPage = SDL_min(_cyMaxPage, rendererInfo.max_texture_height);
+        }
+    }
+
+    _fFromCache = (szCacheFileName != nullptr) && LoadLayout(szCacheFileName);
+    if (!_fFromCache)
+    {
+        if (!Pack())
+        {
+            return false;
+        }
+        if (szCacheFileName != nullptr)
+        {
+            SaveLayout(szCacheFileName);
+        }
+    }
+
+    printf("Atlas: %d images on %d page(s)%s\n", _cImages, _cPages, _fFromCache ? " (cached layout)" : "");
+    return CreatePages(pSDLRenderer);
+}
+
+// Simple shelf packing: sort by height, fill a row (shelf) left to right, start a new shelf when the row is full
+// and a new page when the shelves are.  We only have a handful of images, so this is plenty
+bool TextureAtlas::Pack()
+{
+    int order[c_maxImages];
+    for (int i = 0; i < _cImages; i++)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order, order + _cImages, [this](int a, int b) { return _pImages[a].pSurface->h > _pImages[b].pSurface->h; });
+
+    _cPages = 0;
+    int xShelf = 0;
+    int yShelf = 0;
+    int cyShelf = 0;
+    for (int i = 0; i < _cImages; i++)
+    {
+        AtlasImage &image = _pImages[order[i]];
+        int cx = image.pSurface->w;
+        int cy = image.pSurface->h;
+        if ((cx > _cxMaxPage) || (cy > _cyMaxPage))
+        {
+            printf("TextureAtlas::Pack() : %s { w:%d, h:%d } is bigger than a page { w:%d, h:%d }\n", image.pszFileName, cx, cy, _cxMaxPage, _cyMaxPage);
+            return false;
+        }
+
+        // Next shelf if it doesn't fit on this one, next page if it doesn't fit under the shelf either
+        if ((_cPages > 0) && (xShelf + cx > _cxMaxPage))
+        {
+            xShelf = 0;
+            yShelf += cyShelf + c_padding;
+            cyShelf = 0;
+        }
+        if ((_cPages == 0) || (yShelf + cy > _cyMaxPage))
+        {
+            _cPages++;
+            _pcxPages[_cPages - 1] = 0;
+            _pcyPages[_cPages - 1] = 0;
+            xShelf = 0;
+            yShelf = 0;
+            cyShelf = 0;
+        }
+
+        image.page = _cPages - 1;
+        image.rect = { xShelf, yShelf, cx, cy };
+        xShelf += cx + c_padding;
+        cyShelf = SDL_max(cyShelf, cy);
+        _pcxPages[image.page] = SDL_max(_pcxPages[image.page], image.rect.x + cx);
+        _pcyPages[image.page] = SDL_max(_pcyPages[image.page], image.rect.y + cy);
+    }
+    return true;
+}
+
+// The cache is a small text file, it is only used if it was made for the same images (names and sizes, in
+// order) and page limit, otherwise we pack again and overwrite it
+bool TextureAtlas::LoadLayout(const char *szCacheFileName)
+{
+    FILE *pFile = fopen(szCacheFileName, "r");
+    if (pFile == nullptr)
+    {
+        return false;
+    }
+
+    bool fResult = true;
+    int version = 0;
+    int cxMaxPage = 0;
+    int cyMaxPage = 0;
+    int cImages = 0;
+    int cPages = 0;
+    if ((fscanf(pFile, "pmc-atlas %d %d %d %d %d", &version, &cxMaxPage, &cyMaxPage, &cImages, &cPages) != 5) ||
+        (version != c_atlasCacheVersion) || (cxMaxPage != _cxMaxPage) || (cyMaxPage != _cyMaxPage) ||
+        (cImages != _cImages) || (cPages < 1) || (cPages > _cImages))
+    {
+        fResult = false;
+    }
+
+    for (int i = 0; fResult && (i < cPages); i++)
+    {
+        fResult = (fscanf(pFile, " page %d %d", &_pcxPages[i], &_pcyPages[i]) == 2);
+    }
+
+    for (int i = 0; fResult && (i < cImages); i++)
+    {
+        char szFileName[260];
+        int cx = 0;
+        int cy = 0;
+        int page = 0;
+        SDL_Rect rect = { 0, 0, 0, 0 };
+        AtlasImage &image = _pImages[i];
+        fResult = (fscanf(pFile, " image %259s %d %d %d %d %d", szFileName, &cx, &cy, &page, &rect.x, &rect.y) == 6) &&
+            (SDL_strcmp(szFileName, image.pszFileName) == 0) && (cx == image.pSurface->w) && (cy == image.pSurface->h) &&
+            (page >= 0) && (page < cPages) && (rect.x >= 0) && (rect.y >= 0) &&
+            (rect.x + cx <= _pcxPages[page]) && (rect.y + cy <= _pcyPages[page]);
+        if (fResult)
+        {
+            image.page = page;
+            image.rect = { rect.x, rect.y, cx, cy };
+        }
+    }
+
+    fclose(pFile);
+    _cPages = fResult ? cPages : 0;
+    return fResult;
+}
+
+bool TextureAtlas::SaveLayout(const char *szCacheFileName)
+{
+    FILE *pFile = fopen(szCacheFileName, "w");
+    if (pFile == nullptr)
+    {
+        printf("TextureAtlas::SaveLayout() : unable to open %s\n", szCacheFileName);
+        return false;
+    }
+
+    fprintf(pFile, "pmc-atlas %d %d %d %d %d\n", c_atlasCacheVersion, _cxMaxPage, _cyMaxPage, _cImages, _cPages);
+    for (int i = 0; i < _cPages; i++)
+    {
+        fprintf(pFile, "page %d %d\n", _pcxPages[i], _pcyPages[i]);
+    }
+    for (int i = 0; i < _cImages; i++)
+    {
+        const AtlasImage &image = _pImages[i];
+        fprintf(pFile, "image %s %d %d %d %d %d\n", image.pszFileName, image.rect.w, image.rect.h, image.page, image.rect.x, image.rect.y);
+    }
+    fclose(pFile);
+    return true;
+}
+
+// Copy each image onto its page surface, then turn the pages into textures.  The decoded images aren't needed
+// after this
+bool TextureAtlas::CreatePages(SDL_Renderer *pSDLRenderer)
+{
+    int bpp = 0;
+    Uint32 rMask = 0;
+    Uint32 gMask = 0;
+    Uint32 bMask = 0;
+    Uint32 aMask = 0;
+    SDL_PixelFormatEnumToMasks(SDL_PIXELFORMAT_ARGB8888, &bpp, &rMask, &gMask, &bMask, &aMask);
+
+    bool fResult = true;
+    for (int page = 0; fResult && (page < _cPages); page++)
+    {
+        // New surfaces are zero filled, so the padding and any unused space is transparent
+        SDL_Surface *pPageSurface = SDL_CreateRGBSurface(0, _pcxPages[page], _pcyPages[page], bpp, rMask, gMask, bMask, aMask);
+        if (pPageSurface == nullptr)
+        {
+            printf("SDL_CreateRGBSurface() failed, error = %s\n", SDL_GetError());
+            fResult = false;
+            break;
+        }
+
+        for (int i = 0; i < _cImages; i++)
+        {
+            if (_pImages[i].page == page)
+            {
+                // Straight copy, alpha included
+                SDL_Rect targetRect = _pImages[i].rect;
+                SDL_SetSurfaceBlendMode(_pImages[i].pSurface, SDL_BLENDMODE_NONE);
+                SDL_BlitSurface(_pImages[i].pSurface, nullptr, pPageSurface, &targetRect);
+            }
+        }
+
+        SDL_Texture *pTexture = SDL_CreateTextureFromSurface(pSDLRenderer, pPageSurface);
+        SDL_FreeSurface(pPageSurface);
+        if (pTexture == nullptr)
+        {
+            printf("SDL_CreateTextureFromSurface() failed, error = %s\n", SDL_GetError());
+            fResult = false;
+            break;
+        }
+        SDL_SetTextureBlendMode(pTexture, SDL_BLENDMODE_BLEND);
+
+        char szPageName[32];
+        SDL_snprintf(szPageName, sizeof(szPageName), "atlas page %d", page);
+        _ppPages[page] = new TextureWrapper(pTexture, szPageName);
+    }
+
+    for (int i = 0; i < _cImages; i++)
+    {
+        SDL_FreeSurface(_pImages[i].pSurface);
+        _pImages[i].pSurface = nullptr;
+    }
+    return fResult;
+}
@@ -0,0 +1,231 @@
+#include "include/texturecache.h"
+#include <stdio.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+TextureCache::TextureCache(SDL_Renderer *pSDLRenderer, Uint64 cbBudget, Uint32 cMaxEntries) :
+    _pSDLRenderer(pSDLRenderer),
+    _cbBudget(cbBudget),
+    _cMaxEntries(cMaxEntries),
+    _pEntries(nullptr),
+    _useCounter(0)
+{
+    SDL_memset(&_stats, 0, sizeof(TextureCacheStats));
+    _pEntries = new CacheEntry[_cMaxEntries]{};
+}
+
+TextureCache::~TextureCache()
+{
+    for (Uint32 i = 0; i < _cMaxEntries; i++)
+    {
+        if (_pEntries[i].pszFileName != nullptr)
+        {
+            // Anything still referenced now is a leak in the caller, the texture goes anyway
+            if (_pEntries[i].cRefs > 0)
+            {
+                printf("TextureCache : %s still has %u reference(s)\n", _pEntries[i].pszFileName, _pEntries[i].cRefs);
+            }
+            FreeEntry(i);
+        }
+    }
+    delete[] _pEntries;
+}
+
+TextureWrapper* TextureCache::Acquire(const char *szFileName, SDL_Color *pSdlTransparencyColorKey)
+{
+    Uint32 index = FindEntry(szFileName, pSdlTransparencyColorKey);
+    if (index < _cMaxEntries)
+    {
+        return AddReference(index);
+    }
+
+    _stats.cMisses++;
+    TextureWrapper *pTextureWrapper = new TextureWrapper(szFileName, SDL_strlen(szFileName), _pSDLRenderer, pSdlTransparencyColorKey);
+    if (pTextureWrapper->IsNull())
+    {
+        delete pTextureWrapper;
+        return nullptr;
+    }
+    return Insert(szFileName, pSdlTransparencyColorKey, pTextureWrapper);
+}
+
+TextureWrapper* TextureCache::Adopt(const char *szFileName, SDL_Color *pSdlTransparencyColorKey, TextureWrapper *pTextureWrapper)
+{
+    Uint32 index = FindEntry(szFileName, pSdlTransparencyColorKey);
+    if (index < _cMaxEntries)
+    {
+        // Someone beat us to it, keep the one we have
+        delete pTextureWrapper;
+        return AddReference(index);
+    }
+
+    _stats.cMisses++;
+    return Insert(szFileName, pSdlTransparencyColorKey, pTextureWrapper);
+}
+
+TextureWrapper* TextureCache::AddReference(Uint32 index)
+{
+    CacheEntry &entry = _pEntries[index];
+    if (entry.cRefs++ == 0)
+    {
+        _stats.cReferenced++;
+    }
+    entry.lastUsed = ++_useCounter;
+    _stats.cHits++;
+    return entry.pTextureWrapper;
+}
+
+// Put a newly loaded texture in a free entry with one reference
+TextureWrapper* TextureCache::Insert(const char *szFileName, SDL_Color *pSdlTransparencyColorKey, TextureWrapper *pTextureWrapper)
+{
+    Uint32 format = 0;
+    SDL_QueryTexture(pTextureWrapper->Ptr(), &format, nullptr, nullptr, nullptr);
+    Uint64 cbTexture = static_cast<Uint64>(pTextureWrapper->Width()) * pTextureWrapper->Height() * SDL_max(SDL_BYTESPERPIXEL(format), 1);
+
+    // Make room for it first, and if every entry is taken reuse the least recently used unreferenced one
+    EvictDownTo((_cbBudget > cbTexture) ? (_cbBudget - cbTexture) : 0);
+    Uint32 index = 0;
+    for (; (index < _cMaxEntries) && (_pEntries[index].pszFileName != nullptr); index++)
+    {
+    }
+    if ((index == _cMaxEntries) && EvictOldest())
+    {
+        for (index = 0; (index < _cMaxEntries) && (_pEntries[index].pszFileName != nullptr); index++)
+        {
+        }
+    }
+    if (index == _cMaxEntries)
+    {
+        printf("TextureCache : no free entries for %s, max is %u\n", szFileName, _cMaxEntries);
+        delete pTextureWrapper;
+        return nullptr;
+    }
+
+    CacheEntry &entry = _pEntries[index];
+    size_t cchFileName = SDL_strlen(szFileName) + 1;
+    entry.pszFileName = new char[cchFileName];
+    SDL_memcpy(entry.pszFileName, szFileName, cchFileName);
+    entry.fColorKey = (pSdlTransparencyColorKey != nullptr) ? SDL_TRUE : SDL_FALSE;
+    entry.colorKey = (pSdlTransparencyColorKey != nullptr) ? *pSdlTransparencyColorKey : SDL_Color{ 0, 0, 0, 0 };
+    entry.pTextureWrapper = pTextureWrapper;
+    entry.cRefs = 1;
+    entry.lastUsed = ++_useCounter;
+    entry.cbTexture = cbTexture;
+
+    _stats.cEntries++;
+    _stats.cReferenced++;
+    _stats.cbResident += cbTexture;
+    return pTextureWrapper;
+}
+
+void TextureCache::Release(TextureWrapper *pTextureWrapper)
+{
+    Uint32 index = FindEntry(pTextureWrapper);
+    if ((index == _cMaxEntries) || (_pEntries[index].cRefs == 0))
+    {
+        printf("TextureCache::Release() : texture was not acquired from this cache\n");
+        SDL_assert(false);
+        return;
+    }
+
+    CacheEntry &entry = _pEntries[index];
+    entry.lastUsed = ++_useCounter;
+    if (--entry.cRefs == 0)
+    {
+        _stats.cReferenced--;
+        // It can go now if it was only kept because it was in use
+        EvictDownTo(_cbBudget);
+    }
+}
+
+void TextureCache::SetBudget(Uint64 cbBudget)
+{
+    _cbBudget = cbBudget;
+    EvictDownTo(_cbBudget);
+}
+
+void TextureCache::Purge()
+{
+    EvictDownTo(0);
+}
+
+void TextureCache::PrintStats()
+{
+    Uint32 cAcquires = _stats.cHits + _stats.cMisses;
+    printf("Texture cache: %u hits, %u misses (%.0f%% hit rate), %u evictions, %u textures (%u referenced), %.1f KB resident of %.1f KB budget\n",
+        _stats.cHits, _stats.cMisses, (cAcquires > 0) ? (100.0 * _stats.cHits) / cAcquires : 0.0, _stats.cEvictions,
+        _stats.cEntries, _stats.cReferenced, _stats.cbResident / 1024.0, _cbBudget / 1024.0);
+}
+
+// The key is the file name plus the color key (or lack of one), the same file keyed differently is a different texture
+Uint32 TextureCache::FindEntry(const char *szFileName, SDL_Color *pSdlTransparencyColorKey)
+{
+    SDL_bool fColorKey = (pSdlTransparencyColorKey != nullptr) ? SDL_TRUE : SDL_FALSE;
+    for (Uint32 i = 0; i < _cMaxEntries; i++)
+    {
+        const CacheEntry &entry = _pEntries[i];
+        if ((entry.pszFileName != nullptr) && (entry.fColorKey == fColorKey) && (SDL_strcmp(entry.pszFileName, szFileName) == 0) &&
+            ((fColorKey == SDL_FALSE) ||
+             ((entry.colorKey.r == pSdlTransparencyColorKey->r) && (entry.colorKey.g == pSdlTransparencyColorKey->g) && (entry.colorKey.b == pSdlTransparencyColorKey->b))))
+        {
+            return i;
+        }
+    }
+    return _cMaxEntries;
+}
+
+Uint32 TextureCache::FindEntry(TextureWrapper *pTextureWrapper)
+{
+    for (Uint32 i = 0; i < _cMaxEntries; i++)
+    {
+        if ((_pEntries[i].pszFileName != nullptr) && (_pEntries[i].pTextureWrapper == pTextureWrapper))
+        {
+            return i;
+        }
+    }
+    return _cMaxEntries;
+}
+
+void TextureCache::EvictDownTo(Uint64 cbTarget)
+{
+    // Stops early if everything left is in use
+    while ((_stats.cbResident > cbTarget) && EvictOldest())
+    {
+    }
+}
+
+bool TextureCache::EvictOldest()
+{
+    Uint32 oldest = _cMaxEntries;
+    for (Uint32 i = 0; i < _cMaxEntries; i++)
+    {
+        if ((_pEntries[i].pszFileName != nullptr) && (_pEntries[i].cRefs == 0) &&
+            ((oldest == _cMaxEntries) || (_pEntries[i].lastUsed < _pEntries[oldest].lastUsed)))
+        {
+            oldest = i;
+        }
+    }
+
+    if (oldest == _cMaxEntries)
+    {
+        return false;
+    }
+    FreeEntry(oldest);
+    _stats.cEvictions++;
+    return true;
+}
+
+void TextureCache::FreeEntry(Uint32 index)
+{
+    CacheEntry &entry = _pEntries[index];
+    _stats.cEntries--;
+    _stats.cbResident -= entry.cbTexture;
+    if (entry.cRefs > 0)
+    {
+        _stats.cReferenced--;
+    }
+
+    delete entry.pTextureWrapper;
+    delete[] entry.pszFileName;
+    SDL_memset(&entry, 0, sizeof(CacheEntry));
+}
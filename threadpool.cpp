@@ -0,0 +1,210 @@
+#include "include/threadpool.h"
+#include <stdio.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+ThreadPool::ThreadPool(Uint32 cWorkers, Uint32 cMaxQueuedTasks) :
+    _cWorkers(0),
+    _ppWorkers(nullptr),
+    _pWorkerStarts(nullptr),
+    _cQueues(cWorkers + 1),
+    _cMaxQueuedTasks(cMaxQueuedTasks),
+    _pQueues(nullptr),
+    _fQuit(false),
+    _pMutex(nullptr),
+    _pWorkQueued(nullptr),
+    _pDone(nullptr)
+{
+    SDL_AtomicSet(&_cQueued, 0);
+    SDL_AtomicSet(&_cRemaining, 0);
+    SDL_AtomicSet(&_cTasksRun, 0);
+    SDL_AtomicSet(&_cSteals, 0);
+
+    _pQueues = new TaskQueue[_cQueues]{};
+    for (Uint32 i = 0; i < _cQueues; i++)
+    {
+        _pQueues[i].pTasks = new Task[_cMaxQueuedTasks];
+    }
+    _pMutex = SDL_CreateMutex();
+    _pWorkQueued = SDL_CreateCond();
+    _pDone = SDL_CreateSemaphore(0);
+
+    // A worker that fails to start just leaves its queue to be stolen from
+    _ppWorkers = new SDL_Thread*[cWorkers]{};
+    _pWorkerStarts = new WorkerStart[cWorkers]{};
+    for (Uint32 i = 0; i < cWorkers; i++)
+    {
+        char szName[32];
+        SDL_snprintf(szName, sizeof(szName), "ThreadPool%u", i);
+        _pWorkerStarts[i] = { this, i };
+        _ppWorkers[_cWorkers] = SDL_CreateThread(WorkerThread, szName, &_pWorkerStarts[i]);
+        if (_ppWorkers[_cWorkers] == nullptr)
+        {
+            printf("SDL_CreateThread() failed, error = %s\n", SDL_GetError());
+            continue;
+        }
+        _cWorkers++;
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    SDL_LockMutex(_pMutex);
+    _fQuit = true;
+    SDL_CondBroadcast(_pWorkQueued);
+    SDL_UnlockMutex(_pMutex);
+
+    for (Uint32 i = 0; i < _cWorkers; i++)
+    {
+        SDL_WaitThread(_ppWorkers[i], nullptr);
+    }
+
+    SDL_DestroySemaphore(_pDone);
+    SDL_DestroyCond(_pWorkQueued);
+    SDL_DestroyMutex(_pMutex);
+    for (Uint32 i = 0; i < _cQueues; i++)
+    {
+        delete[] _pQueues[i].pTasks;
+    }
+    delete[] _pQueues;
+    delete[] _pWorkerStarts;
+    delete[] _ppWorkers;
+}
+
+void ThreadPool::ParallelFor(Uint32 cTasks, ThreadPoolTask pfnTask, void *pContext)
+{
+    if (cTasks == 0)
+    {
+        return;
+    }
+    if (cTasks == 1)
+    {
+        // Not worth waking anyone for
+        pfnTask(pContext, 0);
+        SDL_AtomicIncRef(&_cTasksRun);
+        return;
+    }
+    SDL_AtomicSet(&_cRemaining, cTasks);
+
+    // Deal the tasks out one queue at a time, so each lock is only taken once
+    Uint32 cQueued = 0;
+    for (Uint32 iQueue = 0; iQueue < _cQueues; iQueue++)
+    {
+        TaskQueue &queue = _pQueues[iQueue];
+        SDL_AtomicLock(&queue.lock);
+        Uint32 index = iQueue;
+        for (; (index < cTasks) && (queue.cTasks < _cMaxQueuedTasks); index += _cQueues)
+        {
+            queue.pTasks[(queue.iHead + queue.cTasks) % _cMaxQueuedTasks] = { pfnTask, pContext, index };
+            queue.cTasks++;
+            cQueued++;
+        }
+        SDL_AtomicUnlock(&queue.lock);
+
+        // Full, the rest of this queue's share is ours
+        for (; index < cTasks; index += _cQueues)
+        {
+            RunTask({ pfnTask, pContext, index });
+        }
+    }
+
+    if (cQueued > 0)
+    {
+        SDL_AtomicAdd(&_cQueued, cQueued);
+        SDL_LockMutex(_pMutex);
+        SDL_CondBroadcast(_pWorkQueued);
+        SDL_UnlockMutex(_pMutex);
+    }
+
+    // Help out until there's nothing left to take, then wait for whatever is still running elsewhere.  Whoever
+    // finishes the last task posts _pDone, so this always waits exactly once
+    Task task;
+    while (NextTask(_cQueues - 1, task))
+    {
+        RunTask(task);
+    }
+    SDL_SemWait(_pDone);
+}
+
+ThreadPoolStats ThreadPool::Stats()
+{
+    return { static_cast<Uint32>(SDL_AtomicGet(&_cTasksRun)), static_cast<Uint32>(SDL_AtomicGet(&_cSteals)) };
+}
+
+int ThreadPool::WorkerThread(void *pData)
+{
+    WorkerStart *pWorkerStart = static_cast<WorkerStart*>(pData);
+    pWorkerStart->pThreadPool->WorkerLoop(pWorkerStart->iQueue);
+    return 0;
+}
+
+void ThreadPool::WorkerLoop(Uint32 iQueue)
+{
+    for (;;)
+    {
+        Task task;
+        if (NextTask(iQueue, task))
+        {
+            RunTask(task);
+            continue;
+        }
+
+        // _cQueued is raised before the broadcast (under the mutex), so checking it under the mutex can't miss one
+        SDL_LockMutex(_pMutex);
+        while (!_fQuit && (SDL_AtomicGet(&_cQueued) == 0))
+        {
+            SDL_CondWait(_pWorkQueued, _pMutex);
+        }
+        bool fQuit = _fQuit;
+        SDL_UnlockMutex(_pMutex);
+        if (fQuit)
+        {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::NextTask(Uint32 iQueue, Task &task)
+{
+    // Our own queue first, newest task first (it's the one most likely to still be in cache)
+    TaskQueue &ownQueue = _pQueues[iQueue];
+    SDL_AtomicLock(&ownQueue.lock);
+    if (ownQueue.cTasks > 0)
+    {
+        ownQueue.cTasks--;
+        task = ownQueue.pTasks[(ownQueue.iHead + ownQueue.cTasks) % _cMaxQueuedTasks];
+        SDL_AtomicUnlock(&ownQueue.lock);
+        SDL_AtomicAdd(&_cQueued, -1);
+        return true;
+    }
+    SDL_AtomicUnlock(&ownQueue.lock);
+
+    // Then the oldest task of whoever has one, starting with our neighbor so thieves spread out
+    for (Uint32 i = 1; i < _cQueues; i++)
+    {
+        TaskQueue &queue = _pQueues[(iQueue + i) % _cQueues];
+        SDL_AtomicLock(&queue.lock);
+        if (queue.cTasks > 0)
+        {
+            task = queue.pTasks[queue.iHead];
+            queue.iHead = (queue.iHead + 1) % _cMaxQueuedTasks;
+            queue.cTasks--;
+            SDL_AtomicUnlock(&queue.lock);
+            SDL_AtomicAdd(&_cQueued, -1);
+            SDL_AtomicIncRef(&_cSteals);
+            return true;
+        }
+        SDL_AtomicUnlock(&queue.lock);
+    }
+    return false;
+}
+
+void ThreadPool::RunTask(const Task &task)
+{
+    task.pfnTask(task.pContext, task.index);
+    SDL_AtomicIncRef(&_cTasksRun);
+    if (SDL_AtomicDecRef(&_cRemaining))
+    {
+        SDL_SemPost(_pDone);
+    }
+}
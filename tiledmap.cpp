@@ -1,26 +1,40 @@
 #include "include/tiledmap.h"
+#include <stdio.h>
 
 using namespace XplatGameTutorial::PacManClone;
 
-// The main goals here are to 
-// 1) Divide up the texture into src rects
-// 2) Copy the index data
-// 3) Cache some calculated values we'll reuse rendering
+// The map data is the caller's array, chunks are copied out of it as they're needed
 bool TiledMap::Initialize(
-    SDL_Rect textureRect,           // Size of the texture
+    SDL_Rect textureRect,           // Area of the texture holding the tiles
     SDL_Rect tileRect,              // size of the tile - the texture should be a multiple of this size...
     SDL_Texture *pTexture,          // texture holding the tiles
-    Uint16 *pMapIndices,            // array of indicies to the tiles, should match in size to map
-    Uint16 countOfIndicies)         // again should match, but here to be explicit in the code
+    const Uint16 *pMapIndices,      // array of indicies to the tiles, should match in size to map
+    Uint32 countOfIndicies)         // again should match, but here to be explicit in the code
+{
+    SDL_assert(countOfIndicies == (static_cast<Uint32>(_cRows) * _cCols));
+    _pMapIndicies = pMapIndices;
+    return Initialize(textureRect, tileRect, pTexture, ArraySource, this);
+}
+
+bool TiledMap::Initialize(SDL_Rect textureRect, SDL_Rect tileRect, SDL_Texture *pTexture, TiledMapChunkSource pfnSource, void *pContext)
+{
+    _pfnSource = pfnSource;
+    _pSourceContext = pContext;
+
+    // Every chunk could end up resident (modified ones are never dropped)
+    _pResidentChunks = _pLevelArena->AllocateArray<Uint32>(_cChunkRows * _cChunkCols);
+    _cResidentChunks = 0;
+    return InitializeTiles(textureRect, tileRect, pTexture);
+}
+
+// The main goals here are to
+// 1) Divide up the texture into src rects
+// 2) Cache some calculated values we'll reuse rendering
+bool TiledMap::InitializeTiles(SDL_Rect textureRect, SDL_Rect tileRect, SDL_Texture *pTexture)
 {
     // Validate some assumptions
     SDL_assert((textureRect.w % tileRect.w) == 0);
     SDL_assert((textureRect.h % tileRect.h) == 0);
-    SDL_assert(countOfIndicies == (_cRows * _cCols));
-
-    // Copy the map indicies data
-    _pMapIndicies = new Uint16[countOfIndicies] { };
-    SDL_memcpy(_pMapIndicies, pMapIndices, countOfIndicies * sizeof(Uint16));
 
     // Copy the texture data
     _pTileTexture = pTexture;
@@ -29,53 +43,334 @@ bool TiledMap::Initialize(
     // Calculate the total available tiles on the texture and allocate space for the source rects
     // this is all just dividing the coordinate space into even squares
     _tileSize = tileRect.w;         // Pick either, we assuming they are the same so far
+    SDL_assert((_tileSize > 0) && ((_tileSize & (_tileSize - 1)) == 0));
+    _tileShift = 0;
+    while ((1 << _tileShift) < _tileSize)
+    {
+        _tileShift++;
+    }
     Uint16 textureTilesPerWidth  = (_textureRect.w / _tileSize);    // The texture itself does not need to be square
     Uint16 textureTilesPerHeight = (_textureRect.h / _tileSize);
     _cTilesOnTexture = ((_textureRect.w / _tileSize) * textureTilesPerHeight);
-    _pTileRects = new SDL_Rect[_cTilesOnTexture] {};
+    _pTileRects = _pLevelArena->AllocateArray<SDL_Rect>(_cTilesOnTexture);
 
-    // Center the map, so calculate the offsets
+    // Center the map if it fits on the screen, otherwise it starts at the world origin and the camera scrolls over it
     _cxWidth = (_cCols * _tileSize);
     _cyHeight = (_cRows * _tileSize);
-    _cxOffset = (_cxScreen - _cxWidth) / 2;
-    _cyOffset = (_cyScreen - _cyHeight) / 2;
+    _cxOffset = SDL_max(0, (_cxScreen - _cxWidth) / 2);
+    _cyOffset = SDL_max(0, (_cyScreen - _cyHeight) / 2);
+    SetCamera(0, 0);
 
-    // Loop through the tiles and set the source rects
+    // Loop through the tiles and set the source rects.  The tiles don't have to start at the texture's origin
+    // (e.g. they are packed into an atlas), textureRect says where they are
     for (int r = 0; r < textureTilesPerHeight; r++)
     {
         for (int c = 0; c < textureTilesPerWidth; c++)
         {
-            _pTileRects[((r * textureTilesPerHeight) + c)].h = _tileSize;
-            _pTileRects[((r * textureTilesPerHeight) + c)].w = _tileSize;
-            _pTileRects[((r * textureTilesPerHeight) + c)].x = _tileSize * c;
-            _pTileRects[((r * textureTilesPerHeight) + c)].y = _tileSize * r;
+            _pTileRects[((r * textureTilesPerWidth) + c)].h = _tileSize;
+            _pTileRects[((r * textureTilesPerWidth) + c)].w = _tileSize;
+            _pTileRects[((r * textureTilesPerWidth) + c)].x = _textureRect.x + (_tileSize * c);
+            _pTileRects[((r * textureTilesPerWidth) + c)].y = _textureRect.y + (_tileSize * r);
         }
     }
     return true;
 }
 
-// Loop through the map of indicies and render each tile in order.  Center the map on the screen
-void TiledMap::Render(SDL_Renderer *pSDLRenderer)
+bool TiledMap::ArraySource(void *pContext, Uint16 row, Uint16 col, Uint16 cRows, Uint16 cCols, Uint16 *pIndicies, Uint16 pitch)
+{
+    TiledMap *pTiledMap = static_cast<TiledMap*>(pContext);
+    for (Uint16 r = 0; r < cRows; r++)
+    {
+        SDL_memcpy(&pIndicies[r * pitch], &pTiledMap->_pMapIndicies[((row + r) * pTiledMap->_cCols) + col], cCols * sizeof(Uint16));
+    }
+    return true;
+}
+
+// Queue the chunks overlapping the camera, baking any changes first.  If the renderer can't give us a target
+// texture we fall back to queuing the visible tiles each frame (which the batch still draws in one go)
+void TiledMap::Render(SDL_Renderer *pSDLRenderer, RenderBatch *pRenderBatch, Uint16 layer)
 {
-    SDL_assert(_cRows * _pTileRects[0].w <= _cxScreen); // Every tile is the same size in this implementation
-    SDL_assert(_cCols * _pTileRects[0].h <= _cyScreen);
+    _frame++;
+
+    SDL_Rect cameraRect = { _camera.x, _camera.y, _cxScreen, _cyScreen };
+    SDL_Rect mapRect = GetMapBounds();
+    SDL_Rect viewRect;
+    if (SDL_IntersectRect(&cameraRect, &mapRect, &viewRect) == SDL_FALSE)
+    {
+        return;
+    }
+
+    int cxChunk = c_chunkSize * _tileSize;
+    Uint16 chunkColFirst = (viewRect.x - _cxOffset) / cxChunk;
+    Uint16 chunkColLast = ((viewRect.x + viewRect.w - 1) - _cxOffset) / cxChunk;
+    Uint16 chunkRowFirst = (viewRect.y - _cyOffset) / cxChunk;
+    Uint16 chunkRowLast = ((viewRect.y + viewRect.h - 1) - _cyOffset) / cxChunk;
 
-    SDL_Rect targetRect = {0, 0, _tileSize, _tileSize }; // The size won't change, so we'll update the x, y
-    for (int r = 0; r < _cRows; r++)
+    for (Uint16 chunkRow = chunkRowFirst; chunkRow <= chunkRowLast; chunkRow++)
     {
-        for (int c = 0; c < _cCols; c++) 
+        for (Uint16 chunkCol = chunkColFirst; chunkCol <= chunkColLast; chunkCol++)
         {
-            targetRect.x = (c * _tileSize) + _cxOffset;
-            targetRect.y = (r * _tileSize) + _cyOffset;
-            int currentTileIndex = _pMapIndicies[r * _cCols + c];
-
-            SDL_RenderCopy(
-                pSDLRenderer,                   // Our renderer - everything goes here that draws
-                _pTileTexture,                  // texture that holds the source tiles
-                &_pTileRects[currentTileIndex], // rect in our map indicies list that tells us which tile to draw
-                &targetRect);                   // dest rect on the screen for the tile indexed above
+            if (!LoadChunk(chunkRow, chunkCol))
+            {
+                continue;
+            }
+
+            Chunk &chunk = _pChunks[(chunkRow * _cChunkCols) + chunkCol];
+            chunk.lastSeenFrame = _frame;
+
+            if ((chunk.pCacheTexture == nullptr) && !CreateCache(pSDLRenderer, chunk, chunkRow, chunkCol))
+            {
+                RenderTiles(pRenderBatch, chunk, chunkRow, chunkCol, viewRect, layer);
+                continue;
+            }
+
+            if ((chunk.fCacheDirty == SDL_TRUE) || (chunk.cDirtyCells > 0))
+            {
+                BakeCache(pSDLRenderer, chunk, chunkRow, chunkCol);
+            }
+
+            SDL_Rect sourceRect = { 0, 0, ChunkCols(chunkCol) * _tileSize, ChunkRows(chunkRow) * _tileSize };
+            SDL_Rect targetRect = { _cxOffset + (chunkCol * cxChunk), _cyOffset + (chunkRow * cxChunk), sourceRect.w, sourceRect.h };
+            pRenderBatch->AddQuad(chunk.pCacheTexture, sourceRect, targetRect, layer);
         }
     }
+
+    TrimChunks();
+}
+
+// Queue the chunk's tiles that overlap viewRect, one quad each
+void TiledMap::RenderTiles(RenderBatch *pRenderBatch, const Chunk &chunk, Uint16 chunkRow, Uint16 chunkCol, const SDL_Rect &viewRect, Uint16 layer)
+{
+    int xChunk = _cxOffset + (chunkCol * c_chunkSize * _tileSize);
+    int yChunk = _cyOffset + (chunkRow * c_chunkSize * _tileSize);
+    int colFirst = SDL_max(0, (viewRect.x - xChunk) / _tileSize);
+    int colLast = SDL_min(ChunkCols(chunkCol) - 1, ((viewRect.x + viewRect.w - 1) - xChunk) / _tileSize);
+    int rowFirst = SDL_max(0, (viewRect.y - yChunk) / _tileSize);
+    int rowLast = SDL_min(ChunkRows(chunkRow) - 1, ((viewRect.y + viewRect.h - 1) - yChunk) / _tileSize);
+
+    SDL_Rect targetRect = { 0, 0, _tileSize, _tileSize };
+    for (int r = rowFirst; r <= rowLast; r++)
+    {
+        for (int c = colFirst; c <= colLast; c++)
+        {
+            targetRect.x = xChunk + (c * _tileSize);
+            targetRect.y = yChunk + (r * _tileSize);
+            pRenderBatch->AddQuad(_pTileTexture, _pTileRects[chunk.pCells->indicies[(r * c_chunkSize) + c]], targetRect, layer);
+        }
+    }
+}
+
+// Swap the tile at a single cell and queue it to be redrawn into its chunk's cache
+bool TiledMap::SetTile(Uint16 row, Uint16 col, Uint16 index)
+{
+    if ((row >= _cRows) || (col >= _cCols) || (index >= _cTilesOnTexture))
+    {
+        printf("TiledMap::SetTile() : out of range {row:%d col:%d index:%d}\n", row, col, index);
+        return false;
+    }
+
+    if (!LoadChunk(row / c_chunkSize, col / c_chunkSize))
+    {
+        return false;
+    }
+
+    Chunk &chunk = _pChunks[((row / c_chunkSize) * _cChunkCols) + (col / c_chunkSize)];
+    Uint16 cell = ((row % c_chunkSize) * c_chunkSize) + (col % c_chunkSize);
+    if (chunk.pCells->indicies[cell] != index)
+    {
+        chunk.pCells->indicies[cell] = index;
+        chunk.fModified = SDL_TRUE;
+
+        // No need to track it if the whole thing is being rebuilt anyway
+        if (chunk.fCacheDirty == SDL_FALSE)
+        {
+            chunk.pCells->dirtyCells[chunk.cDirtyCells++] = cell;
+            if (chunk.cDirtyCells == (c_chunkSize * c_chunkSize))
+            {
+                // Everything changed (or the same cells over and over), just rebuild it all
+                chunk.fCacheDirty = SDL_TRUE;
+                chunk.cDirtyCells = 0;
+            }
+        }
+    }
+    return true;
+}
+
+// A targets reset means the textures still exist but their contents are undefined, a device reset means
+// the textures themselves are gone and have to be created again
+void TiledMap::ResetCache(SDL_bool fTextureLost)
+{
+    for (Uint32 i = 0; i < _cResidentChunks; i++)
+    {
+        Chunk &chunk = _pChunks[_pResidentChunks[i]];
+        if ((fTextureLost == SDL_TRUE) && (chunk.pCacheTexture != nullptr))
+        {
+            SDL_DestroyTexture(chunk.pCacheTexture);
+            chunk.pCacheTexture = nullptr;
+        }
+        chunk.fCacheDirty = SDL_TRUE;
+        chunk.cDirtyCells = 0;
+    }
+}
+
+bool TiledMap::LoadChunk(Uint16 chunkRow, Uint16 chunkCol)
+{
+    Uint32 chunkIndex = (chunkRow * _cChunkCols) + chunkCol;
+    Chunk &chunk = _pChunks[chunkIndex];
+    if (chunk.pCells != nullptr)
+    {
+        return true;
+    }
+
+    // Comes back zeroed, like the tiles past the edge of a partial chunk should be
+    chunk.pCells = _chunkCells.Create();
+    if (chunk.pCells == nullptr)
+    {
+        printf("TiledMap::LoadChunk() : too many chunks loaded to load {row:%d col:%d}\n", chunkRow, chunkCol);
+        return false;
+    }
+    if (!_pfnSource(_pSourceContext, chunkRow * c_chunkSize, chunkCol * c_chunkSize, ChunkRows(chunkRow), ChunkCols(chunkCol), chunk.pCells->indicies, c_chunkSize))
+    {
+        printf("TiledMap::LoadChunk() : failed to load chunk {row:%d col:%d}\n", chunkRow, chunkCol);
+        _chunkCells.Destroy(chunk.pCells);
+        chunk.pCells = nullptr;
+        return false;
+    }
+
+    // The data may not be ours (a file, a generator), so don't let a bad index read past the tile rects
+    for (Uint32 i = 0; i < (c_chunkSize * c_chunkSize); i++)
+    {
+        if (chunk.pCells->indicies[i] >= _cTilesOnTexture)
+        {
+            printf("TiledMap::LoadChunk() : tile index %d out of range in chunk {row:%d col:%d}\n", chunk.pCells->indicies[i], chunkRow, chunkCol);
+            chunk.pCells->indicies[i] = 0;
+        }
+    }
+
+    chunk.cDirtyCells = 0;
+    chunk.fCacheDirty = SDL_TRUE;
+    chunk.fModified = SDL_FALSE;
+    chunk.lastSeenFrame = _frame;
+    _pResidentChunks[_cResidentChunks++] = chunkIndex;
+    return true;
+}
+
+void TiledMap::UnloadChunk(Chunk &chunk)
+{
+    _chunkCells.Destroy(chunk.pCells);
+    if (chunk.pCacheTexture != nullptr)
+    {
+        SDL_DestroyTexture(chunk.pCacheTexture);
+    }
+    SDL_memset(&chunk, 0, sizeof(Chunk));
+}
+
+// Drop the least recently seen chunks that can be loaded again as they were, anything seen this frame stays
+void TiledMap::TrimChunks()
+{
+    while (_cResidentChunks > c_maxResidentChunks)
+    {
+        Uint32 iOldest = _cResidentChunks;
+        for (Uint32 i = 0; i < _cResidentChunks; i++)
+        {
+            const Chunk &chunk = _pChunks[_pResidentChunks[i]];
+            if ((chunk.fModified == SDL_FALSE) && (chunk.lastSeenFrame != _frame) &&
+                ((iOldest == _cResidentChunks) || (chunk.lastSeenFrame < _pChunks[_pResidentChunks[iOldest]].lastSeenFrame)))
+            {
+                iOldest = i;
+            }
+        }
+        if (iOldest == _cResidentChunks)
+        {
+            break;
+        }
+
+        UnloadChunk(_pChunks[_pResidentChunks[iOldest]]);
+        _pResidentChunks[iOldest] = _pResidentChunks[--_cResidentChunks];
+    }
+}
+
+bool TiledMap::CreateCache(SDL_Renderer *pSDLRenderer, Chunk &chunk, Uint16 chunkRow, Uint16 chunkCol)
+{
+    if ((_fTargetsSupported == SDL_FALSE) || (SDL_RenderTargetSupported(pSDLRenderer) == SDL_FALSE))
+    {
+        _fTargetsSupported = SDL_FALSE;
+        return false;
+    }
+
+    chunk.pCacheTexture = SDL_CreateTexture(pSDLRenderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+        ChunkCols(chunkCol) * _tileSize, ChunkRows(chunkRow) * _tileSize);
+    if (chunk.pCacheTexture == nullptr)
+    {
+        printf("SDL_CreateTexture() failed, error = %s\n", SDL_GetError());
+        return false;
+    }
+
+    // The tiles are opaque, so skip blending when the cache is copied to the screen
+    SDL_SetTextureBlendMode(chunk.pCacheTexture, SDL_BLENDMODE_NONE);
+    chunk.fCacheDirty = SDL_TRUE;
+    _cCachesCreated++;
+    return true;
+}
+
+// Draws one cell straight into the chunk's cache (this is offscreen so it doesn't go through the frame's batch)
+void TiledMap::RenderTile(SDL_Renderer *pSDLRenderer, const Chunk &chunk, Uint16 row, Uint16 col)
+{
+    SDL_Rect targetRect = { col * _tileSize, row * _tileSize, _tileSize, _tileSize };
+    int currentTileIndex = chunk.pCells->indicies[row * c_chunkSize + col];
+
+    SDL_RenderCopy(
+        pSDLRenderer,                   // Our renderer - everything goes here that draws
+        _pTileTexture,                  // texture that holds the source tiles
+        &_pTileRects[currentTileIndex], // rect in our map indicies list that tells us which tile to draw
+        &targetRect);                   // dest rect on the cache for the tile indexed above
+}
+
+// Point the renderer at the chunk's cache, draw what changed and put the previous target back
+void TiledMap::BakeCache(SDL_Renderer *pSDLRenderer, Chunk &chunk, Uint16 chunkRow, Uint16 chunkCol)
+{
+    SDL_Texture *pPreviousTarget = SDL_GetRenderTarget(pSDLRenderer);
+    if (SDL_SetRenderTarget(pSDLRenderer, chunk.pCacheTexture) != 0)
+    {
+        printf("SDL_SetRenderTarget() failed, error = %s\n", SDL_GetError());
+        return;
+    }
+
+    if (chunk.fCacheDirty == SDL_TRUE)
+    {
+        Uint16 cRows = ChunkRows(chunkRow);
+        Uint16 cCols = ChunkCols(chunkCol);
+        for (int r = 0; r < cRows; r++)
+        {
+            for (int c = 0; c < cCols; c++)
+            {
+                RenderTile(pSDLRenderer, chunk, r, c);
+            }
+        }
+    }
+    else
+    {
+        for (int i = 0; i < chunk.cDirtyCells; i++)
+        {
+            RenderTile(pSDLRenderer, chunk, chunk.pCells->dirtyCells[i] / c_chunkSize, chunk.pCells->dirtyCells[i] % c_chunkSize);
+        }
+    }
+
+    chunk.fCacheDirty = SDL_FALSE;
+    chunk.cDirtyCells = 0;
+    SDL_SetRenderTarget(pSDLRenderer, pPreviousTarget);
+}
+
+// A map that fits on the screen is centered in it instead, so the camera stays at the origin on that axis
+void TiledMap::SetCamera(int x, int y)
+{
+    _camera.x = (_cxWidth > _cxScreen) ? SDL_max(0, SDL_min(x, _cxWidth - _cxScreen)) : 0;
+    _camera.y = (_cyHeight > _cyScreen) ? SDL_max(0, SDL_min(y, _cyHeight - _cyScreen)) : 0;
+}
+
+void TiledMap::CenterCamera(SDL_Point point)
+{
+    SetCamera(point.x - (_cxScreen / 2), point.y - (_cyScreen / 2));
 }
 
 // returns the "center" pixel of the tile in 2D space - this helps with the sprite logic
@@ -96,14 +391,34 @@ bool TiledMap::GetTileRowCol(SDL_Point &point, Uint16 &row, Uint16 &col)
     if (fResult)
     {
         // If so convert it
-        row = (point.y - _cyOffset) / _tileSize;
-        col = (point.x - _cxOffset) / _tileSize;
+        row = (point.y - _cyOffset) >> _tileShift;
+        col = (point.x - _cxOffset) >> _tileShift;
     }
     return fResult;
 }
 
+bool TiledMap::GetTileRowCol(Fixed x, Fixed y, Uint16 &row, Uint16 &col)
+{
+    // Arithmetic shifts, anything left of or above the map comes out negative
+    int tileRow = (y - FixedFromInt(_cyOffset)) >> (FixedShift + _tileShift);
+    int tileCol = (x - FixedFromInt(_cxOffset)) >> (FixedShift + _tileShift);
+    if ((tileRow < 0) || (tileRow >= _cRows) || (tileCol < 0) || (tileCol >= _cCols))
+    {
+        return false;
+    }
+    row = static_cast<Uint16>(tileRow);
+    col = static_cast<Uint16>(tileCol);
+    return true;
+}
+
+bool TiledMap::GetScreenTileRowCol(SDL_Point point, Uint16 &row, Uint16 &col)
+{
+    SDL_Point worldPoint = ScreenToWorld(point);
+    return GetTileRowCol(worldPoint, row, col);
+}
+
 // Return the bounding rect of the entire map
 SDL_Rect TiledMap::GetMapBounds()
 {
-    return{ (_cxScreen - (_cCols * _tileSize)) / 2, (_cyScreen - _cyHeight) / 2, (_cCols * _tileSize), (_cRows * _tileSize) };
+    return{ _cxOffset, _cyOffset, _cxWidth, _cyHeight };
 }
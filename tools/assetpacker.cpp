@@ -0,0 +1,155 @@
+// assetpacker.cpp : Offline tool that builds the asset pack (make pack)
+//
+// Decodes the images in grfx/ the same way the game would (LoadSurface: ARGB8888, color key turned into alpha) and
+// writes them, plus the map grids and animation tables from Constants, into a single file the game can map and use
+// with no decoding.  See assetpack.h for the layout
+#include <stdio.h>
+#include <vector>
+#include "SDL.h"
+#include "SDL_image.h"
+#include "assetpack.h"
+#include "constants.h"
+#include "utils.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+// Collects payloads and their index entries, then writes header, payloads and index in one go
+class AssetPackWriter
+{
+public:
+    bool AddImage(const char *szFileName, SDL_Color *pSdlTransparencyColorKey)
+    {
+        SDL_Surface *pSurface = LoadSurface(szFileName, pSdlTransparencyColorKey);
+        if (pSurface == nullptr)
+        {
+            return false;
+        }
+
+        // Rows are stored tightly packed no matter what pitch SDL gave us
+        Uint32 pitch = pSurface->w * 4;
+        AssetPackEntry &entry = AddEntry(szFileName, AssetPackEntryType::Image, pitch * pSurface->h);
+        entry.width = pSurface->w;
+        entry.height = pSurface->h;
+        entry.pitch = pitch;
+
+        SDL_LockSurface(pSurface);
+        for (int y = 0; y < pSurface->h; y++)
+        {
+            SDL_memcpy(&_data[entry.offset + (y * pitch)], static_cast<Uint8*>(pSurface->pixels) + (y * pSurface->pitch), pitch);
+        }
+        SDL_UnlockSurface(pSurface);
+        printf("  image %-28s %4u x %-4u %8u bytes\n", szFileName, entry.width, entry.height, entry.cbSize);
+        SDL_FreeSurface(pSurface);
+        return true;
+    }
+
+    void AddGrid(const char *szName, const Uint16 *pGrid, Uint32 cRows, Uint32 cCols)
+    {
+        AssetPackEntry &entry = AddEntry(szName, AssetPackEntryType::Grid16, cRows * cCols * sizeof(Uint16));
+        entry.width = cCols;
+        entry.height = cRows;
+        SDL_memcpy(&_data[entry.offset], pGrid, entry.cbSize);
+        printf("  grid  %-28s %4u x %-4u %8u bytes\n", szName, cRows, cCols, entry.cbSize);
+    }
+
+    void AddTable(const char *szName, const int *pTable, Uint32 cCount)
+    {
+        AssetPackEntry &entry = AddEntry(szName, AssetPackEntryType::Table32, cCount * sizeof(Sint32));
+        entry.width = cCount;
+        for (Uint32 i = 0; i < cCount; i++)
+        {
+            Sint32 value = pTable[i];
+            SDL_memcpy(&_data[entry.offset + (i * sizeof(Sint32))], &value, sizeof(Sint32));
+        }
+        printf("  table %-28s %4u        %8u bytes\n", szName, cCount, entry.cbSize);
+    }
+
+    bool Write(const char *szFileName)
+    {
+        // Index goes after the last payload, aligned so the entries can be read in place
+        Align();
+        AssetPackHeader header = { c_assetPackMagic, c_assetPackVersion, static_cast<Uint32>(_entries.size()), static_cast<Uint32>(_data.size()),
+            Constants::TablesVersion };
+        SDL_memcpy(&_data[0], &header, sizeof(header));
+
+        FILE *pFile = fopen(szFileName, "wb");
+        if (pFile == nullptr)
+        {
+            printf("Unable to open %s for writing\n", szFileName);
+            return false;
+        }
+        bool fResult = (fwrite(_data.data(), _data.size(), 1, pFile) == 1) &&
+            (fwrite(_entries.data(), sizeof(AssetPackEntry) * _entries.size(), 1, pFile) == 1);
+        fclose(pFile);
+
+        printf("Wrote %s, %u entries, %u bytes\n", szFileName, header.cEntries,
+            static_cast<Uint32>(_data.size() + sizeof(AssetPackEntry) * _entries.size()));
+        return fResult;
+    }
+
+    AssetPackWriter() : _data(sizeof(AssetPackHeader), 0) {}
+
+private:
+    // Payload space starting on an aligned offset, the entry is filled in by the caller
+    AssetPackEntry& AddEntry(const char *szName, AssetPackEntryType type, Uint32 cbSize)
+    {
+        SDL_assert(SDL_strlen(szName) < c_assetPackMaxName);
+        Align();
+
+        AssetPackEntry entry;
+        SDL_memset(&entry, 0, sizeof(entry));
+        SDL_strlcpy(entry.szName, szName, c_assetPackMaxName);
+        entry.type = type;
+        entry.offset = static_cast<Uint32>(_data.size());
+        entry.cbSize = cbSize;
+        _data.resize(_data.size() + cbSize, 0);
+        _entries.push_back(entry);
+        return _entries.back();
+    }
+
+    void Align()
+    {
+        _data.resize((_data.size() + c_assetPackAlignment - 1) & ~(c_assetPackAlignment - 1), 0);
+    }
+
+    std::vector<Uint8> _data;               // Header followed by the payloads
+    std::vector<AssetPackEntry> _entries;
+};
+
+// Usage: xplat-pmc-packer.exe [output file]
+int main(int argc, char* argv[])
+{
+#if SDL_BYTEORDER != SDL_LIL_ENDIAN
+    printf("Asset packs are little endian, this tool doesn't swap\n");
+    return 1;
+#endif
+    const char *szOutputFileName = (argc > 1) ? argv[1] : Constants::AssetPackFileName;
+
+    const int cFlagsNeeded = IMG_INIT_PNG;
+    if ((IMG_Init(cFlagsNeeded) & cFlagsNeeded) != cFlagsNeeded)
+    {
+        printf("IMG_Init() failed, error = %s\n", IMG_GetError());
+        return 1;
+    }
+
+    // Same files and color keys main.cpp loads
+    SDL_Color colorKey = Constants::SDLColorMagenta;
+    AssetPackWriter writer;
+    printf("Packing %s...\n", szOutputFileName);
+    bool fResult = writer.AddImage("./grfx/tiles.png", nullptr) && writer.AddImage("./grfx/spritesheet.png", &colorKey);
+
+    if (fResult)
+    {
+        writer.AddGrid("MapIndicies", Constants::MapIndicies, Constants::MapRows, Constants::MapCols);
+        writer.AddGrid("CollisionMap", Constants::CollisionMap, Constants::MapRows, Constants::MapCols);
+        writer.AddTable("PlayerAnimation_UP", Constants::PlayerAnimation_UP, Constants::PlayerAnimationFrameCount);
+        writer.AddTable("PlayerAnimation_DOWN", Constants::PlayerAnimation_DOWN, Constants::PlayerAnimationFrameCount);
+        writer.AddTable("PlayerAnimation_LEFT", Constants::PlayerAnimation_LEFT, Constants::PlayerAnimationFrameCount);
+        writer.AddTable("PlayerAnimation_RIGHT", Constants::PlayerAnimation_RIGHT, Constants::PlayerAnimationFrameCount);
+        writer.AddTable("PlayerAnimation_DEATH", Constants::PlayerAnimation_DEATH, Constants::PlayerAnimationDeathFrameCount);
+        fResult = writer.Write(szOutputFileName);
+    }
+
+    IMG_Quit();
+    return fResult ? 0 : 1;
+}
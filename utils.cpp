@@ -32,13 +32,60 @@ namespace PacManClone
         return pTextureOut;
     }
 
+    // Unlike LoadTexture the color key is baked into the alpha channel, so images with different keys (or none)
+    // can end up on the same texture
+    SDL_Surface* LoadSurface(const char *szFileName, SDL_Color *pSdlTransparencyColorKey)
+    {
+        SDL_Surface *pLoadedSurface = IMG_Load(szFileName);
+        if (pLoadedSurface == nullptr)
+        {
+            printf("IMG_Load() failed, error = %s\n", IMG_GetError());
+            return nullptr;
+        }
+
+        SDL_Surface *pSurface = SDL_ConvertSurfaceFormat(pLoadedSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+        SDL_FreeSurface(pLoadedSurface);
+        if (pSurface == nullptr)
+        {
+            printf("SDL_ConvertSurfaceFormat() failed, error = %s\n", SDL_GetError());
+            return nullptr;
+        }
+
+        if (pSdlTransparencyColorKey != nullptr)
+        {
+            Uint32 rgbMask = pSurface->format->Rmask | pSurface->format->Gmask | pSurface->format->Bmask;
+            Uint32 colorKey = SDL_MapRGB(pSurface->format, pSdlTransparencyColorKey->r, pSdlTransparencyColorKey->g, pSdlTransparencyColorKey->b) & rgbMask;
+
+            SDL_LockSurface(pSurface);
+            for (int y = 0; y < pSurface->h; y++)
+            {
+                Uint32 *pRow = reinterpret_cast<Uint32*>(static_cast<Uint8*>(pSurface->pixels) + (y * pSurface->pitch));
+                for (int x = 0; x < pSurface->w; x++)
+                {
+                    if ((pRow[x] & rgbMask) == colorKey)
+                    {
+                        pRow[x] = 0;
+                    }
+                }
+            }
+            SDL_UnlockSurface(pSurface);
+        }
+        return pSurface;
+    }
+
     // Setup SDL and our window
-    bool InitializeSDL(SDL_Window **ppSDLWindow, SDL_Renderer **ppSDLRenderer)
+    bool InitializeSDL(SDL_Window **ppSDLWindow, SDL_Renderer **ppSDLRenderer, bool fHeadless, bool fVsync)
     {
         bool fResult = true;
         *ppSDLWindow = nullptr;
         *ppSDLRenderer = nullptr;
 
+        if (fHeadless)
+        {
+            // Must be set before SDL_Init picks a video driver
+            SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+        }
+
         if (SDL_Init(SDL_INIT_VIDEO) < 0) // SDL_INIT_EVERYTHING works too, but we only need video...init what you need
         {
             printf("SDL_Init() failed, error = %s\n", SDL_GetError());
@@ -48,7 +95,7 @@ namespace PacManClone
         {
             // Creates the Window for the GUI
             *ppSDLWindow = SDL_CreateWindow(Constants::WindowTitle, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-                Constants::ScreenWidth, Constants::ScreenHeight, SDL_WINDOW_SHOWN);
+                Constants::ScreenWidth, Constants::ScreenHeight, fHeadless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN);
             if (*ppSDLWindow == nullptr)
             {
                 printf("SDL_CreateWindow() failed, error = %s\n", SDL_GetError());
@@ -58,7 +105,9 @@ namespace PacManClone
             {
                 // We now need a renderer to make use of textures, so create one based on the window and we'll use this to update what
                 // the user sees rather than drawing to the SDL_Surface like last time
-                *ppSDLRenderer = SDL_CreateRenderer(*ppSDLWindow, -1, SDL_RENDERER_ACCELERATED);
+                // Ask for vsync so presenting paces the frame rate, the simulation has its own fixed rate
+                *ppSDLRenderer = SDL_CreateRenderer(*ppSDLWindow, -1,
+                    fHeadless ? SDL_RENDERER_SOFTWARE : (SDL_RENDERER_ACCELERATED | (fVsync ? SDL_RENDERER_PRESENTVSYNC : 0)));
                 if (*ppSDLRenderer == nullptr)
                 {
                     printf("SDL_CreateRender() failed, error = %s\n", SDL_GetError());
@@ -93,10 +142,7 @@ namespace PacManClone
     // Instantiate our helper - load the texture, query basic info and cache it
     TextureWrapper::TextureWrapper(const char *szFileName, size_t cchFileName, SDL_Renderer *pSDLRenderer, SDL_Color *pSdlTransparencyColorKey) : TextureWrapper()
     {
-        size_t bytesToAllocate = cchFileName + 1;
-        _pszFilename = new char[bytesToAllocate];
-        SDL_memset(_pszFilename, 0, bytesToAllocate);
-        SDL_memcpy(_pszFilename, szFileName, bytesToAllocate);
+        SDL_strlcpy(_szName, szFileName, SDL_min(cchFileName + 1, sizeof(_szName)));
 
         printf("Attempting to load texture %s...\n", szFileName);
         _pTexture = LoadTexture(szFileName, pSDLRenderer, pSdlTransparencyColorKey);
@@ -113,15 +159,25 @@ namespace PacManClone
         }
     }
 
+    TextureWrapper::TextureWrapper(SDL_Texture *pTexture, const char *szName) : TextureWrapper()
+    {
+        SDL_strlcpy(_szName, szName, sizeof(_szName));
+
+        _pTexture = pTexture;
+        if (SDL_QueryTexture(_pTexture, nullptr, nullptr, &_cxTexture, &_cyTexture) != 0)
+        {
+            printf("SDL_QueryTexture() failed, error = %s\n", SDL_GetError());
+        }
+    }
+
     TextureWrapper::~TextureWrapper()
     {
         if (_pTexture != nullptr)
         {
-            printf("Destroying Texture %s\n", _pszFilename);
+            printf("Destroying Texture %s\n", _szName);
             SDL_DestroyTexture(_pTexture);
             _pTexture = nullptr;
         }
-        delete[] _pszFilename;
     }
 }
 }
\ No newline at end of file